@@ -0,0 +1,68 @@
+/*******************************************************************************
+ *
+ *	PIT library
+ *
+ *	Programmable Interval Timer (8253/8254) and the interrupt controller
+ *	acknowledgement needed by timer interrupt handlers.
+ *
+ *	Additional information provided by Roger Morgan
+ *	http://www.htl-steyr.ac.at/~morg/pcinfo/hardware/interrupts/inte1at0.htm
+ */
+
+#ifndef PIT_h
+#define PIT_h
+
+/*******************************************************************************
+ *
+ *	Programmable Interval Timer port map
+ *
+ ******************************************************************************/
+
+#define PIT_FREQUENCY			1193182	/* Input clock in Hz */
+#define PIT_BIOS_COUNT			0x10000	/* Count behind the 18.2 Hz BIOS tick */
+
+#define PIT_CHANNEL0			0x40	/* System timer, IRQ 0 */
+#define PIT_CHANNEL1			0x41	/* Memory refresh */
+#define PIT_CHANNEL2			0x42	/* PC speaker */
+#define PIT_COMMAND			0x43
+
+#define PIT_TIMER_INTERRUPT		0x08	/* Interrupt vector of IRQ 0 */
+
+/* Bit masks */
+
+#define PIT_BCD_BIT			0x01	/* -------1 */
+
+#define PIT_MODE_MASK			0x0E	/* 00001110 */
+#define PIT_MODE_0_BIT			0x00	/* ----000- Interrupt on terminal count */
+#define PIT_MODE_1_BIT			0x02	/* ----001- Hardware one shot */
+#define PIT_MODE_2_BIT			0x04	/* ----010- Rate generator */
+#define PIT_MODE_3_BIT			0x06	/* ----011- Square wave generator */
+#define PIT_MODE_4_BIT			0x08	/* ----100- Software strobe */
+#define PIT_MODE_5_BIT			0x0A	/* ----101- Hardware strobe */
+
+#define PIT_ACCESS_MASK			0x30	/* 00110000 */
+#define PIT_LATCH_BIT			0x00	/* --00---- */
+#define PIT_LOW_BYTE_BIT		0x10	/* --01---- */
+#define PIT_HIGH_BYTE_BIT		0x20	/* --10---- */
+#define PIT_LOW_HIGH_BIT		0x30	/* --11---- */
+
+#define PIT_CHANNEL_SELECT_MASK		0xC0	/* 11000000 */
+#define PIT_CHANNEL0_BIT		0x00	/* 00------ */
+#define PIT_CHANNEL1_BIT		0x40	/* 01------ */
+#define PIT_CHANNEL2_BIT		0x80	/* 10------ */
+#define PIT_READ_BACK_BIT		0xC0	/* 11------ */
+
+/*******************************************************************************
+ *
+ *	Programmable Interrupt Controller port map
+ *
+ ******************************************************************************/
+
+#define PIC1_COMMAND			0x20
+#define PIC1_DATA			0x21
+#define PIC2_COMMAND			0xA0
+#define PIC2_DATA			0xA1
+
+#define PIC_EOI				0x20	/* Non-specific end of interrupt */
+
+#endif /* PIT_h */
@@ -260,6 +260,8 @@ BOOL vbeGetModeInfo(VBEmodeInfo *pModeInfo, int mode)
  *		True if the display settings were successfully changed.
  */
 
+static unsigned long ModeSets = 0;
+
 BOOL vbeSetMode(int mode, VBEcrtcInfo *pCrtcInfo)
 {
 	__dpmi_regs regs;
@@ -274,11 +276,27 @@ BOOL vbeSetMode(int mode, VBEcrtcInfo *pCrtcInfo)
 		regs.x.di = far2off(__tb);
 	}
 	if(vbeFunction(VBE_SET_MODE, &regs))
+	{
+		ModeSets ++;
 		return TRUE;
+	}
 	else
 		return FALSE;
 }
 
+/*
+ * vbeGetModeSets
+ *
+ *	returns
+ *		The number of modes successfully set by 'vbeSetMode', so state
+ *		kept about the display can be found stale after a mode set.
+ */
+
+unsigned long vbeGetModeSets()
+{
+	return ModeSets;
+}
+
 /*
  * vbeGetMode
  *
@@ -834,8 +852,9 @@ int vbeGetPaletteDepth()
  *	int count
  *		The number of palette entries that will be written.
  *	void * palette
- *		An array in sets of 3 bytes for each 'count' representing RGB
- *		values. RGB value range is dependant on VBE_DAC_BITS.
+ *		An array in sets of 4 bytes for each 'count' holding blue, green,
+ *		red and an alignment byte. The value range is dependant on
+ *		VBE_DAC_BITS.
  *	returns
  *		True if the DAC was successfully written.
  */
@@ -843,7 +862,7 @@ BOOL vbeSetPalette(int index, int count, char palette[256][4])
 {
 	__dpmi_regs regs;
 	regs.h.bl = VBE_SET;
-	regs.x.cx = count * 4;
+	regs.x.cx = count;
 	regs.x.dx = index;
 	/* Write palette data to the transfer buffer */
 	dosmemput(palette[ index ], count * 4, __tb);
@@ -861,8 +880,9 @@ BOOL vbeSetPalette(int index, int count, char palette[256][4])
  *	int count
  *		The number of palette entries that will be read.
  *	void * palette
- *		An array in sets of 3 bytes for each 'count' representing RGB
- *		values. RGB value range is dependant on VBE_DAC_BITS.
+ *		An array in sets of 4 bytes for each 'count' holding blue, green,
+ *		red and an alignment byte. The value range is dependant on
+ *		VBE_DAC_BITS.
  *	returns
  *		True if the DAC was successfully read.
  */
@@ -870,7 +890,7 @@ BOOL vbeGetPalette(int index, int count, char palette[256][4])
 {
 	__dpmi_regs regs;
 	regs.h.bl = VBE_GET;
-	regs.x.cx = count * 4;
+	regs.x.cx = count;
 	regs.x.dx = index;
 	/* Initialize the buffer to zero */
 	farmemsetb(_dos_ds, __tb, count * 4, 0);
@@ -894,8 +914,9 @@ BOOL vbeGetPalette(int index, int count, char palette[256][4])
  *	int count
  *		The number of palette entries that will be written.
  *	void * palette
- *		An array in sets of 3 bytes for each 'count' representing RGB
- *		values. RGB value range is dependant on VBE_DAC_BITS.
+ *		An array in sets of 4 bytes for each 'count' holding blue, green,
+ *		red and an alignment byte. The value range is dependant on
+ *		VBE_DAC_BITS.
  *	returns
  *		True if the DAC was successfully written.
  */
@@ -903,7 +924,7 @@ BOOL vbeSetPaletteOnSync(int index, int count, char palette[256][4])
 {
 	__dpmi_regs regs;
 	regs.h.bl = VBE_SET_SYNC;
-	regs.x.cx = count * 4;
+	regs.x.cx = count;
 	regs.x.dx = index;
 	/* Write palette data to the transfer buffer */
 	dosmemput(palette[ index ], count * 4, __tb);
@@ -147,6 +147,8 @@
 /* VBEinfo.Capabilities */
 
 #define VBE_SWITCHABLE_DAC			0x01
+#define VBE_NON_VGA_CONTROLLER			0x02	/* DAC must be set through VBE_DAC_DATA */
+#define VBE_BLANK_RAMDAC			0x04	/* Set large palettes with the blank bit */
 
 /* VBEmodeInfo.ModeAttributes */
 
@@ -383,6 +385,8 @@ BOOL vbeGetModeInfo(VBEmodeInfo *info, int mode);
 
 BOOL vbeSetMode(int mode, VBEcrtcInfo *info);
 
+unsigned long vbeGetModeSets();
+
 /* VBE_GET_MODE */
 
 int vbeGetCurrentMode();
@@ -42,11 +42,27 @@ void vgaFunction(int function, __dpmi_regs *regs)
  *
  ******************************************************************************/
 
+static unsigned long ModeSets = 0;
+
 void vgaSetMode(int mode)
 {
 	__dpmi_regs regs;
 	regs.h.al = mode;
 	vgaFunction(VGA_SET_MODE, &regs);
+	ModeSets ++;
+}
+
+/*
+ * vgaGetModeSets
+ *
+ *	returns
+ *		The number of times 'vgaSetMode' was called, so state kept about
+ *		the display can be found stale after a mode set.
+ */
+
+unsigned long vgaGetModeSets()
+{
+	return ModeSets;
 }
 
 /*******************************************************************************
@@ -687,6 +703,23 @@ int vgaGetFontInfo(int font, void *buffer)
 	return regs.x.cx;
 }
 
+/*
+ * vgaGetFontAddress
+ *
+ *	Returns the linear address of the character definition table for a
+ *	font so the whole table can be copied. The bytes per character returned
+ *	by the BIOS belong to the font on screen, not the one requested, so the
+ *	caller must know the height of the font it asks for.
+ */
+
+long vgaGetFontAddress(int font)
+{
+	__dpmi_regs regs;
+	regs.h.bh = font;
+	vgaCharGenerator(VGA_GET_FONT_INFO, &regs);
+	return near3far(regs.x.es, regs.x.bp);
+}
+
 /*******************************************************************************
  *
  *	VGA_ALTERNATE_SELECT (12h)
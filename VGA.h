@@ -293,6 +293,8 @@ typedef enum
 
 void vgaSetMode(int mode);
 
+unsigned long vgaGetModeSets();
+
 void vgaSetCursorType(int start, int end);
 
 void vgaSetCursorPosition(int page, int row, int column);
@@ -357,6 +359,8 @@ void vgaLoadROMFont(int buffer, int font);
 
 int vgaGetFontInfo(int font, void *buffer);
 
+long vgaGetFontAddress(int font);
+
 // Alternate select functions
 
 int vgaGetInfo(VGAreturns result);
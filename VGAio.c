@@ -173,3 +173,346 @@ BOOL vgaQuerySequencerSetting(int bit)
 {
 	return vgaQuerySequencer(VGA_RESET) & bit;
 }
+
+/*******************************************************************************
+ *
+ *	Write
+ *
+ ******************************************************************************/
+
+void vgaWrite(int port, int index, int data, int value)
+{
+	outportb(port, index);
+	outportb(data, value);
+}
+
+void vgaWriteCRTC(int index, int value)
+{
+	vgaWrite(VGA_CRTC_ADDRESS, index, VGA_CRTC_DATA, value);
+}
+
+void vgaWriteSequencer(int index, int value)
+{
+	vgaWrite(VGA_SEQUENCER_ADDRESS, index, VGA_SEQUENCER_DATA, value);
+}
+
+void vgaWriteGraphics(int index, int value)
+{
+	vgaWrite(VGA_GRAPHICS_ADDRESS, index, VGA_GRAPHICS_DATA, value);
+}
+
+/*******************************************************************************
+ *
+ *	CRT Controller
+ *
+ ******************************************************************************/
+
+/*
+ * vgaSetStartAddress
+ *
+ *	Moves the display to start at the given address in display memory. The
+ *	address is counted in characters for text modes. The new value is
+ *	latched at the start of the next vertical retrace.
+ */
+
+void vgaSetStartAddress(int address)
+{
+	vgaWriteCRTC(VGA_START_ADDRESS_HIGH, (address >> 8) & VGA_START_ADDRESS_HIGH_BIT);
+	vgaWriteCRTC(VGA_START_ADDRESS_LOW,  address & VGA_START_ADDRESS_LOW_BIT);
+}
+
+/*
+ * vgaSetLineCompare
+ *
+ *	When the scan line counter reaches the given line the display address
+ *	counter is reset to zero, so the rest of the screen is shown from the
+ *	start of display memory. The value is ten bits wide, spread over three
+ *	registers. Setting all bits (3ffh) effectively disables the split.
+ */
+
+void vgaSetLineCompare(int line)
+{
+	int overflow = vgaQueryCRTC(VGA_OVERFLOW) & ~VGA_LINE_COMPARE_BIT_8;
+	int maximum  = vgaQueryCRTC(VGA_MAXIMUM_SCAN_LINE) & ~VGA_LINE_COMPARE_BIT_9;
+	if(line & 0x100) overflow |= VGA_LINE_COMPARE_BIT_8;
+	if(line & 0x200) maximum  |= VGA_LINE_COMPARE_BIT_9;
+	vgaWriteCRTC(VGA_LINE_COMPARE, line & VGA_LINE_COMPARE_BIT);
+	vgaWriteCRTC(VGA_OVERFLOW, overflow);
+	vgaWriteCRTC(VGA_MAXIMUM_SCAN_LINE, maximum);
+}
+
+/*
+ * vgaSetCursorLocation
+ *
+ *	Places the text cursor at the given character address in display
+ *	memory, independent of the BIOS notion of display pages.
+ */
+
+void vgaSetCursorLocation(int address)
+{
+	vgaWriteCRTC(VGA_CURSOR_LOCATION_HIGH, (address >> 8) & VGA_CURSOR_LOCATION_HIGH_BIT);
+	vgaWriteCRTC(VGA_CURSOR_LOCATION_LOW,  address & VGA_CURSOR_LOCATION_LOW_BIT);
+}
+
+/*
+ * vgaSetScanRepeat
+ *
+ *	Shows each line of display memory on the given number of scan lines,
+ *	1 to 32, through the maximum scan line field. Scan doubling is turned
+ *	off, so the repeat is exactly as given.
+ */
+
+void vgaSetScanRepeat(int repeat)
+{
+	int maximum = vgaQueryCRTC(VGA_MAXIMUM_SCAN_LINE) & ~(VGA_MAXIMUM_SCAN_LINE_BIT | VGA_SCAN_DOUBLING_BIT);
+	vgaWriteCRTC(VGA_MAXIMUM_SCAN_LINE, maximum | ((repeat - 1) & VGA_MAXIMUM_SCAN_LINE_BIT));
+}
+
+/*
+ * vgaGetScanRepeat
+ *
+ *	Returns the number of scan lines each line of display memory is shown
+ *	on, counting scan doubling.
+ */
+
+int vgaGetScanRepeat(void)
+{
+	int maximum = vgaQueryCRTC(VGA_MAXIMUM_SCAN_LINE);
+	int repeat = (maximum & VGA_MAXIMUM_SCAN_LINE_BIT) + 1;
+	return maximum & VGA_SCAN_DOUBLING_BIT ? repeat * 2 : repeat;
+}
+
+/*
+ * vgaHalveHorizontalTiming
+ *
+ *	Halves the horizontal total, display, blanking and retrace counts, to
+ *	go with halving the dot clock so the line rate stays the same. The
+ *	blanking and retrace ends keep their widths in time. The registers are
+ *	unprotected only while they are written.
+ */
+
+void vgaHalveHorizontalTiming(void)
+{
+	int protect    = vgaQueryCRTC(VGA_VERTICAL_RETRACE_END);
+	int total      = vgaQueryCRTC(VGA_HORIZONTAL_TOTAL);
+	int display    = vgaQueryCRTC(VGA_END_HORIZONTAL_DISPLAY);
+	int blank      = vgaQueryCRTC(VGA_START_HORIZONTAL_BLANKING);
+	int blankEnd   = vgaQueryCRTC(VGA_END_HORIZONTAL_BLANKING);
+	int retrace    = vgaQueryCRTC(VGA_START_HORIZONTAL_RETRACE);
+	int retraceEnd = vgaQueryCRTC(VGA_END_HORIZONTAL_RETRACE);
+	/* Blanking end is six bits compared with the character count, retrace end five */
+	int blankWidth   = (((blankEnd & VGA_END_HORIZONTAL_BLANKING_BIT) | (retraceEnd & VGA_END_HORIZONTAL_BLANKING_BIT_5 ? 0x20 : 0)) - blank) & 0x3F;
+	int retraceWidth = ((retraceEnd & VGA_END_HORIZONTAL_RETRACE_BIT) - retrace) & VGA_END_HORIZONTAL_RETRACE_BIT;
+	int end;
+	total   = (total + 5) / 2 - 5;
+	display = (display + 1) / 2 - 1;
+	blank   = blank / 2;
+	retrace = retrace / 2;
+	end     = (blank + blankWidth / 2) & 0x3F;
+	blankEnd   = (blankEnd & ~VGA_END_HORIZONTAL_BLANKING_BIT) | (end & VGA_END_HORIZONTAL_BLANKING_BIT);
+	retraceEnd = (retraceEnd & ~(VGA_END_HORIZONTAL_RETRACE_BIT | VGA_END_HORIZONTAL_BLANKING_BIT_5)) |
+	             ((retrace + retraceWidth / 2) & VGA_END_HORIZONTAL_RETRACE_BIT) |
+	             (end & 0x20 ? VGA_END_HORIZONTAL_BLANKING_BIT_5 : 0);
+	vgaWriteCRTC(VGA_VERTICAL_RETRACE_END, protect & ~VGA_CRTC_REGISTERS_PROTECT_ENABLE_BIT);
+	vgaWriteCRTC(VGA_HORIZONTAL_TOTAL, total);
+	vgaWriteCRTC(VGA_END_HORIZONTAL_DISPLAY, display);
+	vgaWriteCRTC(VGA_START_HORIZONTAL_BLANKING, blank);
+	vgaWriteCRTC(VGA_END_HORIZONTAL_BLANKING, blankEnd);
+	vgaWriteCRTC(VGA_START_HORIZONTAL_RETRACE, retrace);
+	vgaWriteCRTC(VGA_END_HORIZONTAL_RETRACE, retraceEnd);
+	vgaWriteCRTC(VGA_VERTICAL_RETRACE_END, protect);
+}
+
+/*******************************************************************************
+ *
+ *	Attribute Controller
+ *
+ ******************************************************************************/
+
+/*
+ * vgaSetPixelPanning
+ *
+ *	Shifts the display left by part of one unit of the start address. In
+ *	256 color modes the value counts half pixels, so 0, 2, 4 and 6 shift by
+ *	0 to 3 pixels. The value takes effect at once, so it is best written
+ *	during vertical retrace together with the start address. Reading input
+ *	status 1 sets the attribute controller to expect an index, which is
+ *	written with the palette address source bit so the display stays on.
+ */
+
+void vgaSetPixelPanning(int value)
+{
+	inportb(VGA_INPUT_STATUS_1);
+	outportb(VGA_ATTRIBUTE_ADDRESS, VGA_HORIZONTAL_PIXEL_PANNING | VGA_PALETTE_ADDRESS_SOURCE_BIT);
+	outportb(VGA_ATTRIBUTE_DATA_WRITE, value & VGA_PIXEL_SHIFT_COUNT_BIT);
+}
+
+/*******************************************************************************
+ *
+ *	Sequencer
+ *
+ ******************************************************************************/
+
+/*
+ * vgaSetDotClockHalved
+ *
+ *	Runs the pixel clock at half the rate of the selected clock, so every
+ *	pixel is shown twice as wide. The sequencer is held in synchronous reset
+ *	while the clocking mode changes.
+ */
+
+void vgaSetDotClockHalved(BOOL halved)
+{
+	int clocking = vgaQuerySequencer(VGA_CLOCKING_MODE) & ~VGA_DOT_CLOCK_RATE_BIT;
+	vgaWriteSequencer(VGA_RESET, VGA_ASYNCHRONOUS_BIT);
+	vgaWriteSequencer(VGA_CLOCKING_MODE, halved ? clocking | VGA_DOT_CLOCK_RATE_BIT : clocking);
+	vgaWriteSequencer(VGA_RESET, VGA_ASYNCHRONOUS_BIT | VGA_SYNCHRONOUS_BIT);
+}
+
+BOOL vgaIsDotClockHalved(void)
+{
+	return (vgaQuerySequencer(VGA_CLOCKING_MODE) & VGA_DOT_CLOCK_RATE_BIT) != 0;
+}
+
+/*******************************************************************************
+ *
+ *	Font Memory
+ *
+ *	Text mode fonts live in plane 2 of display memory, in eight blocks of
+ *	256 characters with each character on a 32 byte boundary. These
+ *	functions map plane 2 at a0000h for the duration of the call, so glyphs
+ *	can be changed without a BIOS call or staging through the transfer
+ *	buffer, and put back the sequencer and graphics registers afterwards.
+ *
+ ******************************************************************************/
+
+#define VGA_FONT_MEMORY		0xA0000
+#define VGA_FONT_CHAR_SIZE	32
+
+/*
+ * vgaFontBlockOffset
+ *
+ *	Returns the offset into plane 2 of a font block. Blocks 4 to 7 are
+ *	interleaved 8k after blocks 0 to 3.
+ */
+
+long vgaFontBlockOffset(int block)
+{
+	return ((block & 3) << 14) | ((block & 4) << 11);
+}
+
+/*
+ * vgaMapFontPlane
+ *
+ *	Saves the registers it changes in 'saved' and maps plane 2 for linear
+ *	access at a0000h.
+ */
+
+static void vgaMapFontPlane(int saved[5])
+{
+	saved[0] = vgaQuerySequencer(VGA_MAP_MASK);
+	saved[1] = vgaQuerySequencer(VGA_SEQUENCER_MEMORY_MODE);
+	saved[2] = vgaQueryGraphics(VGA_READ_MAP_SELECT);
+	saved[3] = vgaQueryGraphics(VGA_GRAPHICS_MODE);
+	saved[4] = vgaQueryGraphics(VGA_MISC_GRAPHICS);
+	/* Hold the sequencer in synchronous reset while it is changed */
+	vgaWriteSequencer(VGA_RESET, VGA_ASYNCHRONOUS_BIT);
+	vgaWriteSequencer(VGA_MAP_MASK, VGA_PLANE_2_BIT);
+	vgaWriteSequencer(VGA_SEQUENCER_MEMORY_MODE, VGA_EXTENDED_MEMORY_BIT | VGA_HOST_MEMORY_WRITE_ADDRESSING_DISABLE_BIT);
+	vgaWriteSequencer(VGA_RESET, VGA_ASYNCHRONOUS_BIT | VGA_SYNCHRONOUS_BIT);
+	/* Read plane 2, sequential addressing, 128k at a0000h */
+	vgaWriteGraphics(VGA_READ_MAP_SELECT, 2);
+	vgaWriteGraphics(VGA_GRAPHICS_MODE, 0x00);
+	vgaWriteGraphics(VGA_MISC_GRAPHICS, VGA_A0000_BFFFF_128K_BIT);
+}
+
+/*
+ * vgaUnmapFontPlane
+ *
+ *	Puts back the registers saved by 'vgaMapFontPlane'.
+ */
+
+static void vgaUnmapFontPlane(int saved[5])
+{
+	vgaWriteSequencer(VGA_RESET, VGA_ASYNCHRONOUS_BIT);
+	vgaWriteSequencer(VGA_MAP_MASK, saved[0]);
+	vgaWriteSequencer(VGA_SEQUENCER_MEMORY_MODE, saved[1]);
+	vgaWriteSequencer(VGA_RESET, VGA_ASYNCHRONOUS_BIT | VGA_SYNCHRONOUS_BIT);
+	vgaWriteGraphics(VGA_READ_MAP_SELECT, saved[2]);
+	vgaWriteGraphics(VGA_GRAPHICS_MODE, saved[3]);
+	vgaWriteGraphics(VGA_MISC_GRAPHICS, saved[4]);
+}
+
+/*
+ * vgaWriteFontGlyphs
+ *
+ *	Writes a range of characters into a font block. Only the given glyphs
+ *	are touched, so single characters can be animated cheaply.
+ *
+ *	int block
+ *		Font block 0-7.
+ *	int first
+ *		First character to replace.
+ *	int count
+ *		Number of characters to replace.
+ *	int bytesPerChar
+ *		Rows in each glyph of 'table', up to 32.
+ *	const void * table
+ *		Glyph rows packed one after the other.
+ */
+
+void vgaWriteFontGlyphs(int block, int first, int count, int bytesPerChar, const void *table)
+{
+	const char *glyph = table;
+	long address = VGA_FONT_MEMORY + vgaFontBlockOffset(block) + first * VGA_FONT_CHAR_SIZE;
+	int saved[5];
+	vgaMapFontPlane(saved);
+	while(count --)
+	{
+		dosmemput(glyph, bytesPerChar, address);
+		glyph   += bytesPerChar;
+		address += VGA_FONT_CHAR_SIZE;
+	}
+	vgaUnmapFontPlane(saved);
+}
+
+/*
+ * vgaReadFontGlyphs
+ *
+ *	Reads a range of characters out of a font block, packed the same way
+ *	'vgaWriteFontGlyphs' takes them.
+ */
+
+void vgaReadFontGlyphs(int block, int first, int count, int bytesPerChar, void *table)
+{
+	char *glyph = table;
+	long address = VGA_FONT_MEMORY + vgaFontBlockOffset(block) + first * VGA_FONT_CHAR_SIZE;
+	int saved[5];
+	vgaMapFontPlane(saved);
+	while(count --)
+	{
+		dosmemget(address, bytesPerChar, glyph);
+		glyph   += bytesPerChar;
+		address += VGA_FONT_CHAR_SIZE;
+	}
+	vgaUnmapFontPlane(saved);
+}
+
+/*
+ * vgaSetCharacterMapSelect
+ *
+ *	Chooses the font blocks used for text. Characters whose attribute has
+ *	bit 3 clear are drawn from the primary block, the others from the
+ *	secondary block. Using two blocks gives 512 characters on screen.
+ */
+
+void vgaSetCharacterMapSelect(int primary, int secondary)
+{
+	int value = 0;
+	/* Set A serves attribute bit 3 set, set B serves it clear */
+	value |= ((secondary & 3) << 2) & VGA_CHAR_SET_A_SELECT_BIT;
+	value |= ((secondary & 4) << 3) & VGA_CHAR_SET_A_SELECT_BIT_2;
+	value |= (primary & 3) & VGA_CHAR_SET_B_SELECT_BIT;
+	value |= ((primary & 4) << 2) & VGA_CHAR_SET_B_SELECT_BIT_2;
+	vgaWriteSequencer(VGA_CHARACTER_MAP_SELECT, value);
+}
@@ -206,7 +206,7 @@ static int VGA_FEATURE_CONTROL_WRITE			= -1;
 
 /* VGA_MAXIMUM_SCAN_LINE */
 
-#define VGA_MAXIMUM_SCAN_LINE_BIT			0x60	/* 00011111 */
+#define VGA_MAXIMUM_SCAN_LINE_BIT			0x1F	/* 00011111 */
 #define VGA_START_VERTICAL_BLANKING_BIT_9		0x20	/* 00100000 */
 #define VGA_LINE_COMPARE_BIT_9				0x40	/* 01000000 */
 #define VGA_SCAN_DOUBLING_BIT				0x80	/* 10000000 */
@@ -463,6 +463,50 @@ int vgaQueryGraphics(int index);
 
 int vgaQueryMiscGraphics(int mask);
 
+/* Write */
+
+void vgaWrite(int port, int index, int data, int value);
+
+void vgaWriteCRTC(int index, int value);
+
+void vgaWriteSequencer(int index, int value);
+
+void vgaWriteGraphics(int index, int value);
+
+/* CRT Controller */
+
+void vgaSetStartAddress(int address);
+
+void vgaSetLineCompare(int line);
+
+void vgaSetCursorLocation(int address);
+
+void vgaSetScanRepeat(int repeat);
+
+int vgaGetScanRepeat(void);
+
+void vgaHalveHorizontalTiming(void);
+
+/* Attribute Controller */
+
+void vgaSetPixelPanning(int value);
+
+/* Sequencer */
+
+void vgaSetDotClockHalved(BOOL halved);
+
+BOOL vgaIsDotClockHalved(void);
+
+/* Font Memory */
+
+long vgaFontBlockOffset(int block);
+
+void vgaWriteFontGlyphs(int block, int first, int count, int bytesPerChar, const void *table);
+
+void vgaReadFontGlyphs(int block, int first, int count, int bytesPerChar, void *table);
+
+void vgaSetCharacterMapSelect(int primary, int secondary);
+
 
 
 #endif /* VGAio_h */
@@ -0,0 +1,335 @@
+/*******************************************************************************
+ *
+ *	VGA Frame Scheduler library
+ *
+ *	Replaces busy waiting on the vertical retrace bit with the system timer.
+ *	The refresh period is measured once from the retrace bit, then a timer
+ *	deadline is set to come shortly before each retrace. The callback
+ *	catches the start of retrace, runs the registered callbacks and sets the
+ *	deadline for the next frame, so drift is corrected every frame. A
+ *	retrace the deadline comes too late for is skipped, not counted.
+ */
+
+#include <stdlib.h>
+
+#include "farseg.h"
+#include "VGAio.h"
+#include "VGAsync.h"
+#include "timer.h"
+
+/* Everything the timer callback touches, locked as one block */
+
+static struct
+{
+	int                    StatusPort;	/* Input status 1 for the current mode */
+	long                   Period;		/* Microseconds per frame */
+	long                   Lead;		/* Microseconds the deadline comes before retrace */
+	int                    Handle;		/* Timer deadline */
+	unsigned long long     Next;		/* Microsecond the next retrace is expected to start */
+	volatile unsigned long Count;		/* Retraces caught */
+	VGAsyncCallback        Callbacks[VGA_SYNC_CALLBACKS];
+	void                  *Data[VGA_SYNC_CALLBACKS];
+
+} Sync;
+
+static BOOL Installed = FALSE;
+
+static BOOL OwnsTimer = FALSE;			/* Timer was installed by the scheduler */
+
+/*******************************************************************************
+ *
+ *	Timer callback
+ *
+ ******************************************************************************/
+
+/*
+ * vgaSyncArm
+ *
+ *	Sets the deadline for the retrace a frame after 'start'.
+ */
+
+static void vgaSyncArm(unsigned long long start)
+{
+	unsigned long long now = tmrMicroseconds();
+	Sync.Next = start + Sync.Period;
+	tmrRearm(Sync.Handle, Sync.Next - Sync.Lead > now ? (long)(Sync.Next - Sync.Lead - now) : 0);
+}
+
+/*
+ * vgaSyncRetrace
+ *
+ *	Arrives a little before retrace and waits out the remainder, with the
+ *	timer interrupt acknowledged and interrupts enabled. The wait is given
+ *	two leads; if retrace has not begun by then the deadline came too late
+ *	to catch it, so the frame is skipped rather than spinning through it
+ *	inside the interrupt. If retrace is already under way it is taken to
+ *	have started when expected.
+ */
+
+static void vgaSyncRetrace(void *data)
+{
+	unsigned long long now = tmrMicroseconds(), limit = now + 2 * Sync.Lead, start;
+	int index;
+	if(inportb(Sync.StatusPort) & VGA_VERTICAL_RETRACE_BIT)
+	{
+		while(Sync.Next + Sync.Period <= now)
+		{
+			Sync.Next += Sync.Period;
+		}
+		start = Sync.Next < now ? Sync.Next : now;
+	}
+	else
+	{
+		while(!(inportb(Sync.StatusPort) & VGA_VERTICAL_RETRACE_BIT))
+		{
+			if(tmrMicroseconds() >= limit)
+			{
+				while(Sync.Next <= now)
+				{
+					Sync.Next += Sync.Period;
+				}
+				vgaSyncArm(Sync.Next - Sync.Period);
+				return;
+			}
+		}
+		start = tmrMicroseconds();
+	}
+	/* Measure the next frame from the start of this one to cancel any drift */
+	vgaSyncArm(start);
+	Sync.Count ++;
+	for(index = 0; index < VGA_SYNC_CALLBACKS; index ++)
+	{
+		if(Sync.Callbacks[ index ])
+		{
+			Sync.Callbacks[ index ](Sync.Data[ index ]);
+		}
+	}
+}
+
+static void vgaSyncRetraceEnd(void)
+{
+}
+
+/*
+ * vgaSyncEdge
+ *
+ *	Waits for the start of the next vertical retrace.
+ */
+
+static void vgaSyncEdge(void)
+{
+	while(inportb(Sync.StatusPort) & VGA_VERTICAL_RETRACE_BIT);
+	while(!(inportb(Sync.StatusPort) & VGA_VERTICAL_RETRACE_BIT));
+}
+
+/*******************************************************************************
+ *
+ *	VGA Frame Scheduler functions
+ *
+ ******************************************************************************/
+
+/*
+ * vgaSyncCalibrate
+ *
+ *	Measures the refresh period by timing a number of retraces. Must be
+ *	called in the video mode the scheduler will run in, with the timer
+ *	installed.
+ *
+ *	int frames
+ *		Number of frames to average, 0 for the default.
+ *	returns
+ *		The period in microseconds, or -1 if the timer is not installed.
+ */
+
+long vgaSyncCalibrate(int frames)
+{
+	unsigned long long start;
+	int index;
+	if(!tmrInstalled())
+	{
+		return -1;
+	}
+	if(frames <= 0)
+	{
+		frames = VGA_SYNC_CALIBRATION_FRAMES;
+	}
+	Sync.StatusPort = vgaIsColorMode() ? VGA_COLOR_INPUT_STATUS_1 : VGA_MONO_INPUT_STATUS_1;
+	vgaSyncEdge();
+	start = tmrMicroseconds();
+	for(index = 0; index < frames; index ++)
+	{
+		vgaSyncEdge();
+	}
+	Sync.Period = (long)((tmrMicroseconds() - start) / frames);
+	return Sync.Period;
+}
+
+/*
+ * vgaSyncPeriod
+ *
+ *	returns
+ *		The measured refresh period in microseconds, 0 if not calibrated.
+ */
+
+long vgaSyncPeriod()
+{
+	return Sync.Period;
+}
+
+/*
+ * vgaSyncInstall
+ *
+ *	Installs the timer if nothing else has, calibrates if needed and sets
+ *	the first deadline.
+ *
+ *	long lead
+ *		Microseconds before retrace the deadline should come, 0 for an
+ *		eighth of a frame. It is never less than two timer ticks. Longer
+ *		leads cost more time spinning in the callback, shorter ones risk
+ *		missing the retrace on a busy system.
+ *	returns
+ *		True if the scheduler is running.
+ */
+
+BOOL vgaSyncInstall(long lead)
+{
+	if(Installed)
+	{
+		return TRUE;
+	}
+	if(!tmrInstalled())
+	{
+		if(!tmrInstall(0))
+		{
+			return FALSE;
+		}
+		OwnsTimer = TRUE;
+	}
+	if(!Sync.Period)
+	{
+		vgaSyncCalibrate(0);
+	}
+	Sync.Lead = lead > 0 ? lead : Sync.Period / 8;
+	if(Sync.Lead < tmrResolution() * 2)
+	{
+		Sync.Lead = tmrResolution() * 2;
+	}
+	if(Sync.Period <= 0 || Sync.Lead >= Sync.Period)
+	{
+		vgaSyncRemove();
+		return FALSE;
+	}
+	_go32_dpmi_lock_data(&Sync, sizeof(Sync));
+	_go32_dpmi_lock_code(vgaSyncArm, (unsigned long)vgaSyncRetraceEnd - (unsigned long)vgaSyncArm);
+	/* Start in phase with the display */
+	vgaSyncEdge();
+	Sync.Next   = tmrMicroseconds() + Sync.Period;
+	Sync.Handle = tmrAddDeadline(Sync.Period - Sync.Lead, vgaSyncRetrace, NULL);
+	if(Sync.Handle < 0)
+	{
+		vgaSyncRemove();
+		return FALSE;
+	}
+	Installed = TRUE;
+	return TRUE;
+}
+
+/*
+ * vgaSyncRemove
+ *
+ *	Cancels the deadline, and removes the timer if the scheduler installed
+ *	it.
+ */
+
+void vgaSyncRemove()
+{
+	if(Installed)
+	{
+		tmrCancel(Sync.Handle);
+		Installed = FALSE;
+	}
+	if(OwnsTimer)
+	{
+		tmrRemove();
+		OwnsTimer = FALSE;
+	}
+}
+
+/*
+ * vgaSyncAddCallback
+ *
+ *	Registers a function to be called at the start of every retrace.
+ *
+ *	VGAsyncCallback callback
+ *		Function to call, locked along with everything it uses.
+ *	void * data
+ *		Passed to the callback.
+ *	returns
+ *		Handle for 'vgaSyncRemoveCallback', or -1 if every slot is taken.
+ */
+
+int vgaSyncAddCallback(VGAsyncCallback callback, void *data)
+{
+	int index;
+	for(index = 0; index < VGA_SYNC_CALLBACKS; index ++)
+	{
+		if(!Sync.Callbacks[ index ])
+		{
+			/* The timer may run between these, so data goes first */
+			Sync.Data[ index ]      = data;
+			Sync.Callbacks[ index ] = callback;
+			return index;
+		}
+	}
+	return -1;
+}
+
+/*
+ * vgaSyncRemoveCallback
+ *
+ *	int handle
+ *		As returned by 'vgaSyncAddCallback'.
+ */
+
+void vgaSyncRemoveCallback(int handle)
+{
+	if(handle >= 0 && handle < VGA_SYNC_CALLBACKS)
+	{
+		Sync.Callbacks[ handle ] = NULL;
+	}
+}
+
+/*
+ * vgaSyncCount
+ *
+ *	returns
+ *		The number of retraces caught since the scheduler was installed.
+ */
+
+unsigned long vgaSyncCount()
+{
+	return Sync.Count;
+}
+
+/*
+ * vgaSyncPoll
+ *
+ *	Non-blocking replacement for 'vgaOnSync'. The caller keeps a count and
+ *	renders until a new retrace has gone by.
+ *
+ *	unsigned long * count
+ *		Retrace count last seen, updated when a new retrace is reported.
+ *	returns
+ *		True once for each time a retrace has gone by.
+ */
+
+BOOL vgaSyncPoll(unsigned long *count)
+{
+	unsigned long current = Sync.Count;
+	if(current != *count)
+	{
+		*count = current;
+		return TRUE;
+	}
+	return FALSE;
+}
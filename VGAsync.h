@@ -0,0 +1,62 @@
+/*******************************************************************************
+ *
+ *	VGA Frame Scheduler library
+ *
+ *	Replaces busy waiting on the vertical retrace bit with the system timer.
+ *	The refresh period is measured once from the retrace bit, then a timer
+ *	deadline is set to come shortly before each retrace. The callback
+ *	catches the start of retrace, runs the registered callbacks and sets the
+ *	deadline for the next frame, so drift is corrected every frame. A
+ *	retrace the deadline comes too late for is skipped, not counted.
+ *
+ *	Callbacks run inside the timer interrupt. Their code and any data they
+ *	touch must be locked, and they must be short enough to finish within the
+ *	retrace.
+ */
+
+#ifndef VGAsync_h
+#define VGAsync_h
+
+#include "VGA.h"
+
+/*******************************************************************************
+ *
+ *	VGA Frame Scheduler flags
+ *
+ ******************************************************************************/
+
+#define VGA_SYNC_CALLBACKS			8	/* Callback slots */
+#define VGA_SYNC_CALIBRATION_FRAMES		16	/* Frames averaged by default */
+
+/*******************************************************************************
+ *
+ *	VGA Frame Scheduler structures
+ *
+ ******************************************************************************/
+
+typedef void (*VGAsyncCallback)(void *data);
+
+/*******************************************************************************
+ *
+ *	VGA Frame Scheduler functions
+ *
+ ******************************************************************************/
+
+long vgaSyncCalibrate(int frames);
+
+long vgaSyncPeriod();
+
+BOOL vgaSyncInstall(long lead);
+
+void vgaSyncRemove();
+
+int vgaSyncAddCallback(VGAsyncCallback callback, void *data);
+
+void vgaSyncRemoveCallback(int handle);
+
+unsigned long vgaSyncCount();
+
+BOOL vgaSyncPoll(unsigned long *count);
+
+
+#endif /* VGAsync_h */
@@ -0,0 +1,256 @@
+/*******************************************************************************
+ *
+ *	VGA Frame Timing library
+ *
+ *	Measures the display timing from the retrace and display disabled bits
+ *	of input status 1 against the processor time stamp counter, and keeps
+ *	per-frame statistics: a histogram of frame times, retraces missed and
+ *	time spent waiting for retrace.
+ *
+ *	The display disabled bit is also set during every horizontal blank, so
+ *	the vertical blank is taken as the time from the last moment the display
+ *	was seen enabled before retrace to the first moment after it.
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "farseg.h"
+#include "intern.h"
+#include "VGAio.h"
+#include "VGAtime.h"
+#include "timer.h"
+
+/*
+ * vgaTimeStatusPort
+ *
+ *	returns
+ *		Input status 1 for the current color or monochrome mode.
+ */
+
+static int vgaTimeStatusPort(void)
+{
+	return vgaIsColorMode() ? VGA_COLOR_INPUT_STATUS_1 : VGA_MONO_INPUT_STATUS_1;
+}
+
+/*
+ * vgaTimeClock
+ *
+ *	Reads the clock the time stamp counter is timed against. While the timer
+ *	is installed 'uclock' only keeps the BIOS tick, so the timer is used.
+ *
+ *	unsigned long long * perSecond
+ *		Receives the clock ticks per second.
+ */
+
+static unsigned long long vgaTimeClock(unsigned long long *perSecond)
+{
+	if(tmrInstalled())
+	{
+		*perSecond = 1000000;
+		return tmrMicroseconds();
+	}
+	*perSecond = UCLOCKS_PER_SEC;
+	return uclock();
+}
+
+/*
+ * vgaTimeCalibrate
+ *
+ *	Follows the display through a number of frames, then averages the
+ *	lengths seen. The time stamp counter is timed against 'uclock', or the
+ *	timer when it is installed, over the same frames to find its frequency.
+ *
+ *	VGAtiming * timing
+ *		Pointer to a timing structure to fill in.
+ *	int frames
+ *		Number of frames to average, 0 for the default.
+ *	returns
+ *		True if the measurement produced a usable timing.
+ */
+
+BOOL vgaTimeCalibrate(VGAtiming *timing, int frames)
+{
+	int port = vgaTimeStatusPort();
+	unsigned long long now, enabled = 0, start = 0, first = 0;
+	unsigned long long retrace = 0, blank = 0, display = 0;
+	unsigned long long clockStart = 0, clockEnd = 0, perSecond = 1;
+	int index, status;
+	memset(timing, 0, sizeof(VGAtiming));
+	if(frames <= 0)
+	{
+		frames = VGA_TIME_CALIBRATION_FRAMES;
+	}
+	/* Start outside retrace so the first edge is seen */
+	while(inportb(port) & VGA_VERTICAL_RETRACE_BIT);
+	for(index = 0; index <= frames; index ++)
+	{
+		/* Active display up to the start of retrace */
+		do
+		{
+			status = inportb(port);
+			rdtsc(now);
+			if(!(status & VGA_DISPLAY_DISABLED_BIT))
+			{
+				enabled = now;
+			}
+		}
+		while(!(status & VGA_VERTICAL_RETRACE_BIT));
+		start = now;
+		if(index == 0)
+		{
+			first      = start;
+			clockStart = vgaTimeClock(&perSecond);
+		}
+		else if(index == frames)
+		{
+			clockEnd = vgaTimeClock(&perSecond);
+		}
+		/* Vertical sync pulse */
+		while(inportb(port) & VGA_VERTICAL_RETRACE_BIT);
+		rdtsc(now);
+		if(index > 0)
+		{
+			retrace += now - start;
+		}
+		/* Rest of the blank */
+		while(inportb(port) & VGA_DISPLAY_DISABLED_BIT);
+		rdtsc(now);
+		if(index > 0)
+		{
+			blank   += now - enabled;
+			display += now - start;
+		}
+	}
+	if(clockEnd <= clockStart)
+	{
+		return FALSE;
+	}
+	timing->Frequency = (start - first) * perSecond / (clockEnd - clockStart);
+	timing->Period    = (start - first) / frames;
+	timing->Retrace   = retrace / frames;
+	timing->Blank     = blank / frames;
+	timing->Display   = display / frames;
+	if(!timing->Frequency || !timing->Period || timing->Blank >= timing->Period)
+	{
+		return FALSE;
+	}
+	timing->Active    = timing->Period - timing->Blank;
+	return TRUE;
+}
+
+/*
+ * vgaTimeMicroseconds
+ *
+ *	VGAtiming * timing
+ *		Pointer to a calibrated timing structure.
+ *	unsigned long long ticks
+ *		A time in time stamp counter ticks.
+ *	returns
+ *		The time in microseconds.
+ */
+
+long vgaTimeMicroseconds(VGAtiming *timing, unsigned long long ticks)
+{
+	if(!timing->Frequency)
+	{
+		return 0;
+	}
+	return (long)(ticks * 1000000 / timing->Frequency);
+}
+
+/*
+ * vgaTimeRetraceWindow
+ *
+ *	The time each frame when nothing is being scanned out, for code that
+ *	budgets video memory writes against it.
+ *
+ *	VGAtiming * timing
+ *		Pointer to a calibrated timing structure.
+ *	returns
+ *		Length of the vertical blank in microseconds.
+ */
+
+long vgaTimeRetraceWindow(VGAtiming *timing)
+{
+	return vgaTimeMicroseconds(timing, timing->Blank);
+}
+
+/*
+ * vgaTimeResetStats
+ *
+ *	VGAframeStats * stats
+ *		Pointer to a statistics structure to clear.
+ *	VGAtiming * timing
+ *		Pointer to a calibrated timing structure, kept by the statistics.
+ */
+
+void vgaTimeResetStats(VGAframeStats *stats, VGAtiming *timing)
+{
+	memset(stats, 0, sizeof(VGAframeStats));
+	stats->Timing = timing;
+}
+
+/*
+ * vgaTimeWaitSync
+ *
+ *	Same as 'vgaOnSync', adding the time spent to the statistics.
+ *
+ *	VGAframeStats * stats
+ *		Pointer to a statistics structure.
+ */
+
+void vgaTimeWaitSync(VGAframeStats *stats)
+{
+	int port = vgaTimeStatusPort();
+	unsigned long long start, end;
+	rdtsc(start);
+	while(inportb(port) & VGA_VERTICAL_RETRACE_BIT);
+	while(!(inportb(port) & VGA_VERTICAL_RETRACE_BIT));
+	rdtsc(end);
+	stats->Waited += end - start;
+}
+
+/*
+ * vgaTimeFrame
+ *
+ *	Marks the end of a frame. The time since the previous one goes into the
+ *	histogram, and every whole refresh period past the first counts as a
+ *	missed retrace.
+ *
+ *	VGAframeStats * stats
+ *		Pointer to a statistics structure.
+ */
+
+void vgaTimeFrame(VGAframeStats *stats)
+{
+	VGAtiming *timing = stats->Timing;
+	unsigned long long now, elapsed;
+	unsigned long bin, periods;
+	rdtsc(now);
+	if(stats->Last)
+	{
+		elapsed = now - stats->Last;
+		bin = vgaTimeMicroseconds(timing, elapsed) / 1000;
+		if(bin >= VGA_TIME_HISTOGRAM_BINS)
+		{
+			bin = VGA_TIME_HISTOGRAM_BINS - 1;
+		}
+		stats->Histogram[ bin ] ++;
+		if(elapsed > stats->Slowest)
+		{
+			stats->Slowest = elapsed;
+		}
+		if(timing->Period)
+		{
+			/* Round so jitter around one period is not counted */
+			periods = (elapsed + timing->Period / 2) / timing->Period;
+			if(periods > 1)
+			{
+				stats->Missed += periods - 1;
+			}
+		}
+		stats->Frames ++;
+	}
+	stats->Last = now;
+}
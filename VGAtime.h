@@ -0,0 +1,75 @@
+/*******************************************************************************
+ *
+ *	VGA Frame Timing library
+ *
+ *	Measures the display timing from the retrace and display disabled bits
+ *	of input status 1 against the processor time stamp counter, and keeps
+ *	per-frame statistics: a histogram of frame times, retraces missed and
+ *	time spent waiting for retrace.
+ */
+
+#ifndef VGAtime_h
+#define VGAtime_h
+
+#include "VGA.h"
+
+/*******************************************************************************
+ *
+ *	VGA Frame Timing flags
+ *
+ ******************************************************************************/
+
+#define VGA_TIME_CALIBRATION_FRAMES		16	/* Frames averaged by default */
+#define VGA_TIME_HISTOGRAM_BINS			64	/* One millisecond per bin */
+
+/*******************************************************************************
+ *
+ *	VGA Frame Timing structures
+ *
+ ******************************************************************************/
+
+/* All times are in time stamp counter ticks */
+
+typedef struct
+{
+	unsigned long long Frequency;		/* Ticks per second */
+	unsigned long long Period;		/* Start of retrace to start of retrace */
+	unsigned long long Retrace;		/* Length of the vertical sync pulse */
+	unsigned long long Blank;		/* Last active line to first active line */
+	unsigned long long Display;		/* Start of retrace to first active line */
+	unsigned long long Active;		/* Period less the blank */
+
+} VGAtiming;
+
+typedef struct
+{
+	VGAtiming         *Timing;
+	unsigned long long Last;		/* End of the previous frame, 0 before the first */
+	unsigned long long Waited;		/* Total spent in 'vgaTimeWaitSync' */
+	unsigned long long Slowest;		/* Longest frame */
+	unsigned long      Frames;		/* Frames ended */
+	unsigned long      Missed;		/* Retraces gone by with no new frame */
+	unsigned long      Histogram[VGA_TIME_HISTOGRAM_BINS];	/* Last bin holds longer frames */
+
+} VGAframeStats;
+
+/*******************************************************************************
+ *
+ *	VGA Frame Timing functions
+ *
+ ******************************************************************************/
+
+BOOL vgaTimeCalibrate(VGAtiming *timing, int frames);
+
+long vgaTimeMicroseconds(VGAtiming *timing, unsigned long long ticks);
+
+long vgaTimeRetraceWindow(VGAtiming *timing);
+
+void vgaTimeResetStats(VGAframeStats *stats, VGAtiming *timing);
+
+void vgaTimeWaitSync(VGAframeStats *stats);
+
+void vgaTimeFrame(VGAframeStats *stats);
+
+
+#endif /* VGAtime_h */
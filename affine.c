@@ -0,0 +1,377 @@
+/*******************************************************************************
+ *
+ *	Affine library
+ *
+ *	Rotated and scaled blits. Each target pixel is mapped back into the
+ *	source bitmap by an affine transform stepped in 16.16 fixed point. The
+ *	part of each target line that lands inside the source is found before
+ *	the line is drawn, so the inner loops have no bounds checks.
+ *
+ *	Sampling is nearest or bilinear, with an optional color key. Eight bit
+ *	surfaces hold palette indices, which cannot be blended, so bilinear
+ *	filtering falls back to nearest there.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "affine.h"
+
+/* Source and sampling state shared by the inner loops */
+
+typedef struct
+{
+	unsigned char *Bits;
+	int            BytesPerLine;
+	int            Width;
+	int            Height;
+	BOOL           Keyed;
+	unsigned long  Key;
+	unsigned long  Masks[3];		/* Red, green and blue fields */
+
+} GFXsampler;
+
+typedef void (*GFXsampleFunction)(GFXsampler *sampler, unsigned char *pixel, int count, long u, long v, long du, long dv);
+
+/* Sine of each angle step, 16.16 fixed point, filled in on first use */
+
+static long Sines[GFX_AFFINE_ANGLES];
+static BOOL SinesReady = FALSE;
+
+/*******************************************************************************
+ *
+ *	Sampling
+ *
+ ******************************************************************************/
+
+/*
+ * gfxNearest, gfxNearestKeyed
+ *
+ *	Copy the source pixel each target pixel lands in.
+ */
+
+#define GFX_NEAREST(name, bytes) \
+static void name(GFXsampler *sampler, unsigned char *pixel, int count, long u, long v, long du, long dv) \
+{ \
+	unsigned char *bits = sampler->Bits; \
+	int pitch = sampler->BytesPerLine; \
+	for(; count > 0; count --, pixel += bytes, u += du, v += dv) \
+	{ \
+		GFX_PUT_##bytes(pixel, GFX_GET_##bytes(bits + (v >> 16) * pitch + (u >> 16) * bytes)); \
+	} \
+}
+
+#define GFX_NEAREST_KEYED(name, bytes) \
+static void name(GFXsampler *sampler, unsigned char *pixel, int count, long u, long v, long du, long dv) \
+{ \
+	unsigned char *bits = sampler->Bits; \
+	unsigned long key = sampler->Key, color; \
+	int pitch = sampler->BytesPerLine; \
+	for(; count > 0; count --, pixel += bytes, u += du, v += dv) \
+	{ \
+		color = GFX_GET_##bytes(bits + (v >> 16) * pitch + (u >> 16) * bytes); \
+		if(color != key) \
+		{ \
+			GFX_PUT_##bytes(pixel, color); \
+		} \
+	} \
+}
+
+GFX_NEAREST(gfxNearest1, 1)
+GFX_NEAREST(gfxNearest2, 2)
+GFX_NEAREST(gfxNearest3, 3)
+GFX_NEAREST(gfxNearest4, 4)
+
+GFX_NEAREST_KEYED(gfxNearestKeyed1, 1)
+GFX_NEAREST_KEYED(gfxNearestKeyed2, 2)
+GFX_NEAREST_KEYED(gfxNearestKeyed3, 3)
+GFX_NEAREST_KEYED(gfxNearestKeyed4, 4)
+
+/*
+ * gfxLerpPixel
+ *
+ *	Blends two direct color pixels field by field, with a weight of 0-256
+ *	for the second. Fields are at most 8 bits wide and end by bit 23, so
+ *	the products fit in 32 bits. Reserved bits come from the first pixel.
+ */
+
+static unsigned long gfxLerpPixel(GFXsampler *sampler, unsigned long a, unsigned long b, int weight)
+{
+	unsigned long result = a & ~(sampler->Masks[ 0 ] | sampler->Masks[ 1 ] | sampler->Masks[ 2 ]);
+	unsigned long mask;
+	int index;
+	for(index = 0; index < 3; index ++)
+	{
+		mask    = sampler->Masks[ index ];
+		result |= (((a & mask) * (256 - weight) + (b & mask) * weight) >> 8) & mask;
+	}
+	return result;
+}
+
+/*
+ * gfxBilinear
+ *
+ *	Blends the four source pixels around each target pixel, repeating the
+ *	edge pixels at the borders. With a color key the pixel is skipped when
+ *	the nearest source pixel is the key, and keyed neighbours are replaced
+ *	by the nearest one so the key does not bleed in.
+ */
+
+#define GFX_BILINEAR(name, bytes) \
+static void name(GFXsampler *sampler, unsigned char *pixel, int count, long u, long v, long du, long dv) \
+{ \
+	unsigned char *bits = sampler->Bits, *row0, *row1; \
+	int pitch = sampler->BytesPerLine; \
+	int x0, y0, x1, y1; \
+	long su, sv; \
+	unsigned long p00, p01, p10, p11, nearest; \
+	for(; count > 0; count --, pixel += bytes, u += du, v += dv) \
+	{ \
+		su = u - 0x8000; \
+		sv = v - 0x8000; \
+		x0 = (int)(su >> 16); \
+		y0 = (int)(sv >> 16); \
+		x1 = min(x0 + 1, sampler->Width - 1); \
+		y1 = min(y0 + 1, sampler->Height - 1); \
+		x0 = max(x0, 0); \
+		y0 = max(y0, 0); \
+		row0 = bits + y0 * pitch; \
+		row1 = bits + y1 * pitch; \
+		p00 = GFX_GET_##bytes(row0 + x0 * bytes); \
+		p01 = GFX_GET_##bytes(row0 + x1 * bytes); \
+		p10 = GFX_GET_##bytes(row1 + x0 * bytes); \
+		p11 = GFX_GET_##bytes(row1 + x1 * bytes); \
+		if(sampler->Keyed) \
+		{ \
+			nearest = GFX_GET_##bytes(bits + (v >> 16) * pitch + (u >> 16) * bytes); \
+			if(nearest == sampler->Key) \
+			{ \
+				continue; \
+			} \
+			p00 = p00 == sampler->Key ? nearest : p00; \
+			p01 = p01 == sampler->Key ? nearest : p01; \
+			p10 = p10 == sampler->Key ? nearest : p10; \
+			p11 = p11 == sampler->Key ? nearest : p11; \
+		} \
+		p00 = gfxLerpPixel(sampler, p00, p01, (su >> 8) & 0xFF); \
+		p10 = gfxLerpPixel(sampler, p10, p11, (su >> 8) & 0xFF); \
+		GFX_PUT_##bytes(pixel, gfxLerpPixel(sampler, p00, p10, (sv >> 8) & 0xFF)); \
+	} \
+}
+
+GFX_BILINEAR(gfxBilinear2, 2)
+GFX_BILINEAR(gfxBilinear3, 3)
+GFX_BILINEAR(gfxBilinear4, 4)
+
+static GFXsampleFunction Nearests[5] =
+{
+	NULL, gfxNearest1, gfxNearest2, gfxNearest3, gfxNearest4
+};
+
+static GFXsampleFunction NearestsKeyed[5] =
+{
+	NULL, gfxNearestKeyed1, gfxNearestKeyed2, gfxNearestKeyed3, gfxNearestKeyed4
+};
+
+static GFXsampleFunction Bilinears[5] =
+{
+	NULL, NULL, gfxBilinear2, gfxBilinear3, gfxBilinear4
+};
+
+/*******************************************************************************
+ *
+ *	Line clipping
+ *
+ ******************************************************************************/
+
+static long long gfxFloorDiv(long long n, long long d)
+{
+	return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+/*
+ * gfxAffineRange
+ *
+ *	Narrows the pixels [first, last) of a line to those where a + b * t,
+ *	stepped from t = 0, stays inside a source dimension of size pixels.
+ */
+
+static void gfxAffineRange(long long a, long b, int size, int *first, int *last)
+{
+	long long high = ((long long)size << 16) - 1;
+	long long low, end;
+	if(b == 0)
+	{
+		if(a < 0 || a > high)
+		{
+			*last = *first;
+		}
+		return;
+	}
+	if(b > 0)
+	{
+		low = -gfxFloorDiv(a, b);
+		end = gfxFloorDiv(high - a, b) + 1;
+	}
+	else
+	{
+		low = -gfxFloorDiv(high - a, -b);
+		end = gfxFloorDiv(a, -b) + 1;
+	}
+	if(low > *first)
+	{
+		*first = low < *last ? (int)low : *last;
+	}
+	if(end < *last)
+	{
+		*last = end > *first ? (int)end : *first;
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Affine functions
+ *
+ ******************************************************************************/
+
+/*
+ * gfxAffineBlit
+ *
+ *	Fills part of a surface with pixels sampled from another through an
+ *	affine transform. Target pixels that map outside the source are left
+ *	unchanged.
+ *
+ *	GFXsurface * target
+ *		Pointer to the surface to draw on.
+ *	GFXsurface * source
+ *		Pointer to the surface to sample, with the same pixel size.
+ *	GFXaffine * affine
+ *		Maps target pixels to source positions.
+ *	int left, top, right, bottom
+ *		Target rectangle to fill, right and bottom exclusive. It is clipped
+ *		to the clip rectangle of the target.
+ *	int flags
+ *		How to sample.
+ *			GFX_AFFINE_NEAREST
+ *			GFX_AFFINE_BILINEAR
+ *			GFX_AFFINE_COLORKEY
+ *	unsigned long key
+ *		Source pixel value left transparent with GFX_AFFINE_COLORKEY.
+ */
+
+void gfxAffineBlit(GFXsurface *target, GFXsurface *source, GFXaffine *affine, int left, int top, int right, int bottom, int flags, unsigned long key)
+{
+	GFXsampler sampler;
+	GFXsampleFunction sample;
+	int bytes = target->BytesPerPixel;
+	int y, first, last;
+	long long u, v;
+	if(source->BytesPerPixel != bytes)
+	{
+		return;
+	}
+	left   = max(left,   target->ClipLeft);
+	top    = max(top,    target->ClipTop);
+	right  = min(right,  target->ClipRight);
+	bottom = min(bottom, target->ClipBottom);
+	if(left >= right || top >= bottom)
+	{
+		return;
+	}
+	sampler.Bits         = source->Bits;
+	sampler.BytesPerLine = source->BytesPerLine;
+	sampler.Width        = source->Width;
+	sampler.Height       = source->Height;
+	sampler.Keyed        = (flags & GFX_AFFINE_COLORKEY) != 0;
+	sampler.Key          = key;
+	sampler.Masks[ 0 ]   = ((1UL << source->RedMaskSize) - 1) << source->RedFieldPosition;
+	sampler.Masks[ 1 ]   = ((1UL << source->GreenMaskSize) - 1) << source->GreenFieldPosition;
+	sampler.Masks[ 2 ]   = ((1UL << source->BlueMaskSize) - 1) << source->BlueFieldPosition;
+	if((flags & GFX_AFFINE_BILINEAR) && Bilinears[ bytes ])
+	{
+		sample = Bilinears[ bytes ];
+	}
+	else
+	{
+		sample = sampler.Keyed ? NearestsKeyed[ bytes ] : Nearests[ bytes ];
+	}
+	for(y = top; y < bottom; y ++)
+	{
+		u     = affine->U + (long long)affine->UX * left + (long long)affine->UY * y;
+		v     = affine->V + (long long)affine->VX * left + (long long)affine->VY * y;
+		first = 0;
+		last  = right - left;
+		gfxAffineRange(u, affine->UX, source->Width, &first, &last);
+		gfxAffineRange(v, affine->VX, source->Height, &first, &last);
+		if(first < last)
+		{
+			sample(&sampler, target->Bits + y * target->BytesPerLine + (left + first) * bytes, last - first,
+			       (long)(u + (long long)affine->UX * first), (long)(v + (long long)affine->VX * first),
+			       affine->UX, affine->VX);
+		}
+	}
+}
+
+/*
+ * gfxRotateBlit
+ *
+ *	Draws a surface rotated about its center and scaled. Angles come from a
+ *	table, so there is no trigonometry per call.
+ *
+ *	GFXsurface * target
+ *		Pointer to the surface to draw on.
+ *	GFXsurface * source
+ *		Pointer to the surface to draw, with the same pixel size.
+ *	long x, y
+ *		16.16 fixed point target position of the center of the source.
+ *	int angle
+ *		Clockwise rotation in steps of GFX_AFFINE_ANGLES to a turn.
+ *	long scaleX, scaleY
+ *		16.16 fixed point scale along the source axes, negative to mirror.
+ *	int flags
+ *		As for 'gfxAffineBlit'.
+ *	unsigned long key
+ *		As for 'gfxAffineBlit'.
+ */
+
+void gfxRotateBlit(GFXsurface *target, GFXsurface *source, long x, long y, int angle, long scaleX, long scaleY, int flags, unsigned long key)
+{
+	GFXaffine affine;
+	long s, c, dx, dy;
+	long long extentX, extentY;
+	int index;
+	if(scaleX == 0 || scaleY == 0)
+	{
+		return;
+	}
+	if(!SinesReady)
+	{
+		for(index = 0; index < GFX_AFFINE_ANGLES; index ++)
+		{
+			Sines[ index ] = (long)floor(sin(index * 2 * M_PI / GFX_AFFINE_ANGLES) * 65536.0 + 0.5);
+		}
+		SinesReady = TRUE;
+	}
+	angle = angle & (GFX_AFFINE_ANGLES - 1);
+	s = Sines[ angle ];
+	c = Sines[ (angle + GFX_AFFINE_ANGLES / 4) & (GFX_AFFINE_ANGLES - 1) ];
+	/* Inverse of the rotation followed by the inverse of the scale */
+	affine.UX = (long)(((long long)c << 16) / scaleX);
+	affine.UY = (long)(((long long)s << 16) / scaleX);
+	affine.VX = (long)(((long long)-s << 16) / scaleY);
+	affine.VY = (long)(((long long)c << 16) / scaleY);
+	/* Pixel (0, 0) is 0.5 - x, 0.5 - y from the center */
+	dx = 0x8000 - x;
+	dy = 0x8000 - y;
+	affine.U = (long)(((long long)source->Width << 15) + (((long long)affine.UX * dx + (long long)affine.UY * dy) >> 16));
+	affine.V = (long)(((long long)source->Height << 15) + (((long long)affine.VX * dx + (long long)affine.VY * dy) >> 16));
+	/* Half the size of the rotated bounding box */
+	extentX = ((long long)labs(c) * labs(scaleX) * source->Width + (long long)labs(s) * labs(scaleY) * source->Height) >> 17;
+	extentY = ((long long)labs(s) * labs(scaleX) * source->Width + (long long)labs(c) * labs(scaleY) * source->Height) >> 17;
+	gfxAffineBlit(target, source, &affine,
+	              (int)((x - extentX) >> 16) - 1, (int)((y - extentY) >> 16) - 1,
+	              (int)((x + extentX) >> 16) + 2, (int)((y + extentY) >> 16) + 2,
+	              flags, key);
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ *
+ *	Affine library
+ *
+ *	Rotated and scaled blits. Each target pixel is mapped back into the
+ *	source bitmap by an affine transform stepped in 16.16 fixed point. The
+ *	part of each target line that lands inside the source is found before
+ *	the line is drawn, so the inner loops have no bounds checks.
+ *
+ *	Sampling is nearest or bilinear, with an optional color key. Eight bit
+ *	surfaces hold palette indices, which cannot be blended, so bilinear
+ *	filtering falls back to nearest there.
+ */
+
+#ifndef affine_h
+#define affine_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Affine flags
+ *
+ ******************************************************************************/
+
+#define GFX_AFFINE_NEAREST			0x00	/* Nearest source pixel */
+#define GFX_AFFINE_BILINEAR			0x01	/* Blend the four nearest source pixels */
+#define GFX_AFFINE_COLORKEY			0x02	/* Skip source pixels equal to the key */
+
+#define GFX_AFFINE_ANGLES			1024	/* Angle steps in a whole turn */
+
+/*******************************************************************************
+ *
+ *	Affine structures
+ *
+ ******************************************************************************/
+
+/* Source position of the center of target pixel (x, y), all 16.16 fixed point:
+   u = U + UX * x + UY * y, v = V + VX * x + VY * y */
+
+typedef struct
+{
+	long U, UX, UY;
+	long V, VX, VY;
+
+} GFXaffine;
+
+/*******************************************************************************
+ *
+ *	Affine functions
+ *
+ ******************************************************************************/
+
+void gfxAffineBlit(GFXsurface *target, GFXsurface *source, GFXaffine *affine, int left, int top, int right, int bottom, int flags, unsigned long key);
+
+void gfxRotateBlit(GFXsurface *target, GFXsurface *source, long x, long y, int angle, long scaleX, long scaleY, int flags, unsigned long key);
+
+
+#endif /* affine_h */
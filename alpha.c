@@ -0,0 +1,491 @@
+/*******************************************************************************
+ *
+ *	Alpha library
+ *
+ *	Blends 32 bit ARGB images onto 15, 16, 24 and 32 bit surfaces, with the
+ *	alpha of each source pixel scaled by a constant alpha for the whole
+ *	image. Source pixels hold alpha in bits 24-31, then red, green and blue,
+ *	either straight or premultiplied by alpha. Targets are read and written
+ *	through the mask fields of their surface, as given by VBEmodeInfo.
+ *
+ *	The 5:6:5 and 8:8:8 layouts have their own loops. In C they blend two
+ *	or three color fields per multiply; with SSE2 four pixels are blended
+ *	at a time, and with MMX one pixel's fields at a time. Any other layout
+ *	goes through 'gfxUnmapRGB' and 'gfxMapRGB' for each pixel.
+ */
+
+#include "intern.h"
+#include "raster.h"
+#include "alpha.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__MMX__)
+#include <mmintrin.h>
+#endif
+
+typedef void (*GFXblendFunction)(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha);
+
+/* Target layouts with their own loops */
+
+enum
+{
+	GFX_LAYOUT_8888,
+	GFX_LAYOUT_565,
+	GFX_LAYOUT_OTHER,
+	GFX_LAYOUTS
+};
+
+/* 5:6:5 spread over 32 bits as ----gggggg-----rrrrr------bbbbb, so each field has room to grow */
+
+#define GFX_SPREAD_565			0x07E0F81FUL
+#define GFX_SPREAD_HALF			0x02008010UL	/* One half in each field, after a multiply by 0-32 */
+#define GFX_SPREAD_CARRY		0x08010020UL	/* Bit above each field */
+
+#define GFX_SPREAD(p)			((((p) & 0xFFFF) | ((p) << 16)) & GFX_SPREAD_565)
+#define GFX_UNSPREAD(p)			(((p) | ((p) >> 16)) & 0xFFFF)
+
+/* 8:8:8 to 5:6:5 */
+
+#define GFX_PACK_565(p)			((((p) >> 8) & 0xF800) | (((p) >> 5) & 0x07E0) | (((p) >> 3) & 0x001F))
+
+/*******************************************************************************
+ *
+ *	C loops
+ *
+ ******************************************************************************/
+
+/*
+ * gfxBlend8888, gfxBlend8888Pre
+ *
+ *	Red and blue are blended in one multiply and green in another. The
+ *	alpha here and below runs 0-256, so the shift by 8 is exact at both
+ *	ends. The reserved byte of the target is kept.
+ */
+
+static void gfxBlend8888(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha)
+{
+	unsigned long s, d, a;
+	for(; count > 0; count --, to += 4, from += 4)
+	{
+		s = GFX_GET_4(from);
+		a = ((s >> 24) * alpha) >> 8;
+		a = a + (a >> 7);
+		if(a == 0)
+		{
+			continue;
+		}
+		d = GFX_GET_4(to);
+		GFX_PUT_4(to, ((((s & 0xFF00FF) * a + (d & 0xFF00FF) * (256 - a)) >> 8) & 0xFF00FF) |
+		              ((((s & 0x00FF00) * a + (d & 0x00FF00) * (256 - a)) >> 8) & 0x00FF00) |
+		              (d & 0xFF000000));
+	}
+}
+
+static void gfxBlend8888Pre(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha)
+{
+	unsigned long s, d, a;
+	for(; count > 0; count --, to += 4, from += 4)
+	{
+		s = GFX_GET_4(from);
+		if(s == 0)
+		{
+			continue;
+		}
+		a = ((s >> 24) * alpha) >> 8;
+		a = a + (a >> 7);
+		d = GFX_GET_4(to);
+		GFX_PUT_4(to, ((((s & 0xFF00FF) * alpha >> 8) & 0xFF00FF) + ((((d & 0xFF00FF) * (256 - a)) >> 8) & 0xFF00FF)) |
+		              ((((s & 0x00FF00) * alpha >> 8) & 0x00FF00) + ((((d & 0x00FF00) * (256 - a)) >> 8) & 0x00FF00)) |
+		              (d & 0xFF000000));
+	}
+}
+
+/*
+ * gfxBlend565, gfxBlend565Pre
+ *
+ *	All three fields are blended at once in their spread form, with alpha
+ *	cut to 0-32 to fit the gaps between them.
+ */
+
+static void gfxBlend565(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha)
+{
+	unsigned long s, d, a;
+	for(; count > 0; count --, to += 2, from += 4)
+	{
+		s = GFX_GET_4(from);
+		a = ((((s >> 24) * alpha) >> 8) + 4) >> 3;
+		if(a == 0)
+		{
+			continue;
+		}
+		s = GFX_SPREAD(GFX_PACK_565(s));
+		d = GFX_SPREAD(GFX_GET_2(to));
+		d = ((s * a + d * (32 - a) + GFX_SPREAD_HALF) >> 5) & GFX_SPREAD_565;
+		GFX_PUT_2(to, GFX_UNSPREAD(d));
+	}
+}
+
+static void gfxBlend565Pre(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha)
+{
+	unsigned long s, d, a, scale = (alpha + 4) >> 3;
+	for(; count > 0; count --, to += 2, from += 4)
+	{
+		s = GFX_GET_4(from);
+		if(s == 0)
+		{
+			continue;
+		}
+		a = ((((s >> 24) * alpha) >> 8) + 4) >> 3;
+		s = GFX_SPREAD(GFX_PACK_565(s));
+		d = GFX_SPREAD(GFX_GET_2(to));
+		d = (((s * scale + GFX_SPREAD_HALF) >> 5) & GFX_SPREAD_565) + (((d * (32 - a) + GFX_SPREAD_HALF) >> 5) & GFX_SPREAD_565);
+		/* The source fields are cut to fewer bits than alpha, so a sum can overflow */
+		if(d & GFX_SPREAD_CARRY)
+		{
+			d |= ((d & 0x08000000) ? 0x07E00000 : 0) | ((d & 0x00010000) ? 0x0000F800 : 0) | ((d & 0x00000020) ? 0x0000001F : 0);
+			d &= GFX_SPREAD_565;
+		}
+		GFX_PUT_2(to, GFX_UNSPREAD(d));
+	}
+}
+
+/*
+ * gfxBlendOther
+ *
+ *	Any layout, a color field at a time.
+ */
+
+static unsigned long gfxGetPixel(const unsigned char *pixel, int bytes)
+{
+	switch(bytes)
+	{
+	case 2:  return GFX_GET_2(pixel);
+	case 3:  return GFX_GET_3(pixel);
+	case 4:  return GFX_GET_4(pixel);
+	default: return GFX_GET_1(pixel);
+	}
+}
+
+static void gfxPutPixel(unsigned char *pixel, int bytes, unsigned long color)
+{
+	switch(bytes)
+	{
+	case 2:  GFX_PUT_2(pixel, color); break;
+	case 3:  GFX_PUT_3(pixel, color); break;
+	case 4:  GFX_PUT_4(pixel, color); break;
+	default: GFX_PUT_1(pixel, color); break;
+	}
+}
+
+static void gfxBlendFields(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha, BOOL premultiplied)
+{
+	int bytes = target->BytesPerPixel;
+	int red, green, blue, a, keep;
+	unsigned long s;
+	for(; count > 0; count --, to += bytes, from += 4)
+	{
+		s = GFX_GET_4(from);
+		a = (int)(((s >> 24) * alpha) >> 8);
+		a = a + (a >> 7);
+		if(premultiplied ? s == 0 : a == 0)
+		{
+			continue;
+		}
+		gfxUnmapRGB(target, gfxGetPixel(to, bytes), &red, &green, &blue);
+		keep = 256 - a;
+		if(premultiplied)
+		{
+			red   = (int)((((s >> 16) & 0xFF) * alpha + red   * keep) >> 8);
+			green = (int)((((s >> 8)  & 0xFF) * alpha + green * keep) >> 8);
+			blue  = (int)(((s & 0xFF) * alpha + blue * keep) >> 8);
+		}
+		else
+		{
+			red   = (int)((((s >> 16) & 0xFF) * a + red   * keep) >> 8);
+			green = (int)((((s >> 8)  & 0xFF) * a + green * keep) >> 8);
+			blue  = (int)(((s & 0xFF) * a + blue * keep) >> 8);
+		}
+		gfxPutPixel(to, bytes, gfxMapRGB(target, min(red, 255), min(green, 255), min(blue, 255)));
+	}
+}
+
+static void gfxBlendOther(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha)
+{
+	gfxBlendFields(target, to, from, count, alpha, FALSE);
+}
+
+static void gfxBlendOtherPre(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha)
+{
+	gfxBlendFields(target, to, from, count, alpha, TRUE);
+}
+
+/*******************************************************************************
+ *
+ *	SSE2 loops
+ *
+ ******************************************************************************/
+
+#if defined(__SSE2__)
+
+/*
+ * gfxBlendSSE2
+ *
+ *	Blends two pixels held as 16 bit lanes, blue, green, red and alpha.
+ *	Alpha is 0-255 here, with (x + 128 + ((x + 128) >> 8)) >> 8 dividing
+ *	by 255 exactly for the products that can occur.
+ */
+
+static __inline__ __m128i gfxBlendSSE2(__m128i s, __m128i d, __m128i scale, BOOL premultiplied)
+{
+	__m128i full = _mm_set1_epi16(255), round = _mm_set1_epi16(128);
+	__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+	__m128i x;
+	a = _mm_srli_epi16(_mm_mullo_epi16(a, scale), 8);
+	if(premultiplied)
+	{
+		s = _mm_srli_epi16(_mm_mullo_epi16(s, scale), 8);
+		x = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(full, a)), round);
+		x = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+		return _mm_add_epi16(s, x);
+	}
+	x = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(full, a))), round);
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+/* Four 8:8:8 pixels at a time, keeping the reserved bytes of the target, the rest in C */
+
+#define GFX_BLEND_8888_SSE2(name, premultiplied, tail) \
+static void name(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha) \
+{ \
+	__m128i zero = _mm_setzero_si128(), scale = _mm_set1_epi16(alpha), rgb = _mm_set1_epi32(0x00FFFFFF), s, d, x; \
+	for(; count >= 4; count -= 4, to += 16, from += 16) \
+	{ \
+		s = _mm_loadu_si128((const __m128i *)from); \
+		d = _mm_loadu_si128((const __m128i *)to); \
+		x = _mm_packus_epi16(gfxBlendSSE2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), scale, premultiplied), \
+		                     gfxBlendSSE2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), scale, premultiplied)); \
+		_mm_storeu_si128((__m128i *)to, _mm_or_si128(_mm_and_si128(x, rgb), _mm_andnot_si128(rgb, d))); \
+	} \
+	tail(target, to, from, count, alpha); \
+}
+
+/* Four 5:6:5 pixels at a time, widened to 8:8:8 and back, the rest in C */
+
+#define GFX_BLEND_565_SSE2(name, premultiplied, tail) \
+static void name(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha) \
+{ \
+	__m128i zero = _mm_setzero_si128(), scale = _mm_set1_epi16(alpha), s, d, r, g, b; \
+	__m128i five = _mm_set1_epi32(0x1F), six = _mm_set1_epi32(0x3F); \
+	for(; count >= 4; count -= 4, to += 8, from += 16) \
+	{ \
+		s = _mm_loadu_si128((const __m128i *)from); \
+		d = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)to), zero); \
+		r = _mm_and_si128(_mm_srli_epi32(d, 11), five); \
+		g = _mm_and_si128(_mm_srli_epi32(d, 5), six); \
+		b = _mm_and_si128(d, five); \
+		r = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2)); \
+		g = _mm_or_si128(_mm_slli_epi32(g, 2), _mm_srli_epi32(g, 4)); \
+		b = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2)); \
+		d = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(g, 8)), b); \
+		d = _mm_packus_epi16(gfxBlendSSE2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), scale, premultiplied), \
+		                     gfxBlendSSE2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), scale, premultiplied)); \
+		d = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(d, 8), _mm_set1_epi32(0xF800)), \
+		                              _mm_and_si128(_mm_srli_epi32(d, 5), _mm_set1_epi32(0x07E0))), \
+		                 _mm_and_si128(_mm_srli_epi32(d, 3), _mm_set1_epi32(0x001F))); \
+		/* Sign extend so the signed pack keeps all 16 bits */ \
+		d = _mm_srai_epi32(_mm_slli_epi32(d, 16), 16); \
+		_mm_storel_epi64((__m128i *)to, _mm_packs_epi32(d, d)); \
+	} \
+	tail(target, to, from, count, alpha); \
+}
+
+GFX_BLEND_8888_SSE2(gfxBlend8888SSE2,    FALSE, gfxBlend8888)
+GFX_BLEND_8888_SSE2(gfxBlend8888PreSSE2, TRUE,  gfxBlend8888Pre)
+GFX_BLEND_565_SSE2(gfxBlend565SSE2,      FALSE, gfxBlend565)
+GFX_BLEND_565_SSE2(gfxBlend565PreSSE2,   TRUE,  gfxBlend565Pre)
+
+#define GFX_BLEND_8888			gfxBlend8888SSE2
+#define GFX_BLEND_8888_PRE		gfxBlend8888PreSSE2
+#define GFX_BLEND_565			gfxBlend565SSE2
+#define GFX_BLEND_565_PRE		gfxBlend565PreSSE2
+
+/*******************************************************************************
+ *
+ *	MMX loops
+ *
+ ******************************************************************************/
+
+#elif defined(__MMX__)
+
+/*
+ * gfxBlendMMX
+ *
+ *	As 'gfxBlendSSE2' for one pixel. MMX has no word shuffle, so alpha is
+ *	spread to the four lanes by unpacking.
+ */
+
+static __inline__ __m64 gfxBlendMMX(__m64 s, __m64 d, __m64 scale, BOOL premultiplied)
+{
+	__m64 full = _mm_set1_pi16(255), round = _mm_set1_pi16(128);
+	__m64 a = _mm_srli_si64(s, 48), x;
+	a = _mm_unpacklo_pi16(a, a);
+	a = _mm_unpacklo_pi32(a, a);
+	a = _mm_srli_pi16(_mm_mullo_pi16(a, scale), 8);
+	if(premultiplied)
+	{
+		s = _mm_srli_pi16(_mm_mullo_pi16(s, scale), 8);
+		x = _mm_add_pi16(_mm_mullo_pi16(d, _mm_sub_pi16(full, a)), round);
+		x = _mm_srli_pi16(_mm_add_pi16(x, _mm_srli_pi16(x, 8)), 8);
+		return _mm_add_pi16(s, x);
+	}
+	x = _mm_add_pi16(_mm_add_pi16(_mm_mullo_pi16(s, a), _mm_mullo_pi16(d, _mm_sub_pi16(full, a))), round);
+	return _mm_srli_pi16(_mm_add_pi16(x, _mm_srli_pi16(x, 8)), 8);
+}
+
+#define GFX_BLEND_8888_MMX(name, premultiplied) \
+static void name(GFXsurface *target, unsigned char *to, const unsigned char *from, int count, int alpha) \
+{ \
+	__m64 zero = _mm_setzero_si64(), scale = _mm_set1_pi16(alpha), s, d; \
+	for(; count > 0; count --, to += 4, from += 4) \
+	{ \
+		s = _mm_unpacklo_pi8(_mm_cvtsi32_si64((int)GFX_GET_4(from)), zero); \
+		d = _mm_unpacklo_pi8(_mm_cvtsi32_si64((int)GFX_GET_4(to)), zero); \
+		d = _mm_packs_pu16(gfxBlendMMX(s, d, scale, premultiplied), zero); \
+		GFX_PUT_4(to, ((unsigned long)_mm_cvtsi64_si32(d) & 0x00FFFFFF) | (GFX_GET_4(to) & 0xFF000000)); \
+	} \
+	_mm_empty(); \
+}
+
+GFX_BLEND_8888_MMX(gfxBlend8888MMX,    FALSE)
+GFX_BLEND_8888_MMX(gfxBlend8888PreMMX, TRUE)
+
+#define GFX_BLEND_8888			gfxBlend8888MMX
+#define GFX_BLEND_8888_PRE		gfxBlend8888PreMMX
+#define GFX_BLEND_565			gfxBlend565
+#define GFX_BLEND_565_PRE		gfxBlend565Pre
+
+#else
+
+#define GFX_BLEND_8888			gfxBlend8888
+#define GFX_BLEND_8888_PRE		gfxBlend8888Pre
+#define GFX_BLEND_565			gfxBlend565
+#define GFX_BLEND_565_PRE		gfxBlend565Pre
+
+#endif
+
+/* Indexed by layout and premultiplied */
+
+static GFXblendFunction Blends[GFX_LAYOUTS][2] =
+{
+	{ GFX_BLEND_8888, GFX_BLEND_8888_PRE },
+	{ GFX_BLEND_565,  GFX_BLEND_565_PRE  },
+	{ gfxBlendOther,  gfxBlendOtherPre   }
+};
+
+/*******************************************************************************
+ *
+ *	Alpha functions
+ *
+ ******************************************************************************/
+
+static int gfxLayout(GFXsurface *surface)
+{
+	if(surface->BytesPerPixel == 4 &&
+	   surface->RedMaskSize   == 8 && surface->RedFieldPosition   == 16 &&
+	   surface->GreenMaskSize == 8 && surface->GreenFieldPosition == 8 &&
+	   surface->BlueMaskSize  == 8 && surface->BlueFieldPosition  == 0)
+	{
+		return GFX_LAYOUT_8888;
+	}
+	if(surface->BytesPerPixel == 2 &&
+	   surface->RedMaskSize   == 5 && surface->RedFieldPosition   == 11 &&
+	   surface->GreenMaskSize == 6 && surface->GreenFieldPosition == 5 &&
+	   surface->BlueMaskSize  == 5 && surface->BlueFieldPosition  == 0)
+	{
+		return GFX_LAYOUT_565;
+	}
+	return GFX_LAYOUT_OTHER;
+}
+
+/*
+ * gfxAlphaBlit
+ *
+ *	Blends a rectangle of an ARGB surface onto a direct color surface.
+ *
+ *	GFXsurface * target
+ *		Pointer to the surface to draw on, 15, 16, 24 or 32 bits.
+ *	GFXsurface * source
+ *		Pointer to the 32 bit ARGB surface to blend.
+ *	int left, top
+ *		Top left corner of the source rectangle.
+ *	int width, height
+ *		Size in pixels.
+ *	int dstLeft, dstTop
+ *		Top left corner of the target rectangle, clipped to the clip
+ *		rectangle of the target.
+ *	int alpha
+ *		Constant alpha 0-255 multiplying the alpha of every source pixel,
+ *		GFX_ALPHA_OPAQUE to use the source alpha alone.
+ *	int flags
+ *		How the source colors are stored.
+ *			GFX_ALPHA_STRAIGHT
+ *			GFX_ALPHA_PREMULTIPLIED
+ */
+
+void gfxAlphaBlit(GFXsurface *target, GFXsurface *source, int left, int top, int width, int height, int dstLeft, int dstTop, int alpha, int flags)
+{
+	GFXblendFunction blend;
+	int cut, row;
+	const unsigned char *from;
+	unsigned char *to;
+	if(source->BytesPerPixel != 4 || target->BytesPerPixel < 2 || alpha <= 0)
+	{
+		return;
+	}
+	/* Clip to the source, then to the target */
+	if(left < 0)
+	{
+		width   += left;
+		dstLeft -= left;
+		left     = 0;
+	}
+	if(top < 0)
+	{
+		height += top;
+		dstTop -= top;
+		top     = 0;
+	}
+	width  = min(width,  source->Width - left);
+	height = min(height, source->Height - top);
+	cut = target->ClipLeft - dstLeft;
+	if(cut > 0)
+	{
+		width   -= cut;
+		left    += cut;
+		dstLeft += cut;
+	}
+	cut = target->ClipTop - dstTop;
+	if(cut > 0)
+	{
+		height -= cut;
+		top    += cut;
+		dstTop += cut;
+	}
+	width  = min(width,  target->ClipRight - dstLeft);
+	height = min(height, target->ClipBottom - dstTop);
+	if(width <= 0 || height <= 0)
+	{
+		return;
+	}
+	/* 0-256 from here on */
+	alpha = min(alpha, 255);
+	alpha = alpha + (alpha >> 7);
+	blend = Blends[ gfxLayout(target) ][ (flags & GFX_ALPHA_PREMULTIPLIED) ? 1 : 0 ];
+	from  = source->Bits + top * source->BytesPerLine + left * 4;
+	to    = target->Bits + dstTop * target->BytesPerLine + dstLeft * target->BytesPerPixel;
+	for(row = 0; row < height; row ++, from += source->BytesPerLine, to += target->BytesPerLine)
+	{
+		blend(target, to, from, width, alpha);
+	}
+}
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ *
+ *	Alpha library
+ *
+ *	Blends 32 bit ARGB images onto 15, 16, 24 and 32 bit surfaces, with the
+ *	alpha of each source pixel scaled by a constant alpha for the whole
+ *	image. Source pixels hold alpha in bits 24-31, then red, green and blue,
+ *	either straight or premultiplied by alpha. Targets are read and written
+ *	through the mask fields of their surface, as given by VBEmodeInfo.
+ *
+ *	The 5:6:5 and 8:8:8 layouts have their own loops, using SSE2 or MMX
+ *	when the compiler is targeting them.
+ */
+
+#ifndef alpha_h
+#define alpha_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Alpha flags
+ *
+ ******************************************************************************/
+
+#define GFX_ALPHA_STRAIGHT			0x00	/* Source colors not multiplied by alpha */
+#define GFX_ALPHA_PREMULTIPLIED			0x01	/* Source colors already multiplied by alpha */
+
+#define GFX_ALPHA_OPAQUE			255	/* Constant alpha leaving per pixel alpha unchanged */
+
+/*******************************************************************************
+ *
+ *	Alpha functions
+ *
+ ******************************************************************************/
+
+void gfxAlphaBlit(GFXsurface *target, GFXsurface *source, int left, int top, int width, int height, int dstLeft, int dstTop, int alpha, int flags);
+
+
+#endif /* alpha_h */
@@ -0,0 +1,327 @@
+/*******************************************************************************
+ *
+ *	Blit library
+ *
+ *	Software versions of the BitBlt and TransBlt entry points of the
+ *	accelerator interface, for 8, 15, 16, 24 and 32 bit surfaces. Copies
+ *	within a surface may overlap in any direction. Every mix mode is a
+ *	separate inner loop, so the copy and color key loops test nothing but
+ *	the key for each pixel.
+ *
+ *	Opaque AND, OR and XOR work on bytes, four at a time, since bitwise
+ *	mixes do not see pixel boundaries. Transparent blits compare whole
+ *	pixels, so they are written once for each pixel size and mix.
+ *
+ *	Based on the official specification
+ *	http://www.vesa.org/public/VBE/vbeaf.pdf
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "blit.h"
+
+/* Mix a source pixel s into a target pixel d */
+
+#define GFX_OP_REPLACE(d, s)		(s)
+#define GFX_OP_AND(d, s)		((d) & (s))
+#define GFX_OP_OR(d, s)			((d) | (s))
+#define GFX_OP_XOR(d, s)		((d) ^ (s))
+
+/*******************************************************************************
+ *
+ *	Opaque rows
+ *
+ ******************************************************************************/
+
+/*
+ * gfxMixRow
+ *
+ *	Mixes a row of bytes working forwards, which is safe when the target
+ *	is not after the source on the same line.
+ */
+
+#define GFX_MIX_ROW(name, op) \
+static void name(unsigned char *to, const unsigned char *from, int length) \
+{ \
+	for(; length >= 4; length -= 4, to += 4, from += 4) \
+	{ \
+		GFX_PUT_4(to, op(GFX_GET_4(to), GFX_GET_4(from))); \
+	} \
+	for(; length > 0; length --, to ++, from ++) \
+	{ \
+		*to = op(*to, *from); \
+	} \
+}
+
+/*
+ * gfxMixRowBack
+ *
+ *	Mixes a row of bytes working backwards, for a target after the source
+ *	on the same line.
+ */
+
+#define GFX_MIX_ROW_BACK(name, op) \
+static void name(unsigned char *to, const unsigned char *from, int length) \
+{ \
+	to   += length; \
+	from += length; \
+	for(; length > 0; length --) \
+	{ \
+		to --; \
+		from --; \
+		*to = op(*to, *from); \
+	} \
+}
+
+GFX_MIX_ROW(gfxMixAnd, GFX_OP_AND)
+GFX_MIX_ROW(gfxMixOr,  GFX_OP_OR)
+GFX_MIX_ROW(gfxMixXor, GFX_OP_XOR)
+
+GFX_MIX_ROW_BACK(gfxMixBackAnd, GFX_OP_AND)
+GFX_MIX_ROW_BACK(gfxMixBackOr,  GFX_OP_OR)
+GFX_MIX_ROW_BACK(gfxMixBackXor, GFX_OP_XOR)
+
+/* Indexed by mix, replace is a memmove */
+
+static void (*MixRows[GFX_MIX_NOP])(unsigned char *to, const unsigned char *from, int length) =
+{
+	NULL, gfxMixAnd, gfxMixOr, gfxMixXor
+};
+
+static void (*MixRowsBack[GFX_MIX_NOP])(unsigned char *to, const unsigned char *from, int length) =
+{
+	NULL, gfxMixBackAnd, gfxMixBackOr, gfxMixBackXor
+};
+
+/*******************************************************************************
+ *
+ *	Transparent rows
+ *
+ ******************************************************************************/
+
+/*
+ * gfxTransRow
+ *
+ *	Mixes the pixels of a row that are not the transparent color. The step
+ *	is the pixel size, negative to work backwards.
+ */
+
+#define GFX_TRANS_ROW(name, bytes, op) \
+static void name(unsigned char *to, const unsigned char *from, int count, int step, unsigned long transparent) \
+{ \
+	unsigned long color; \
+	for(; count > 0; count --, to += step, from += step) \
+	{ \
+		color = GFX_GET_##bytes(from); \
+		if(color != transparent) \
+		{ \
+			GFX_PUT_##bytes(to, op(GFX_GET_##bytes(to), color)); \
+		} \
+	} \
+}
+
+#define GFX_TRANS_ROWS(mix, op) \
+GFX_TRANS_ROW(gfxTrans##mix##1, 1, op) \
+GFX_TRANS_ROW(gfxTrans##mix##2, 2, op) \
+GFX_TRANS_ROW(gfxTrans##mix##3, 3, op) \
+GFX_TRANS_ROW(gfxTrans##mix##4, 4, op)
+
+GFX_TRANS_ROWS(Replace, GFX_OP_REPLACE)
+GFX_TRANS_ROWS(And,     GFX_OP_AND)
+GFX_TRANS_ROWS(Or,      GFX_OP_OR)
+GFX_TRANS_ROWS(Xor,     GFX_OP_XOR)
+
+/* Indexed by mix and bytes per pixel */
+
+static void (*TransRows[GFX_MIX_NOP][5])(unsigned char *to, const unsigned char *from, int count, int step, unsigned long transparent) =
+{
+	{ NULL, gfxTransReplace1, gfxTransReplace2, gfxTransReplace3, gfxTransReplace4 },
+	{ NULL, gfxTransAnd1,     gfxTransAnd2,     gfxTransAnd3,     gfxTransAnd4     },
+	{ NULL, gfxTransOr1,      gfxTransOr2,      gfxTransOr3,      gfxTransOr4      },
+	{ NULL, gfxTransXor1,     gfxTransXor2,     gfxTransXor3,     gfxTransXor4     }
+};
+
+/*******************************************************************************
+ *
+ *	Blits
+ *
+ ******************************************************************************/
+
+/*
+ * gfxBlit
+ *
+ *	Clips a blit to the source surface and to the clip rectangle of the
+ *	target, then picks the order to go through it. When the target lies
+ *	after the source in the same memory the lines are done from the bottom
+ *	up, and on a shared line the pixels from right to left, so nothing is
+ *	overwritten before it is read.
+ */
+
+static void gfxBlit(GFXsurface *target, GFXsurface *source, int left, int top, int width, int height,
+                    int dstLeft, int dstTop, int mix, BOOL keyed, unsigned long transparent)
+{
+	int bytes = target->BytesPerPixel;
+	int fromPitch = source->BytesPerLine, toPitch = target->BytesPerLine;
+	int cut, length, row;
+	BOOL backward;
+	unsigned char *from, *to;
+	if(mix < 0 || mix >= GFX_MIX_NOP || source->BytesPerPixel != bytes)
+	{
+		return;
+	}
+	/* Clip to the source */
+	if(left < 0)
+	{
+		width   += left;
+		dstLeft -= left;
+		left     = 0;
+	}
+	if(top < 0)
+	{
+		height += top;
+		dstTop -= top;
+		top     = 0;
+	}
+	width  = min(width,  source->Width - left);
+	height = min(height, source->Height - top);
+	/* Clip to the target */
+	cut = target->ClipLeft - dstLeft;
+	if(cut > 0)
+	{
+		width   -= cut;
+		left    += cut;
+		dstLeft += cut;
+	}
+	cut = target->ClipTop - dstTop;
+	if(cut > 0)
+	{
+		height -= cut;
+		top    += cut;
+		dstTop += cut;
+	}
+	width  = min(width,  target->ClipRight - dstLeft);
+	height = min(height, target->ClipBottom - dstTop);
+	if(width <= 0 || height <= 0)
+	{
+		return;
+	}
+	from     = source->Bits + top * fromPitch + left * bytes;
+	to       = target->Bits + dstTop * toPitch + dstLeft * bytes;
+	length   = width * bytes;
+	backward = FALSE;
+	if(source->Bits == target->Bits && to > from)
+	{
+		if(top == dstTop)
+		{
+			backward = TRUE;
+		}
+		else
+		{
+			from     += (height - 1) * fromPitch;
+			to       += (height - 1) * toPitch;
+			fromPitch = -fromPitch;
+			toPitch   = -toPitch;
+		}
+	}
+	for(row = 0; row < height; row ++, from += fromPitch, to += toPitch)
+	{
+		if(keyed)
+		{
+			if(backward)
+			{
+				TransRows[ mix ][ bytes ](to + length - bytes, from + length - bytes, width, -bytes, transparent);
+			}
+			else
+			{
+				TransRows[ mix ][ bytes ](to, from, width, bytes, transparent);
+			}
+		}
+		else if(mix == GFX_MIX_REPLACE)
+		{
+			memmove(to, from, length);
+		}
+		else if(backward)
+		{
+			MixRowsBack[ mix ](to, from, length);
+		}
+		else
+		{
+			MixRows[ mix ](to, from, length);
+		}
+	}
+}
+
+/*
+ * gfxBitBlt
+ *
+ *	Copies a rectangle within a surface, mixing it into what is there. The
+ *	rectangles may overlap.
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface.
+ *	int left, top
+ *		Top left corner of the source rectangle.
+ *	int width, height
+ *		Size in pixels.
+ *	int dstLeft, dstTop
+ *		Top left corner of the target rectangle.
+ *	int mix
+ *		How to combine the pixels.
+ *			GFX_MIX_REPLACE
+ *			GFX_MIX_AND
+ *			GFX_MIX_OR
+ *			GFX_MIX_XOR
+ *			GFX_MIX_NOP
+ */
+
+void gfxBitBlt(GFXsurface *surface, int left, int top, int width, int height, int dstLeft, int dstTop, int mix)
+{
+	gfxBlit(surface, surface, left, top, width, height, dstLeft, dstTop, mix, FALSE, 0);
+}
+
+/*
+ * gfxBitBltLinear
+ *
+ *	Copies a rectangle from another surface, such as a bitmap in system
+ *	memory, as 'gfxBitBlt'. The surfaces must have the same pixel size.
+ *
+ *	GFXsurface * target
+ *		Pointer to the surface to draw on.
+ *	GFXsurface * source
+ *		Pointer to the surface to copy from.
+ */
+
+void gfxBitBltLinear(GFXsurface *target, GFXsurface *source, int left, int top, int width, int height, int dstLeft, int dstTop, int mix)
+{
+	gfxBlit(target, source, left, top, width, height, dstLeft, dstTop, mix, FALSE, 0);
+}
+
+/*
+ * gfxTransBlt
+ *
+ *	As 'gfxBitBlt', leaving the target unchanged where the source is the
+ *	transparent color.
+ *
+ *	unsigned long transparent
+ *		Pixel value of the transparent color.
+ */
+
+void gfxTransBlt(GFXsurface *surface, int left, int top, int width, int height, int dstLeft, int dstTop, int mix, unsigned long transparent)
+{
+	gfxBlit(surface, surface, left, top, width, height, dstLeft, dstTop, mix, TRUE, transparent);
+}
+
+/*
+ * gfxTransBltLinear
+ *
+ *	As 'gfxBitBltLinear', leaving the target unchanged where the source is
+ *	the transparent color.
+ */
+
+void gfxTransBltLinear(GFXsurface *target, GFXsurface *source, int left, int top, int width, int height, int dstLeft, int dstTop, int mix, unsigned long transparent)
+{
+	gfxBlit(target, source, left, top, width, height, dstLeft, dstTop, mix, TRUE, transparent);
+}
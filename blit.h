@@ -0,0 +1,50 @@
+/*******************************************************************************
+ *
+ *	Blit library
+ *
+ *	Software versions of the BitBlt and TransBlt entry points of the
+ *	accelerator interface, for 8, 15, 16, 24 and 32 bit surfaces. Copies
+ *	within a surface may overlap in any direction. Every mix mode is a
+ *	separate inner loop, so the copy and color key loops test nothing but
+ *	the key for each pixel.
+ *
+ *	Based on the official specification
+ *	http://www.vesa.org/public/VBE/vbeaf.pdf
+ */
+
+#ifndef blit_h
+#define blit_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Blit flags
+ *
+ ******************************************************************************/
+
+/* Mix modes, with the values of AFmixMode */
+
+#define GFX_MIX_REPLACE				0	/* Replace target with incoming pixel */
+#define GFX_MIX_AND				1	/* Bitwise AND the pixels together */
+#define GFX_MIX_OR				2	/* Bitwise OR target with incoming pixel */
+#define GFX_MIX_XOR				3	/* Exclusive OR target with incoming pixel */
+#define GFX_MIX_NOP				4	/* Destination pixel unchanged */
+
+/*******************************************************************************
+ *
+ *	Blit functions
+ *
+ ******************************************************************************/
+
+void gfxBitBlt(GFXsurface *surface, int left, int top, int width, int height, int dstLeft, int dstTop, int mix);
+
+void gfxBitBltLinear(GFXsurface *target, GFXsurface *source, int left, int top, int width, int height, int dstLeft, int dstTop, int mix);
+
+void gfxTransBlt(GFXsurface *surface, int left, int top, int width, int height, int dstLeft, int dstTop, int mix, unsigned long transparent);
+
+void gfxTransBltLinear(GFXsurface *target, GFXsurface *source, int left, int top, int width, int height, int dstLeft, int dstTop, int mix, unsigned long transparent);
+
+
+#endif /* blit_h */
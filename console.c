@@ -0,0 +1,565 @@
+/*******************************************************************************
+ *
+ *	Console Stream library
+ *
+ *	Buffered text console for high volume logging in text modes. Characters
+ *	are queued in a ring and rendered straight into text memory at a capped
+ *	rate, with bursts of new lines collapsed into a single scroll.
+ *
+ *	Optionally the console can treat text memory as a circular buffer and
+ *	scroll by moving the CRTC start address, using the line compare register
+ *	to wrap the display back to the start of the buffer.
+ *
+ *	Additional information provided by FreeVGA & J.D.Neal
+ *	http://www.osdever.net/FreeVGA/home.htm
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include "farseg.h"
+#include "VGA.h"
+#include "VGAio.h"
+#include "console.h"
+
+/*******************************************************************************
+ *
+ *	Rendering
+ *
+ ******************************************************************************/
+
+/*
+ * conRowAddress
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	int row
+ *		A row of the display.
+ *	returns
+ *		Linear address of the row in text memory. With hardware scrolling
+ *		the rows are taken from the ring starting at the top row.
+ */
+
+static unsigned long conRowAddress(CONstream *stream, int row)
+{
+	return stream->Base + ((stream->Top + row) % stream->Lines) * stream->Columns * 2;
+}
+
+/*
+ * conProgram
+ *
+ *	Points the CRTC at the top row of the ring. If the display runs past the
+ *	end of the ring the line compare register splits the screen where it
+ *	does, and the remaining rows are shown from the start of text memory.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ */
+
+static void conProgram(CONstream *stream)
+{
+	int split = CON_NO_SPLIT;
+	if(stream->Top + stream->Rows > stream->Lines)
+	{
+		split = (stream->Lines - stream->Top) * stream->CharHeight - 1;
+	}
+	vgaSetStartAddress(stream->Top * stream->Columns);
+	vgaSetLineCompare(split);
+}
+
+/*
+ * conPlaceCursor
+ *
+ *	Moves the text cursor to the stream position.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ */
+
+static void conPlaceCursor(CONstream *stream)
+{
+	if(stream->Pages > 0)
+	{
+		if(stream->Visible)
+		{
+			int row = (stream->Top + stream->Row) % stream->Lines;
+			vgaSetCursorLocation(row * stream->Columns + stream->Column);
+		}
+	}
+	else
+	{
+		vgaSetCursorPosition(stream->Page, stream->Row, stream->Column);
+	}
+}
+
+/*
+ * conScrollHardware
+ *
+ *	Scrolls the display up by moving its start down the ring. Only the rows
+ *	that come into view at the bottom are written, they are cleared.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	int lines
+ *		Number of rows to scroll.
+ */
+
+static void conScrollHardware(CONstream *stream, int lines)
+{
+	int row, column;
+	int first = lines < stream->Rows ? stream->Rows - lines : 0;
+	unsigned short blank = ' ' | (stream->Color << 8);
+	stream->Top = (stream->Top + lines) % stream->Lines;
+	_farsetsel(_dos_ds);
+	for(row = first; row < stream->Rows; row ++)
+	{
+		unsigned long address = conRowAddress(stream, row);
+		for(column = 0; column < stream->Columns; column ++)
+		{
+			_farnspokew(address + column * 2, blank);
+		}
+	}
+	if(stream->Visible)
+	{
+		conProgram(stream);
+	}
+}
+
+/*
+ * conLayout
+ *
+ *	Walks the pending characters with the same rules as the BIOS teletype.
+ *	When 'scroll' is negative nothing is drawn and the ring is untouched, so
+ *	the caller can learn how far the cursor will travel. Otherwise every
+ *	character is written 'scroll' rows above where it was laid out, dropping
+ *	those that would have scrolled off the top, and the ring is consumed.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	int scroll
+ *		Rows the page has been scrolled before drawing, or -1 to measure.
+ *	returns
+ *		The row the cursor ends on, unscrolled.
+ */
+
+static int conLayout(CONstream *stream, int scroll)
+{
+	int head   = stream->Head;
+	int row    = stream->Row;
+	int column = stream->Column;
+	int mask   = stream->Size - 1;
+	if(scroll >= 0)
+	{
+		_farsetsel(_dos_ds);
+	}
+	while(head != stream->Tail)
+	{
+		unsigned char ascii = stream->Ring[ head ];
+		head = (head + 1) & mask;
+		switch(ascii)
+		{
+		case '\n':
+			column = 0;
+			row ++;
+			break;
+		case '\r':
+			column = 0;
+			break;
+		case '\b':
+			if(column > 0) column --;
+			break;
+		case '\t':
+			column = (column + CON_TAB_SIZE) & ~(CON_TAB_SIZE - 1);
+			break;
+		case '\a':
+			break;
+		default:
+			if(scroll >= 0 && row >= scroll)
+			{
+				/* Write character and attribute in one word */
+				unsigned long address = conRowAddress(stream, row - scroll);
+				_farnspokew(address + column * 2, ascii | (stream->Color << 8));
+			}
+			column ++;
+			break;
+		}
+		/* Wrap at the end of the line */
+		if(column >= stream->Columns)
+		{
+			column = 0;
+			row ++;
+		}
+	}
+	if(scroll >= 0)
+	{
+		stream->Head   = head;
+		stream->Row    = row - scroll;
+		stream->Column = column;
+	}
+	return row;
+}
+
+/*
+ * conRender
+ *
+ *	Renders every pending character. The number of rows the text runs past
+ *	the bottom of the page is found first so the page is scrolled only once,
+ *	however many new lines there were. With hardware scrolling this costs
+ *	a few register writes plus clearing the rows that come into view.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ */
+
+static void conRender(CONstream *stream)
+{
+	int scroll = conLayout(stream, -1) - (stream->Rows - 1);
+	if(scroll <= 0)
+	{
+		scroll = 0;
+	}
+	else if(stream->Pages > 0)
+	{
+		conScrollHardware(stream, scroll);
+	}
+	else
+	{
+		/* Scrolling zero lines clears the whole window */
+		int lines = scroll < stream->Rows ? scroll : 0;
+		vgaScrollActivePageUp(lines, stream->Color, 0, 0, stream->Rows - 1, stream->Columns - 1);
+	}
+	conLayout(stream, scroll);
+	conPlaceCursor(stream);
+	stream->LastRender = uclock();
+}
+
+/*******************************************************************************
+ *
+ *	Console Stream functions
+ *
+ ******************************************************************************/
+
+/*
+ * conCreate
+ *
+ *	Prepares a console stream on a text page of the current mode, starting
+ *	from the page's cursor position.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure to initialize.
+ *	int page
+ *		The text page to write on. Scrolling is done by the BIOS, which
+ *		only scrolls the active display page.
+ *	int color
+ *		Attribute given to new characters and to cleared lines.
+ *	int size
+ *		Number of characters that may be pending, rounded up to a power
+ *		of two, or zero for CON_DEFAULT_SIZE.
+ *	returns
+ *		True if the ring could be allocated.
+ */
+
+BOOL conCreate(CONstream *stream, int page, int color, int size)
+{
+	int ringSize = 16;
+	if(size <= 0) size = CON_DEFAULT_SIZE;
+	while(ringSize < size) ringSize <<= 1;
+	stream->Ring = malloc(ringSize);
+	if(!stream->Ring)
+	{
+		return FALSE;
+	}
+	stream->Size  = ringSize;
+	stream->Head  = 0;
+	stream->Tail  = 0;
+	stream->Page  = page;
+	stream->Color = color;
+	/* Read the text geometry from the BIOS data area */
+	stream->Columns = _farpeekw(_dos_ds, CON_BIOS_COLUMNS);
+	stream->Rows    = _farpeekb(_dos_ds, CON_BIOS_ROWS) + 1;
+	stream->Base    = vgaIsColorMode() ? CON_COLOR_TEXT_MEMORY : CON_MONO_TEXT_MEMORY;
+	stream->Base   += page * _farpeekw(_dos_ds, CON_BIOS_PAGE_SIZE);
+	stream->CharHeight = _farpeekw(_dos_ds, CON_BIOS_CHAR_HEIGHT);
+	/* BIOS scrolling until told otherwise */
+	stream->Pages   = 0;
+	stream->Lines   = stream->Rows;
+	stream->Top     = 0;
+	stream->Visible = TRUE;
+	vgaGetCursorPosition(page, &stream->Row, &stream->Column, NULL, NULL);
+	conSetRate(stream, CON_DEFAULT_RATE);
+	stream->LastRender = uclock();
+	return TRUE;
+}
+
+/*
+ * conDestroy
+ *
+ *	Renders anything still pending and releases the ring.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ */
+
+void conDestroy(CONstream *stream)
+{
+	conFlush(stream);
+	free(stream->Ring);
+	stream->Ring = NULL;
+}
+
+/*
+ * conSetRate
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	int rate
+ *		Maximum number of renders per second. Zero renders on every
+ *		complete line.
+ */
+
+void conSetRate(CONstream *stream, int rate)
+{
+	stream->Interval = rate > 0 ? UCLOCKS_PER_SEC / rate : 0;
+}
+
+/*
+ * conSetColor
+ *
+ *	Changes the attribute of characters written from now on. Pending text is
+ *	rendered first so it keeps the attribute it was written with.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	int color
+ *		Attribute given to new characters and to cleared lines.
+ */
+
+void conSetColor(CONstream *stream, int color)
+{
+	if(color != stream->Color)
+	{
+		conFlush(stream);
+		stream->Color = color;
+	}
+}
+
+/*
+ * conPutChar
+ *
+ *	Queues a single character. Rendering only happens if the ring is full,
+ *	so call 'conUpdate' or 'conFlush' to get it on the display.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	char ascii
+ *		The character to write.
+ */
+
+void conPutChar(CONstream *stream, char ascii)
+{
+	int next = (stream->Tail + 1) & (stream->Size - 1);
+	if(next == stream->Head)
+	{
+		/* Ring is full so make room */
+		conRender(stream);
+	}
+	stream->Ring[ stream->Tail ] = ascii;
+	stream->Tail = next;
+}
+
+/*
+ * conWrite
+ *
+ *	Queues a string of characters and renders if a line was completed and
+ *	the render interval has passed.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	const char * string
+ *		Characters to write.
+ *	int length
+ *		Number of characters in 'string'.
+ *	returns
+ *		The number of characters written.
+ */
+
+int conWrite(CONstream *stream, const char *string, int length)
+{
+	BOOL line = FALSE;
+	int index;
+	for(index = 0; index < length; index ++)
+	{
+		conPutChar(stream, string[ index ]);
+		if(string[ index ] == '\n') line = TRUE;
+	}
+	if(line)
+	{
+		conUpdate(stream);
+	}
+	return length;
+}
+
+/*
+ * conPrintf
+ *
+ *	Formats a string as printf does and writes it to the stream.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	returns
+ *		The number of characters written.
+ */
+
+int conPrintf(CONstream *stream, const char *format, ...)
+{
+	char buffer[256];
+	int length;
+	va_list args;
+	va_start(args, format);
+	length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	if(length < 0)
+	{
+		return -1;
+	}
+	if(length >= (int)sizeof(buffer))
+	{
+		length = (int)sizeof(buffer) - 1;
+	}
+	return conWrite(stream, buffer, length);
+}
+
+/*
+ * conUpdate
+ *
+ *	Renders pending characters if the render interval has passed since the
+ *	last render. Call this periodically so text gets displayed during quiet
+ *	periods.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	returns
+ *		True if the display was updated.
+ */
+
+BOOL conUpdate(CONstream *stream)
+{
+	if(stream->Head != stream->Tail)
+	{
+		if(uclock() - stream->LastRender >= stream->Interval)
+		{
+			conRender(stream);
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*
+ * conFlush
+ *
+ *	Renders all pending characters regardless of the render interval.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ */
+
+void conFlush(CONstream *stream)
+{
+	if(stream->Head != stream->Tail)
+	{
+		conRender(stream);
+	}
+}
+
+/*
+ * conSetHardwareScroll
+ *
+ *	Switches the stream between BIOS scrolling and hardware scrolling. With
+ *	hardware scrolling the first display pages of text memory become a ring
+ *	of rows and the display is scrolled by moving the CRTC start address, so
+ *	no text is copied. The ring always begins at the start of text memory,
+ *	since that is where the line compare register wraps the display to. The
+ *	visible text is carried over either way.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	int pages
+ *		Number of display pages used by the ring, or zero to go back to
+ *		BIOS scrolling on page 0. Pages after the ring are left alone and
+ *		can still be shown with 'conShowPage'.
+ *	returns
+ *		True if the ring fits in text memory and holds more rows than the
+ *		display.
+ */
+
+BOOL conSetHardwareScroll(CONstream *stream, int pages)
+{
+	int pageSize = _farpeekw(_dos_ds, CON_BIOS_PAGE_SIZE);
+	int rowSize  = stream->Columns * 2;
+	int lines    = pages * pageSize / rowSize;
+	int row;
+	char *screen;
+	if(pages > 0 && (pages * pageSize > CON_TEXT_MEMORY_SIZE || lines <= stream->Rows))
+	{
+		return FALSE;
+	}
+	conFlush(stream);
+	/* Keep the visible text in display order */
+	screen = malloc(stream->Rows * rowSize);
+	if(!screen)
+	{
+		return FALSE;
+	}
+	for(row = 0; row < stream->Rows; row ++)
+	{
+		dosmemget(conRowAddress(stream, row), rowSize, screen + row * rowSize);
+	}
+	stream->Base    = vgaIsColorMode() ? CON_COLOR_TEXT_MEMORY : CON_MONO_TEXT_MEMORY;
+	stream->Page    = 0;
+	stream->Pages   = pages;
+	stream->Lines   = pages > 0 ? lines : stream->Rows;
+	stream->Top     = 0;
+	stream->Visible = TRUE;
+	dosmemput(screen, stream->Rows * rowSize, stream->Base);
+	free(screen);
+	/* Show page 0 with no split */
+	vgaResolveCRTCAddresses();
+	vgaSetActiveDisplayPage(0);
+	vgaSetLineCompare(CON_NO_SPLIT);
+	conPlaceCursor(stream);
+	return TRUE;
+}
+
+/*
+ * conShowPage
+ *
+ *	Displays a text page. With hardware scrolling any page inside the ring
+ *	shows the console as it was last scrolled, other pages are handed to the
+ *	BIOS and the console keeps rendering in the background. With BIOS
+ *	scrolling this is just 'vgaSetActiveDisplayPage', but note that the BIOS
+ *	scrolls the active page so the console page should be shown when text
+ *	runs past the bottom.
+ *
+ *	CONstream * stream
+ *		Pointer to a console stream structure.
+ *	int page
+ *		The display page to show.
+ */
+
+void conShowPage(CONstream *stream, int page)
+{
+	if(stream->Pages > 0)
+	{
+		stream->Visible = page < stream->Pages;
+		if(stream->Visible)
+		{
+			conProgram(stream);
+			conPlaceCursor(stream);
+			return;
+		}
+		vgaSetLineCompare(CON_NO_SPLIT);
+	}
+	vgaSetActiveDisplayPage(page);
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ *
+ *	Console Stream library
+ *
+ *	Buffered text console for high volume logging in text modes. Characters
+ *	are queued in a ring and rendered straight into text memory at a capped
+ *	rate, with bursts of new lines collapsed into a single scroll.
+ *
+ *	Optionally the console can treat text memory as a circular buffer and
+ *	scroll by moving the CRTC start address, using the line compare register
+ *	to wrap the display back to the start of the buffer.
+ */
+
+#ifndef console_h
+#define console_h
+
+#include <time.h>
+
+#include "VGA.h"
+
+/*******************************************************************************
+ *
+ *	Console Stream flags
+ *
+ ******************************************************************************/
+
+#define CON_DEFAULT_SIZE			4096	/* Ring size in characters */
+#define CON_DEFAULT_RATE			30	/* Renders per second */
+#define CON_TAB_SIZE				8	/* Columns per tab stop */
+
+#define CON_COLOR_TEXT_MEMORY			0xB8000	/* Text memory for color modes */
+#define CON_MONO_TEXT_MEMORY			0xB0000	/* Text memory for monochrome modes */
+
+/* BIOS data area */
+
+#define CON_BIOS_COLUMNS			0x44A	/* Word, character columns */
+#define CON_BIOS_PAGE_SIZE			0x44C	/* Word, bytes per display page */
+#define CON_BIOS_ROWS				0x484	/* Byte, character rows minus one */
+#define CON_BIOS_CHAR_HEIGHT			0x485	/* Word, scan lines per character */
+
+#define CON_TEXT_MEMORY_SIZE			0x8000	/* Bytes of text memory at either address */
+#define CON_NO_SPLIT				0x3FF	/* Line compare value that never matches */
+
+/*******************************************************************************
+ *
+ *	Console Stream structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	/* Pending characters */
+	char          *Ring;		/* Characters not yet rendered */
+	int            Size;		/* Ring size, a power of two */
+	int            Head;		/* Next character to render */
+	int            Tail;		/* Next free slot */
+	/* Display */
+	int            Page;		/* Text page written to */
+	int            Color;		/* Attribute of new characters */
+	int            Rows;
+	int            Columns;
+	int            Row;		/* Cursor position after last render */
+	int            Column;
+	unsigned long  Base;		/* Linear address of the page */
+	/* Hardware scrolling */
+	int            Pages;		/* Display pages in the ring, zero for BIOS scrolling */
+	int            Lines;		/* Rows of text memory in the ring */
+	int            Top;		/* Ring row shown at the top of the display */
+	int            CharHeight;	/* Scan lines per character row */
+	BOOL           Visible;		/* Ring is on display and owns the CRTC */
+	/* Rate control */
+	uclock_t       Interval;	/* Minimum clock ticks between renders */
+	uclock_t       LastRender;	/* Clock at the last render */
+
+} CONstream;
+
+/*******************************************************************************
+ *
+ *	Console Stream functions
+ *
+ ******************************************************************************/
+
+BOOL conCreate(CONstream *stream, int page, int color, int size);
+
+void conDestroy(CONstream *stream);
+
+void conSetRate(CONstream *stream, int rate);
+
+void conSetColor(CONstream *stream, int color);
+
+void conPutChar(CONstream *stream, char ascii);
+
+int conWrite(CONstream *stream, const char *string, int length);
+
+int conPrintf(CONstream *stream, const char *format, ...);
+
+BOOL conUpdate(CONstream *stream);
+
+void conFlush(CONstream *stream);
+
+BOOL conSetHardwareScroll(CONstream *stream, int pages);
+
+void conShowPage(CONstream *stream, int page);
+
+
+#endif /* console_h */
@@ -0,0 +1,337 @@
+/*******************************************************************************
+ *
+ *	Font library
+ *
+ *	Draws text on graphics surfaces with the fonts held in the video BIOS.
+ *	Each ROM font is copied into memory once, and rows of glyph bits are
+ *	expanded to pixel masks through tables built for each pixel size, so a
+ *	glyph row is drawn with a few dword operations.
+ */
+
+#include <stdlib.h>
+
+#include "farseg.h"
+#include "VGA.h"
+#include "font.h"
+
+/* Fonts copied from the BIOS, loaded on first use */
+
+static FNTfont ROMFonts[FNT_ROM_FONTS];
+
+/* Expanded masks for each pixel size, loaded on first use */
+
+static unsigned long *Masks[5];
+
+/*******************************************************************************
+ *
+ *	Glyph expansion
+ *
+ ******************************************************************************/
+
+/*
+ * fntGetMasks
+ *
+ *	Eight pixels take two dwords for every byte of a pixel. For each of the
+ *	256 patterns a glyph row can have this table holds those dwords with all
+ *	bits of the set pixels on, leftmost pixel in the high bit of the row.
+ *
+ *	int bytes
+ *		Bytes per pixel, 1 to 4.
+ *	returns
+ *		The table, or NULL if it could not be allocated.
+ */
+
+static unsigned long *fntGetMasks(int bytes)
+{
+	int words = bytes * 2;
+	int pattern, index;
+	if(!Masks[ bytes ])
+	{
+		unsigned long *table = calloc(256 * words, sizeof(unsigned long));
+		if(!table)
+		{
+			return NULL;
+		}
+		for(pattern = 0; pattern < 256; pattern ++)
+		{
+			for(index = 0; index < bytes * 8; index ++)
+			{
+				if(pattern & (0x80 >> (index / bytes)))
+				{
+					table[ pattern * words + index / 4 ] |= 0xFFUL << ((index % 4) * 8);
+				}
+			}
+		}
+		Masks[ bytes ] = table;
+	}
+	return Masks[ bytes ];
+}
+
+/*
+ * fntRepeatColor
+ *
+ *	Fills the dwords covering eight pixels with a single pixel value, in the
+ *	same layout as the mask table.
+ */
+
+static void fntRepeatColor(unsigned long *words, int bytes, unsigned long color)
+{
+	int index;
+	for(index = 0; index < bytes * 2; index ++)
+	{
+		words[ index ] = 0;
+	}
+	for(index = 0; index < bytes * 8; index ++)
+	{
+		unsigned long value = (color >> ((index % bytes) * 8)) & 0xFF;
+		words[ index / 4 ] |= value << ((index % 4) * 8);
+	}
+}
+
+/*
+ * fntDrawGlyph
+ *
+ *	Draws the rows of a glyph that lie entirely inside the clip rectangle
+ *	horizontally. Every row is a masked merge of the colors into the pixels.
+ */
+
+static void fntDrawGlyph(unsigned char *line, int pitch, const unsigned char *rows, int count,
+                         const unsigned long *masks, const unsigned long *fore, const unsigned long *back,
+                         int words, int flags)
+{
+	int word;
+	while(count --)
+	{
+		const unsigned long *mask = masks + *rows * words;
+		unsigned long *pixel = (unsigned long *)line;
+		if(flags & FNT_OPAQUE)
+		{
+			for(word = 0; word < words; word ++)
+			{
+				pixel[ word ] = back[ word ] ^ ((back[ word ] ^ fore[ word ]) & mask[ word ]);
+			}
+		}
+		else if(*rows)
+		{
+			for(word = 0; word < words; word ++)
+			{
+				pixel[ word ] ^= (pixel[ word ] ^ fore[ word ]) & mask[ word ];
+			}
+		}
+		rows ++;
+		line += pitch;
+	}
+}
+
+/*
+ * fntDrawGlyphClipped
+ *
+ *	Draws a glyph one pixel at a time, for glyphs cut by the left or right
+ *	edge of the clip rectangle.
+ */
+
+static void fntDrawGlyphClipped(unsigned char *line, int pitch, const unsigned char *rows, int count,
+                                int bytes, int first, int last, unsigned long fore, unsigned long back, int flags)
+{
+	int column, index;
+	while(count --)
+	{
+		for(column = first; column < last; column ++)
+		{
+			unsigned long color;
+			if(*rows & (0x80 >> column))
+			{
+				color = fore;
+			}
+			else if(flags & FNT_OPAQUE)
+			{
+				color = back;
+			}
+			else
+			{
+				continue;
+			}
+			for(index = 0; index < bytes; index ++)
+			{
+				line[ column * bytes + index ] = color >> (index * 8);
+			}
+		}
+		rows ++;
+		line += pitch;
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Font functions
+ *
+ ******************************************************************************/
+
+/*
+ * fntLoadROMFont
+ *
+ *	Copies one of the video BIOS fonts into memory the first time it is
+ *	asked for. The 8x8 font is kept by the BIOS in two halves.
+ *
+ *	int font
+ *		Which font to load.
+ *			FNT_8x8
+ *			FNT_8x14
+ *			FNT_8x16
+ *	returns
+ *		Pointer to the font, or NULL if it could not be loaded.
+ */
+
+FNTfont *fntLoadROMFont(int font)
+{
+	static const int heights[FNT_ROM_FONTS] = { 8, 14, 16 };
+	FNTfont *rom;
+	if(font < 0 || font >= FNT_ROM_FONTS)
+	{
+		return NULL;
+	}
+	rom = &ROMFonts[ font ];
+	if(!rom->Glyphs)
+	{
+		int height = heights[ font ];
+		unsigned char *glyphs = malloc(256 * height);
+		if(!glyphs)
+		{
+			return NULL;
+		}
+		switch(font)
+		{
+		case FNT_8x8:
+			dosmemget(vgaGetFontAddress(VGA_8x8_FONT_POINTER), 128 * height, glyphs);
+			dosmemget(vgaGetFontAddress(VGA_8x8_EXTENDED_FONT_POINTER), 128 * height, glyphs + 128 * height);
+			break;
+		case FNT_8x14:
+			dosmemget(vgaGetFontAddress(VGA_8x14_FONT_POINTER), 256 * height, glyphs);
+			break;
+		case FNT_8x16:
+			dosmemget(vgaGetFontAddress(VGA_8x16_FONT_POINTER), 256 * height, glyphs);
+			break;
+		}
+		rom->Glyphs = glyphs;
+		rom->Width  = 8;
+		rom->Height = height;
+	}
+	return rom;
+}
+
+/*
+ * fntFreeROMFonts
+ *
+ *	Releases the fonts copied from the BIOS and the expansion tables.
+ */
+
+void fntFreeROMFonts()
+{
+	int index;
+	for(index = 0; index < FNT_ROM_FONTS; index ++)
+	{
+		free(ROMFonts[ index ].Glyphs);
+		ROMFonts[ index ].Glyphs = NULL;
+	}
+	for(index = 0; index < 5; index ++)
+	{
+		free(Masks[ index ]);
+		Masks[ index ] = NULL;
+	}
+}
+
+/*
+ * fntTextWidth
+ *
+ *	FNTfont * font
+ *		Pointer to a font.
+ *	const char * string
+ *		The text to measure.
+ *	returns
+ *		The width of the longest line of the text in pixels.
+ */
+
+int fntTextWidth(FNTfont *font, const char *string)
+{
+	int width = 0, line = 0;
+	for(; *string; string ++)
+	{
+		if(*string == '\n')
+		{
+			line = 0;
+			continue;
+		}
+		line += font->Width;
+		if(line > width) width = line;
+	}
+	return width;
+}
+
+/*
+ * fntDrawText
+ *
+ *	Draws a string of text, clipped to the clip rectangle of the surface.
+ *	A new line character starts a new row of text below the first.
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	FNTfont * font
+ *		Pointer to the font to draw with.
+ *	int x, y
+ *		Position of the top left corner of the first character.
+ *	const char * string
+ *		The text to draw.
+ *	unsigned long fore
+ *		Pixel value for the character shapes.
+ *	unsigned long back
+ *		Pixel value for the rest of the character cells.
+ *	int flags
+ *		How the background is treated.
+ *			FNT_TRANSPARENT
+ *			FNT_OPAQUE
+ */
+
+void fntDrawText(GFXsurface *surface, FNTfont *font, int x, int y, const char *string, unsigned long fore, unsigned long back, int flags)
+{
+	int bytes = surface->BytesPerPixel;
+	int words = bytes * 2;
+	int left  = x;
+	unsigned long foreWords[8], backWords[8];
+	unsigned long *masks = fntGetMasks(bytes);
+	if(!masks)
+	{
+		return;
+	}
+	fntRepeatColor(foreWords, bytes, fore);
+	fntRepeatColor(backWords, bytes, back);
+	for(; *string; string ++)
+	{
+		const unsigned char *rows;
+		int top, bottom, first, last;
+		if(*string == '\n')
+		{
+			x  = left;
+			y += font->Height;
+			continue;
+		}
+		/* Clip the character cell */
+		top    = y < surface->ClipTop ? surface->ClipTop - y : 0;
+		bottom = y + font->Height > surface->ClipBottom ? surface->ClipBottom - y : font->Height;
+		first  = x < surface->ClipLeft ? surface->ClipLeft - x : 0;
+		last   = x + font->Width > surface->ClipRight ? surface->ClipRight - x : font->Width;
+		if(top < bottom && first < last)
+		{
+			unsigned char *line = surface->Bits + (y + top) * surface->BytesPerLine + x * bytes;
+			rows = font->Glyphs + (unsigned char)*string * font->Height + top;
+			if(first == 0 && last == font->Width)
+			{
+				fntDrawGlyph(line, surface->BytesPerLine, rows, bottom - top, masks, foreWords, backWords, words, flags);
+			}
+			else
+			{
+				fntDrawGlyphClipped(line, surface->BytesPerLine, rows, bottom - top, bytes, first, last, fore, back, flags);
+			}
+		}
+		x += font->Width;
+	}
+}
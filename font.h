@@ -0,0 +1,64 @@
+/*******************************************************************************
+ *
+ *	Font library
+ *
+ *	Draws text on graphics surfaces with the fonts held in the video BIOS.
+ *	Each ROM font is copied into memory once, and rows of glyph bits are
+ *	expanded to pixel masks through tables built for each pixel size, so a
+ *	glyph row is drawn with a few dword operations.
+ */
+
+#ifndef font_h
+#define font_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Font flags
+ *
+ ******************************************************************************/
+
+/* ROM fonts */
+
+#define FNT_8x8					0x00
+#define FNT_8x14				0x01
+#define FNT_8x16				0x02
+#define FNT_ROM_FONTS				3
+
+/* fntDrawText */
+
+#define FNT_TRANSPARENT				0x00	/* Leave background pixels alone */
+#define FNT_OPAQUE				0x01	/* Fill background pixels */
+
+/*******************************************************************************
+ *
+ *	Font structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	unsigned char *Glyphs;		/* One byte per row for each of 256 characters */
+	int            Width;		/* Pixels per character, always 8 */
+	int            Height;		/* Rows per character */
+
+} FNTfont;
+
+/*******************************************************************************
+ *
+ *	Font functions
+ *
+ ******************************************************************************/
+
+FNTfont *fntLoadROMFont(int font);
+
+void fntFreeROMFonts();
+
+int fntTextWidth(FNTfont *font, const char *string);
+
+void fntDrawText(GFXsurface *surface, FNTfont *font, int x, int y, const char *string, unsigned long fore, unsigned long back, int flags);
+
+
+#endif /* font_h */
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ *
+ *	Gamma library
+ *
+ *	Color correction ramps built from gamma, brightness and contrast. In 8
+ *	bit modes a ramp is applied by the DAC, through 'gfxSetPaletteRamp',
+ *	and costs nothing per frame. Direct color modes bypass the DAC, so the
+ *	ramp is applied by the presenter as it copies the back buffer to the
+ *	frame buffer, through a correction table made for the pixel layout.
+ *	Either way the back buffer keeps its colors and nothing is redrawn.
+ *
+ *	A correction table holds every 15 or 16 bit pixel already corrected,
+ *	so those take one lookup each, two pixels to a dword. 24 and 32 bit
+ *	pixels take one lookup per byte, a whole pixel to a dword at 32 bits.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "gamma.h"
+
+/*
+ * gfxBuildRamp
+ *
+ *	Builds the same curve for the three guns. A ramp can also be filled in
+ *	by hand, for a different curve per gun.
+ *
+ *	GFXramp * ramp
+ *		Pointer to the ramp to fill in.
+ *	float gamma
+ *		Gamma to correct for, above 1 lightens the middle tones, 1 for none.
+ *	float brightness
+ *		Added to every level, -1 to 1, 0 for none.
+ *	float contrast
+ *		Scale of the distance from middle gray, 1 for none.
+ */
+
+void gfxBuildRamp(GFXramp *ramp, float gamma, float brightness, float contrast)
+{
+	double value;
+	int level, corrected;
+	if(gamma <= 0)
+	{
+		gamma = 1;
+	}
+	for(level = 0; level < 256; level ++)
+	{
+		value     = pow(level / 255.0, 1.0 / gamma);
+		value     = (value - 0.5) * contrast + 0.5 + brightness;
+		corrected = (int)floor(value * 255 + 0.5);
+		corrected = max(0, min(corrected, 255));
+		ramp->Red[ level ]   = (unsigned char)corrected;
+		ramp->Green[ level ] = (unsigned char)corrected;
+		ramp->Blue[ level ]  = (unsigned char)corrected;
+	}
+}
+
+/*
+ * gfxCreateCorrection
+ *
+ *	Makes the table applying a ramp to pixels of one layout. Bits outside
+ *	the color fields pass through unchanged.
+ *
+ *	GFXcorrection * correction
+ *		Pointer to a correction structure to initialize.
+ *	GFXsurface * layout
+ *		Surface with the pixel layout to correct, 15, 16, 24 or 32 bits.
+ *		24 and 32 bit layouts need 8 bit fields on byte boundaries.
+ *	GFXramp * ramp
+ *		The ramp to apply.
+ *	returns
+ *		True if the layout is supported and the table allocated.
+ */
+
+BOOL gfxCreateCorrection(GFXcorrection *correction, GFXsurface *layout, GFXramp *ramp)
+{
+	unsigned long pixel, fields;
+	int lane, level, red, green, blue;
+	correction->BytesPerPixel = layout->BytesPerPixel;
+	correction->Words         = NULL;
+	if(layout->BytesPerPixel == 2)
+	{
+		correction->Words = malloc(65536 * sizeof(unsigned short));
+		if(!correction->Words)
+		{
+			return FALSE;
+		}
+		fields = gfxMapRGB(layout, 255, 255, 255);
+		for(pixel = 0; pixel < 65536; pixel ++)
+		{
+			gfxUnmapRGB(layout, pixel, &red, &green, &blue);
+			correction->Words[ pixel ] = (unsigned short)(gfxMapRGB(layout, ramp->Red[ red ], ramp->Green[ green ], ramp->Blue[ blue ]) |
+			                                              (pixel & ~fields));
+		}
+		return TRUE;
+	}
+	if(layout->BytesPerPixel < 3 ||
+	   layout->RedMaskSize != 8   || layout->RedFieldPosition % 8 ||
+	   layout->GreenMaskSize != 8 || layout->GreenFieldPosition % 8 ||
+	   layout->BlueMaskSize != 8  || layout->BlueFieldPosition % 8)
+	{
+		return FALSE;
+	}
+	for(lane = 0; lane < 4; lane ++)
+	{
+		for(level = 0; level < 256; level ++)
+		{
+			correction->Bytes[ lane ][ level ] = (unsigned char)level;
+		}
+	}
+	for(level = 0; level < 256; level ++)
+	{
+		correction->Bytes[ layout->RedFieldPosition / 8 ][ level ]   = ramp->Red[ level ];
+		correction->Bytes[ layout->GreenFieldPosition / 8 ][ level ] = ramp->Green[ level ];
+		correction->Bytes[ layout->BlueFieldPosition / 8 ][ level ]  = ramp->Blue[ level ];
+	}
+	return TRUE;
+}
+
+/*
+ * gfxDestroyCorrection
+ */
+
+void gfxDestroyCorrection(GFXcorrection *correction)
+{
+	free(correction->Words);
+	correction->Words = NULL;
+}
+
+/*
+ * gfxCorrectRow
+ *
+ *	Copies a row of pixels, correcting them on the way.
+ *
+ *	GFXcorrection * correction
+ *		Pointer to a correction made for the layout of the pixels.
+ *	unsigned char * to
+ *		First pixel to write.
+ *	const unsigned char * from
+ *		First pixel to read.
+ *	int count
+ *		Number of pixels.
+ */
+
+void gfxCorrectRow(GFXcorrection *correction, unsigned char *to, const unsigned char *from, int count)
+{
+	const unsigned short *words = correction->Words;
+	unsigned char (*bytes)[256]  = correction->Bytes;
+	unsigned long pixel;
+	switch(correction->BytesPerPixel)
+	{
+	case 2:
+		for(; count >= 2; count -= 2, to += 4, from += 4)
+		{
+			pixel = GFX_GET_4(from);
+			GFX_PUT_4(to, (unsigned long)words[ pixel & 0xFFFF ] | (unsigned long)words[ (pixel >> 16) & 0xFFFF ] << 16);
+		}
+		if(count)
+		{
+			GFX_PUT_2(to, words[ GFX_GET_2(from) ]);
+		}
+		break;
+	case 3:
+		for(; count > 0; count --, to += 3, from += 3)
+		{
+			to[ 0 ] = bytes[ 0 ][ from[ 0 ] ];
+			to[ 1 ] = bytes[ 1 ][ from[ 1 ] ];
+			to[ 2 ] = bytes[ 2 ][ from[ 2 ] ];
+		}
+		break;
+	case 4:
+		for(; count > 0; count --, to += 4, from += 4)
+		{
+			pixel = GFX_GET_4(from);
+			GFX_PUT_4(to, (unsigned long)bytes[ 0 ][ pixel & 0xFF ] |
+			              (unsigned long)bytes[ 1 ][ (pixel >> 8) & 0xFF ] << 8 |
+			              (unsigned long)bytes[ 2 ][ (pixel >> 16) & 0xFF ] << 16 |
+			              (unsigned long)bytes[ 3 ][ (pixel >> 24) & 0xFF ] << 24);
+		}
+		break;
+	}
+}
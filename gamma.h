@@ -0,0 +1,56 @@
+/*******************************************************************************
+ *
+ *	Gamma library
+ *
+ *	Color correction ramps built from gamma, brightness and contrast. In 8
+ *	bit modes a ramp is applied by the DAC, through 'gfxSetPaletteRamp',
+ *	and costs nothing per frame. Direct color modes bypass the DAC, so the
+ *	ramp is applied by the presenter as it copies the back buffer to the
+ *	frame buffer, through a correction table made for the pixel layout.
+ *	Either way the back buffer keeps its colors and nothing is redrawn.
+ */
+
+#ifndef gamma_h
+#define gamma_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Gamma structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	unsigned char Red[256];
+	unsigned char Green[256];
+	unsigned char Blue[256];
+
+} GFXramp;
+
+typedef struct
+{
+	int             BytesPerPixel;
+	unsigned short *Words;			/* Every 15 or 16 bit pixel, corrected */
+	unsigned char   Bytes[4][256];		/* Each byte of a 24 or 32 bit pixel, corrected */
+
+} GFXcorrection;
+
+/*******************************************************************************
+ *
+ *	Gamma functions
+ *
+ ******************************************************************************/
+
+void gfxBuildRamp(GFXramp *ramp, float gamma, float brightness, float contrast);
+
+BOOL gfxCreateCorrection(GFXcorrection *correction, GFXsurface *layout, GFXramp *ramp);
+
+void gfxDestroyCorrection(GFXcorrection *correction);
+
+void gfxCorrectRow(GFXcorrection *correction, unsigned char *to, const unsigned char *from, int count);
+
+
+#endif /* gamma_h */
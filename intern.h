@@ -1,2 +1,13 @@
 
 #define setsafe(arg, value) if (arg) *arg = value
+
+/* Reads the processor time stamp counter into an unsigned long long */
+#define rdtsc(value) __asm__ __volatile__ ("rdtsc" : "=A" (value))
+
+#ifndef min
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#ifndef max
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
@@ -0,0 +1,618 @@
+/*******************************************************************************
+ *
+ *	Inverse library
+ *
+ *	An inverse color map gives the palette entry nearest to any color cut
+ *	to 5 bits per gun, so drawing direct color pixels onto an 8 bit surface
+ *	costs one lookup per pixel instead of a search of the palette. The map
+ *	is built from the shadow palette and rebuilt on first use after the
+ *	palette changes.
+ *
+ *	The map is built by sweeping each palette entry over all cells, keeping
+ *	the distance from each cell to the nearest entry so far. Along a line of
+ *	cells the squared distance to an entry grows by a step that itself grows
+ *	by a constant, so the inner loop is two adds and a compare.
+ *
+ *	5:5:5 pixels are cells already and 5:6:5 and 8:8:8 pixels are cut with
+ *	fixed shifts, four 8:8:8 pixels at a time with SSE2. Other layouts are
+ *	cut with shifts taken from the surface.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "palette.h"
+#include "inverse.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define GFX_INVERSE_CELLS			(1 << GFX_INVERSE_BITS)
+#define GFX_INVERSE_STEP			(256 / GFX_INVERSE_CELLS)
+
+/* Shifts bringing the top 5 bits of each field to the bottom */
+
+typedef struct
+{
+	int Red;
+	int Green;
+	int Blue;
+
+} GFXcut;
+
+typedef void (*GFXremapFunction)(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, const GFXcut *cut);
+
+/*******************************************************************************
+ *
+ *	Building
+ *
+ ******************************************************************************/
+
+/*
+ * gfxSweepEntry
+ *
+ *	Claims every cell closer to an entry than to the entries swept before.
+ *	Distances are measured from the middle of each cell.
+ */
+
+static void gfxSweepEntry(GFXinverse *inverse, int entry, const unsigned char *color)
+{
+	unsigned char *table = inverse->Table;
+	unsigned long *distances = inverse->Distances;
+	long dr, dg, db, distance, step;
+	int r, g, b, cell = 0;
+	db = GFX_INVERSE_STEP / 2 - color[ 2 ];
+	for(r = 0; r < GFX_INVERSE_CELLS; r ++)
+	{
+		dr = r * GFX_INVERSE_STEP + GFX_INVERSE_STEP / 2 - color[ 0 ];
+		for(g = 0; g < GFX_INVERSE_CELLS; g ++)
+		{
+			dg       = g * GFX_INVERSE_STEP + GFX_INVERSE_STEP / 2 - color[ 1 ];
+			distance = dr * dr + dg * dg + db * db;
+			/* (d + s)^2 - d^2 = 2ds + s^2, growing by 2s^2 a cell */
+			step     = 2 * GFX_INVERSE_STEP * db + GFX_INVERSE_STEP * GFX_INVERSE_STEP;
+			for(b = 0; b < GFX_INVERSE_CELLS; b ++, cell ++)
+			{
+				if((unsigned long)distance < distances[ cell ])
+				{
+					distances[ cell ] = distance;
+					table[ cell ]     = (unsigned char)entry;
+				}
+				distance += step;
+				step     += 2 * GFX_INVERSE_STEP * GFX_INVERSE_STEP;
+			}
+		}
+	}
+}
+
+/*
+ * gfxCreateInverse
+ *
+ *	The map is built on first use, from the palette at that time.
+ *
+ *	GFXinverse * inverse
+ *		Pointer to an inverse map structure to initialize.
+ *	returns
+ *		True if the map was allocated.
+ */
+
+BOOL gfxCreateInverse(GFXinverse *inverse)
+{
+	inverse->Serial    = 0;
+	inverse->Table     = malloc(GFX_INVERSE_SIZE);
+	inverse->Distances = malloc(GFX_INVERSE_SIZE * sizeof(unsigned long));
+	if(!inverse->Table || !inverse->Distances)
+	{
+		gfxDestroyInverse(inverse);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * gfxDestroyInverse
+ */
+
+void gfxDestroyInverse(GFXinverse *inverse)
+{
+	free(inverse->Table);
+	free(inverse->Distances);
+	inverse->Table     = NULL;
+	inverse->Distances = NULL;
+	inverse->Serial    = 0;
+}
+
+/*
+ * gfxUpdateInverse
+ *
+ *	Rebuilds the map if the shadow palette was written since it was built.
+ *	Called by the functions using the map, so only needed to move the work
+ *	out of a frame.
+ */
+
+void gfxUpdateInverse(GFXinverse *inverse)
+{
+	const GFXpalette *palette = gfxGetPalette();
+	int entry, cell;
+	if(inverse->Serial == palette->Serial || !inverse->Table)
+	{
+		return;
+	}
+	for(cell = 0; cell < GFX_INVERSE_SIZE; cell ++)
+	{
+		inverse->Distances[ cell ] = 0xFFFFFFFFUL;
+	}
+	/* Entries after the first with the same color never win a cell */
+	for(entry = 0; entry < 256; entry ++)
+	{
+		gfxSweepEntry(inverse, entry, palette->Colors[ entry ]);
+	}
+	inverse->Serial = palette->Serial;
+}
+
+/*
+ * gfxInverseColor
+ *
+ *	int red, green, blue
+ *		Color 0-255.
+ *	returns
+ *		The palette entry nearest to the cell of the color.
+ */
+
+int gfxInverseColor(GFXinverse *inverse, int red, int green, int blue)
+{
+	gfxUpdateInverse(inverse);
+	return inverse->Table[ GFX_INVERSE_INDEX(red & 0xFF, green & 0xFF, blue & 0xFF) ];
+}
+
+/*******************************************************************************
+ *
+ *	Remapping
+ *
+ ******************************************************************************/
+
+static void gfxRemap555(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, const GFXcut *cut)
+{
+	for(; count > 0; count --, to ++, from += 2)
+	{
+		*to = table[ GFX_GET_2(from) & 0x7FFF ];
+	}
+}
+
+static void gfxRemap565(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, const GFXcut *cut)
+{
+	unsigned long pixel;
+	for(; count > 0; count --, to ++, from += 2)
+	{
+		pixel = GFX_GET_2(from);
+		*to   = table[ ((pixel >> 1) & 0x7FE0) | (pixel & 0x001F) ];
+	}
+}
+
+#define GFX_CUT_8888(p)				((((p) >> 9) & 0x7C00) | (((p) >> 6) & 0x03E0) | (((p) >> 3) & 0x001F))
+
+static void gfxRemap8888(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, const GFXcut *cut)
+{
+	for(; count >= 4; count -= 4, to += 4, from += 16)
+	{
+		GFX_PUT_4(to, (unsigned long)table[ GFX_CUT_8888(GFX_GET_4(from)) ] |
+		              (unsigned long)table[ GFX_CUT_8888(GFX_GET_4(from + 4)) ] << 8 |
+		              (unsigned long)table[ GFX_CUT_8888(GFX_GET_4(from + 8)) ] << 16 |
+		              (unsigned long)table[ GFX_CUT_8888(GFX_GET_4(from + 12)) ] << 24);
+	}
+	for(; count > 0; count --, to ++, from += 4)
+	{
+		*to = table[ GFX_CUT_8888(GFX_GET_4(from)) ];
+	}
+}
+
+#if defined(__SSE2__)
+
+/*
+ * gfxRemap8888SSE2
+ *
+ *	Cuts four pixels at a time, leaving only the lookups to do one by one.
+ */
+
+static void gfxRemap8888SSE2(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, const GFXcut *cut)
+{
+	__m128i red = _mm_set1_epi32(0x7C00), green = _mm_set1_epi32(0x03E0), blue = _mm_set1_epi32(0x001F);
+	__m128i pixels;
+	union
+	{
+		__m128i Vector;
+		int     Cells[4];
+	} cells;
+	for(; count >= 4; count -= 4, to += 4, from += 16)
+	{
+		pixels       = _mm_loadu_si128((const __m128i *)from);
+		cells.Vector = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 9), red),
+		                                         _mm_and_si128(_mm_srli_epi32(pixels, 6), green)),
+		                            _mm_and_si128(_mm_srli_epi32(pixels, 3), blue));
+		GFX_PUT_4(to, (unsigned long)table[ cells.Cells[ 0 ] ] |
+		              (unsigned long)table[ cells.Cells[ 1 ] ] << 8 |
+		              (unsigned long)table[ cells.Cells[ 2 ] ] << 16 |
+		              (unsigned long)table[ cells.Cells[ 3 ] ] << 24);
+	}
+	gfxRemap8888(to, from, count, table, cut);
+}
+
+#define GFX_REMAP_8888				gfxRemap8888SSE2
+
+#else
+
+#define GFX_REMAP_8888				gfxRemap8888
+
+#endif
+
+/*
+ * gfxRemapFields
+ *
+ *	Any layout, with the shifts of its fields.
+ */
+
+#define GFX_REMAP_FIELDS(name, bytes) \
+static void name(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, const GFXcut *cut) \
+{ \
+	unsigned long pixel; \
+	for(; count > 0; count --, to ++, from += bytes) \
+	{ \
+		pixel = GFX_GET_##bytes(from); \
+		*to   = table[ (((pixel >> cut->Red) & 0x1F) << 10) | \
+		               (((pixel >> cut->Green) & 0x1F) << 5) | \
+		               ((pixel >> cut->Blue) & 0x1F) ]; \
+	} \
+}
+
+GFX_REMAP_FIELDS(gfxRemapFields2, 2)
+GFX_REMAP_FIELDS(gfxRemapFields3, 3)
+GFX_REMAP_FIELDS(gfxRemapFields4, 4)
+
+/* Indexed by bytes per pixel */
+
+static GFXremapFunction RemapFields[5] =
+{
+	NULL, NULL, gfxRemapFields2, gfxRemapFields3, gfxRemapFields4
+};
+
+/*
+ * gfxRemapFunction
+ *
+ *	Picks the loop for the layout of a surface.
+ */
+
+static GFXremapFunction gfxRemapFunction(GFXsurface *surface, GFXcut *cut)
+{
+	cut->Red   = surface->RedFieldPosition   + surface->RedMaskSize   - GFX_INVERSE_BITS;
+	cut->Green = surface->GreenFieldPosition + surface->GreenMaskSize - GFX_INVERSE_BITS;
+	cut->Blue  = surface->BlueFieldPosition  + surface->BlueMaskSize  - GFX_INVERSE_BITS;
+	if(surface->BytesPerPixel == 2 && cut->Red == 10 && cut->Green == 5 && cut->Blue == 0)
+	{
+		return gfxRemap555;
+	}
+	if(surface->BytesPerPixel == 2 && cut->Red == 11 && cut->Green == 6 && cut->Blue == 0)
+	{
+		return gfxRemap565;
+	}
+	if(surface->BytesPerPixel == 4 && cut->Red == 19 && cut->Green == 11 && cut->Blue == 3)
+	{
+		return GFX_REMAP_8888;
+	}
+	return RemapFields[ surface->BytesPerPixel ];
+}
+
+/*******************************************************************************
+ *
+ *	Dithering
+ *
+ ******************************************************************************/
+
+#define GFX_CLAMP_BYTE(c)			((c) < 0 ? 0 : (c) > 255 ? 255 : (c))
+
+/* 4x4 ordered dither thresholds, in sixteenths of the spread */
+
+static const int Bayer[4][4] =
+{
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 }
+};
+
+static unsigned long gfxGetPixel(const unsigned char *pixel, int bytes)
+{
+	switch(bytes)
+	{
+	case 2:  return GFX_GET_2(pixel);
+	case 3:  return GFX_GET_3(pixel);
+	default: return GFX_GET_4(pixel);
+	}
+}
+
+/*
+ * gfxOrdered
+ *
+ *	Adds a threshold to each gun before the lookup, repeating every four
+ *	pixels. Any layout.
+ */
+
+static void gfxOrdered(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, GFXsurface *source, const int *bias)
+{
+	int bytes = source->BytesPerPixel;
+	int x, red, green, blue;
+	for(x = 0; x < count; x ++, to ++, from += bytes)
+	{
+		gfxUnmapRGB(source, gfxGetPixel(from, bytes), &red, &green, &blue);
+		red   = GFX_CLAMP_BYTE(red + bias[ x & 3 ]);
+		green = GFX_CLAMP_BYTE(green + bias[ x & 3 ]);
+		blue  = GFX_CLAMP_BYTE(blue + bias[ x & 3 ]);
+		*to   = table[ GFX_INVERSE_INDEX(red, green, blue) ];
+	}
+}
+
+static void gfxOrdered8888(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, GFXsurface *source, const int *bias)
+{
+	unsigned long pixel;
+	int x, red, green, blue;
+	for(x = 0; x < count; x ++, to ++, from += 4)
+	{
+		pixel = GFX_GET_4(from);
+		red   = (int)((pixel >> 16) & 0xFF) + bias[ x & 3 ];
+		green = (int)((pixel >> 8) & 0xFF) + bias[ x & 3 ];
+		blue  = (int)(pixel & 0xFF) + bias[ x & 3 ];
+		red   = GFX_CLAMP_BYTE(red);
+		green = GFX_CLAMP_BYTE(green);
+		blue  = GFX_CLAMP_BYTE(blue);
+		*to   = table[ GFX_INVERSE_INDEX(red, green, blue) ];
+	}
+}
+
+#if defined(__SSE2__)
+
+/*
+ * gfxOrdered8888SSE2
+ *
+ *	Four pixels take one threshold each, so the thresholds of a line fit
+ *	one register. They are split in a part to add and a part to subtract,
+ *	both saturating, so the guns clamp for free.
+ */
+
+static void gfxOrdered8888SSE2(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, GFXsurface *source, const int *bias)
+{
+	__m128i red = _mm_set1_epi32(0x7C00), green = _mm_set1_epi32(0x03E0), blue = _mm_set1_epi32(0x001F);
+	__m128i up, down, pixels;
+	union
+	{
+		__m128i Vector;
+		int     Cells[4];
+	} cells;
+	up   = _mm_set_epi32(max(bias[ 3 ], 0) * 0x010101, max(bias[ 2 ], 0) * 0x010101,
+	                     max(bias[ 1 ], 0) * 0x010101, max(bias[ 0 ], 0) * 0x010101);
+	down = _mm_set_epi32(max(-bias[ 3 ], 0) * 0x010101, max(-bias[ 2 ], 0) * 0x010101,
+	                     max(-bias[ 1 ], 0) * 0x010101, max(-bias[ 0 ], 0) * 0x010101);
+	for(; count >= 4; count -= 4, to += 4, from += 16)
+	{
+		pixels       = _mm_subs_epu8(_mm_adds_epu8(_mm_loadu_si128((const __m128i *)from), up), down);
+		cells.Vector = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 9), red),
+		                                         _mm_and_si128(_mm_srli_epi32(pixels, 6), green)),
+		                            _mm_and_si128(_mm_srli_epi32(pixels, 3), blue));
+		GFX_PUT_4(to, (unsigned long)table[ cells.Cells[ 0 ] ] |
+		              (unsigned long)table[ cells.Cells[ 1 ] ] << 8 |
+		              (unsigned long)table[ cells.Cells[ 2 ] ] << 16 |
+		              (unsigned long)table[ cells.Cells[ 3 ] ] << 24);
+	}
+	gfxOrdered8888(to, from, count, table, source, bias);
+}
+
+#define GFX_ORDERED_8888			gfxOrdered8888SSE2
+
+#else
+
+#define GFX_ORDERED_8888			gfxOrdered8888
+
+#endif
+
+/*
+ * gfxDiffuse
+ *
+ *	Floyd-Steinberg error diffusion of one line. Errors are kept in
+ *	sixteenths, one slot before and after the line so the edges need no
+ *	tests.
+ *
+ *	int * errors
+ *		Error carried into this line, three guns a pixel.
+ *	int * next
+ *		Error carried into the next line, cleared by the caller.
+ */
+
+static void gfxDiffuse(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, GFXsurface *source, int *errors, int *next)
+{
+	const GFXpalette *palette = gfxGetPalette();
+	const unsigned char *color;
+	int bytes = source->BytesPerPixel;
+	int x, gun, error, guns[3];
+	errors += 3;
+	next   += 3;
+	for(x = 0; x < count; x ++, to ++, from += bytes, errors += 3, next += 3)
+	{
+		gfxUnmapRGB(source, gfxGetPixel(from, bytes), &guns[ 0 ], &guns[ 1 ], &guns[ 2 ]);
+		for(gun = 0; gun < 3; gun ++)
+		{
+			guns[ gun ] = GFX_CLAMP_BYTE(guns[ gun ] + (errors[ gun ] + 8) / 16);
+		}
+		*to   = table[ GFX_INVERSE_INDEX(guns[ 0 ], guns[ 1 ], guns[ 2 ]) ];
+		color = palette->Colors[ *to ];
+		for(gun = 0; gun < 3; gun ++)
+		{
+			error = guns[ gun ] - color[ gun ];
+			errors[ gun + 3 ] += error * 7;
+			next[ gun - 3 ]   += error * 3;
+			next[ gun ]       += error * 5;
+			next[ gun + 3 ]   += error;
+		}
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Remap blits
+ *
+ ******************************************************************************/
+
+/*
+ * gfxClipRemap
+ *
+ *	Clips a blit from a direct color surface onto an 8 bit surface to the
+ *	source and to the clip rectangle of the target.
+ *
+ *	returns
+ *		True if anything is left to draw.
+ */
+
+static BOOL gfxClipRemap(GFXsurface *target, GFXsurface *source, int *left, int *top, int *width, int *height, int *dstLeft, int *dstTop)
+{
+	int cut;
+	if(target->BytesPerPixel != 1 || source->BytesPerPixel < 2 ||
+	   source->RedMaskSize < GFX_INVERSE_BITS || source->GreenMaskSize < GFX_INVERSE_BITS || source->BlueMaskSize < GFX_INVERSE_BITS)
+	{
+		return FALSE;
+	}
+	if(*left < 0)
+	{
+		*width   += *left;
+		*dstLeft -= *left;
+		*left     = 0;
+	}
+	if(*top < 0)
+	{
+		*height += *top;
+		*dstTop -= *top;
+		*top     = 0;
+	}
+	*width  = min(*width,  source->Width - *left);
+	*height = min(*height, source->Height - *top);
+	cut = target->ClipLeft - *dstLeft;
+	if(cut > 0)
+	{
+		*width   -= cut;
+		*left    += cut;
+		*dstLeft += cut;
+	}
+	cut = target->ClipTop - *dstTop;
+	if(cut > 0)
+	{
+		*height -= cut;
+		*top    += cut;
+		*dstTop += cut;
+	}
+	*width  = min(*width,  target->ClipRight - *dstLeft);
+	*height = min(*height, target->ClipBottom - *dstTop);
+	return *width > 0 && *height > 0;
+}
+
+/*
+ * gfxRemapBlit
+ *
+ *	Draws a rectangle of a direct color surface onto an 8 bit surface, each
+ *	pixel replaced by the nearest palette entry.
+ *
+ *	GFXsurface * target
+ *		Pointer to the 8 bit surface to draw on.
+ *	GFXsurface * source
+ *		Pointer to the 15, 16, 24 or 32 bit surface to draw.
+ *	GFXinverse * inverse
+ *		Pointer to the inverse map to look colors up in.
+ *	int left, top
+ *		Top left corner of the source rectangle.
+ *	int width, height
+ *		Size in pixels.
+ *	int dstLeft, dstTop
+ *		Top left corner of the target rectangle, clipped to the clip
+ *		rectangle of the target.
+ */
+
+void gfxRemapBlit(GFXsurface *target, GFXsurface *source, GFXinverse *inverse, int left, int top, int width, int height, int dstLeft, int dstTop)
+{
+	gfxDitherBlit(target, source, inverse, left, top, width, height, dstLeft, dstTop, GFX_DITHER_NONE, 0);
+}
+
+/*
+ * gfxDitherBlit
+ *
+ *	As 'gfxRemapBlit', dithering to hide the steps between palette colors.
+ *	The ordered dither is tied to target coordinates, so it stays in place
+ *	when the picture changes.
+ *
+ *	int method
+ *		How to dither.
+ *			GFX_DITHER_NONE
+ *			GFX_DITHER_ORDERED
+ *			GFX_DITHER_DIFFUSION
+ *	int spread
+ *		Range of the ordered dither in levels 0-255, about the distance
+ *		between neighbouring palette colors, 51 for a 6x6x6 cube.
+ */
+
+void gfxDitherBlit(GFXsurface *target, GFXsurface *source, GFXinverse *inverse, int left, int top, int width, int height, int dstLeft, int dstTop, int method, int spread)
+{
+	GFXremapFunction remap;
+	GFXcut cut;
+	const unsigned char *from;
+	unsigned char *to;
+	int *lines = NULL, *errors, *next, *swap;
+	int row, x, bias[4];
+	if(!gfxClipRemap(target, source, &left, &top, &width, &height, &dstLeft, &dstTop))
+	{
+		return;
+	}
+	if(method == GFX_DITHER_DIFFUSION)
+	{
+		/* Two lines of errors with a slot at each end */
+		lines  = calloc(2 * 3 * (width + 2), sizeof(int));
+		errors = lines;
+		next   = lines + 3 * (width + 2);
+		if(!lines)
+		{
+			method = GFX_DITHER_ORDERED;
+		}
+	}
+	gfxUpdateInverse(inverse);
+	remap = gfxRemapFunction(source, &cut);
+	from  = source->Bits + top * source->BytesPerLine + left * source->BytesPerPixel;
+	to    = target->Bits + dstTop * target->BytesPerLine + dstLeft;
+	for(row = 0; row < height; row ++, from += source->BytesPerLine, to += target->BytesPerLine)
+	{
+		switch(method)
+		{
+		case GFX_DITHER_ORDERED:
+			/* Thresholds of this line, from the first pixel */
+			for(x = 0; x < 4; x ++)
+			{
+				bias[ x ] = (2 * Bayer[ (dstTop + row) & 3 ][ (dstLeft + x) & 3 ] + 1) * spread / 32 - spread / 2;
+			}
+			if(remap == GFX_REMAP_8888)
+			{
+				GFX_ORDERED_8888(to, from, width, inverse->Table, source, bias);
+			}
+			else
+			{
+				gfxOrdered(to, from, width, inverse->Table, source, bias);
+			}
+			break;
+		case GFX_DITHER_DIFFUSION:
+			gfxDiffuse(to, from, width, inverse->Table, source, errors, next);
+			swap   = errors;
+			errors = next;
+			next   = swap;
+			memset(next, 0, 3 * (width + 2) * sizeof(int));
+			break;
+		default:
+			remap(to, from, width, inverse->Table, &cut);
+			break;
+		}
+	}
+	free(lines);
+}
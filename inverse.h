@@ -0,0 +1,66 @@
+/*******************************************************************************
+ *
+ *	Inverse library
+ *
+ *	An inverse color map gives the palette entry nearest to any color cut
+ *	to 5 bits per gun, so drawing direct color pixels onto an 8 bit surface
+ *	costs one lookup per pixel instead of a search of the palette. The map
+ *	is built from the shadow palette and rebuilt on first use after the
+ *	palette changes. Dithering, ordered or by error diffusion, hides the
+ *	steps between palette colors when showing a direct color back buffer
+ *	in an 8 bit mode.
+ */
+
+#ifndef inverse_h
+#define inverse_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Inverse structures
+ *
+ ******************************************************************************/
+
+#define GFX_INVERSE_BITS			5	/* Bits kept of each gun */
+#define GFX_INVERSE_SIZE			(1 << (3 * GFX_INVERSE_BITS))
+
+/* Cell of a color 0-255 */
+
+#define GFX_INVERSE_INDEX(r, g, b)		((((r) >> 3) << 10) | (((g) >> 3) << 5) | ((b) >> 3))
+
+/* Dither methods */
+
+#define GFX_DITHER_NONE				0
+#define GFX_DITHER_ORDERED			1	/* 4x4 Bayer thresholds */
+#define GFX_DITHER_DIFFUSION			2	/* Floyd-Steinberg error diffusion */
+
+typedef struct
+{
+	unsigned char *Table;			/* Indexed by GFX_INVERSE_INDEX */
+	unsigned long *Distances;		/* Squared distance of each cell to its entry, while building */
+	unsigned long  Serial;			/* Palette serial built at, 0 for never */
+
+} GFXinverse;
+
+/*******************************************************************************
+ *
+ *	Inverse functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreateInverse(GFXinverse *inverse);
+
+void gfxDestroyInverse(GFXinverse *inverse);
+
+void gfxUpdateInverse(GFXinverse *inverse);
+
+int gfxInverseColor(GFXinverse *inverse, int red, int green, int blue);
+
+void gfxRemapBlit(GFXsurface *target, GFXsurface *source, GFXinverse *inverse, int left, int top, int width, int height, int dstLeft, int dstTop);
+
+void gfxDitherBlit(GFXsurface *target, GFXsurface *source, GFXinverse *inverse, int left, int top, int width, int height, int dstLeft, int dstTop, int method, int spread);
+
+
+#endif /* inverse_h */
@@ -0,0 +1,500 @@
+/*******************************************************************************
+ *
+ *	Lookup library
+ *
+ *	Translucency and lighting for 8 bit surfaces through tables built from
+ *	the shadow palette. A blend table gives the palette entry nearest to a
+ *	mix of any two entries, and a colormap gives each entry faded towards a
+ *	color over a number of light levels. Drawing through them costs one
+ *	table read per pixel.
+ *
+ *	Tables remember the palette serial they were built at and are brought
+ *	up to date before each use, redoing only the cells a palette write can
+ *	have changed. A cell made from changed entries is searched again. Any
+ *	other cell keeps its entry unless one of the changed entries is now
+ *	closer, so a write of a few entries costs a few compares per cell
+ *	rather than a search of the palette.
+ *
+ *	Rows without a color key are done four pixels at a time, so the target
+ *	is read and written a dword at a time, which matters in video memory.
+ */
+
+#include <stdlib.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "palette.h"
+#include "lookup.h"
+
+/* Mixes two colors, weight 0-256 of the first */
+
+#define GFX_BLEND(a, b, weight)			(((a) * (weight) + (b) * (256 - (weight)) + 128) >> 8)
+
+/* What changed in the palette since a table was built */
+
+typedef struct
+{
+	BOOL Changed[256];
+	int  List[256];
+	int  Count;
+
+} GFXchanges;
+
+/*******************************************************************************
+ *
+ *	Table building
+ *
+ ******************************************************************************/
+
+/*
+ * gfxFindChanges
+ */
+
+static void gfxFindChanges(GFXchanges *changes, unsigned long serial)
+{
+	int entry;
+	changes->Count = 0;
+	gfxPaletteChanges(serial, changes->Changed);
+	for(entry = 0; entry < 256; entry ++)
+	{
+		if(changes->Changed[ entry ])
+		{
+			changes->List[ changes->Count ++ ] = entry;
+		}
+	}
+}
+
+/*
+ * gfxRefineCell
+ *
+ *	Brings the entry of one cell up to date with the palette.
+ *
+ *	unsigned char * cell
+ *		The entry to update.
+ *	int red, green, blue
+ *		Color the cell stands for.
+ *	BOOL stale
+ *		The color was made from changed entries, so search the palette.
+ */
+
+static void gfxRefineCell(unsigned char *cell, int red, int green, int blue, BOOL stale, GFXchanges *changes, const GFXpalette *palette)
+{
+	const unsigned char *color;
+	long distance, best;
+	int index, entry;
+	if(stale || changes->Changed[ *cell ])
+	{
+		*cell = (unsigned char)gfxNearestColor(red, green, blue);
+		return;
+	}
+	color = palette->Colors[ *cell ];
+	best  = (long)(color[ 0 ] - red) * (color[ 0 ] - red) +
+	        (long)(color[ 1 ] - green) * (color[ 1 ] - green) +
+	        (long)(color[ 2 ] - blue) * (color[ 2 ] - blue);
+	for(index = 0; index < changes->Count; index ++)
+	{
+		entry    = changes->List[ index ];
+		color    = palette->Colors[ entry ];
+		distance = (long)(color[ 0 ] - red) * (color[ 0 ] - red) +
+		           (long)(color[ 1 ] - green) * (color[ 1 ] - green) +
+		           (long)(color[ 2 ] - blue) * (color[ 2 ] - blue);
+		/* Ties go to the lower entry, as in a full search */
+		if(distance < best || (distance == best && entry < *cell))
+		{
+			best  = distance;
+			*cell = (unsigned char)entry;
+		}
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Blend tables
+ *
+ ******************************************************************************/
+
+/*
+ * gfxCreateBlendTable
+ *
+ *	The table is built on first use, from the palette at that time.
+ *
+ *	GFXblendTable * table
+ *		Pointer to a blend table structure to initialize.
+ *	int weight
+ *		Share of the source in each mix, 0-256, 128 for half and half.
+ *	returns
+ *		True if the table was allocated.
+ */
+
+BOOL gfxCreateBlendTable(GFXblendTable *table, int weight)
+{
+	table->Weight = max(0, min(weight, 256));
+	table->Serial = 0;
+	table->Table  = malloc(256 * 256);
+	return table->Table != NULL;
+}
+
+/*
+ * gfxDestroyBlendTable
+ */
+
+void gfxDestroyBlendTable(GFXblendTable *table)
+{
+	free(table->Table);
+	table->Table  = NULL;
+	table->Serial = 0;
+}
+
+/*
+ * gfxUpdateBlendTable
+ *
+ *	Brings the table up to date with the shadow palette. Called by the blend
+ *	functions, so only needed to move the work out of a frame.
+ */
+
+void gfxUpdateBlendTable(GFXblendTable *table)
+{
+	const GFXpalette *palette = gfxGetPalette();
+	const unsigned char *source, *target;
+	unsigned char *cell;
+	GFXchanges changes;
+	int s, t, weight = table->Weight;
+	if(table->Serial == palette->Serial || !table->Table)
+	{
+		return;
+	}
+	gfxFindChanges(&changes, table->Serial);
+	if(changes.Count > 0)
+	{
+		cell = table->Table;
+		for(s = 0; s < 256; s ++)
+		{
+			source = palette->Colors[ s ];
+			for(t = 0; t < 256; t ++, cell ++)
+			{
+				target = palette->Colors[ t ];
+				gfxRefineCell(cell, GFX_BLEND(source[ 0 ], target[ 0 ], weight),
+				                    GFX_BLEND(source[ 1 ], target[ 1 ], weight),
+				                    GFX_BLEND(source[ 2 ], target[ 2 ], weight),
+				              changes.Changed[ s ] || changes.Changed[ t ], &changes, palette);
+			}
+		}
+	}
+	table->Serial = palette->Serial;
+}
+
+/*******************************************************************************
+ *
+ *	Colormaps
+ *
+ ******************************************************************************/
+
+/*
+ * gfxCreateColormap
+ *
+ *	The colormap is built on first use, from the palette at that time.
+ *
+ *	GFXcolormap * map
+ *		Pointer to a colormap structure to initialize.
+ *	int levels
+ *		Number of light levels, at least 2.
+ *	int red, green, blue
+ *		Color at level 0, black for lighting or a fog color.
+ *	returns
+ *		True if the colormap was allocated.
+ */
+
+BOOL gfxCreateColormap(GFXcolormap *map, int levels, int red, int green, int blue)
+{
+	map->Levels    = max(levels, 2);
+	map->FadeRed   = red;
+	map->FadeGreen = green;
+	map->FadeBlue  = blue;
+	map->Serial    = 0;
+	map->Table     = malloc(map->Levels * 256);
+	return map->Table != NULL;
+}
+
+/*
+ * gfxDestroyColormap
+ */
+
+void gfxDestroyColormap(GFXcolormap *map)
+{
+	free(map->Table);
+	map->Table  = NULL;
+	map->Serial = 0;
+}
+
+/*
+ * gfxUpdateColormap
+ *
+ *	As 'gfxUpdateBlendTable'.
+ */
+
+void gfxUpdateColormap(GFXcolormap *map)
+{
+	const GFXpalette *palette = gfxGetPalette();
+	const unsigned char *color;
+	unsigned char *cell;
+	GFXchanges changes;
+	int level, entry, weight;
+	if(map->Serial == palette->Serial || !map->Table)
+	{
+		return;
+	}
+	gfxFindChanges(&changes, map->Serial);
+	if(changes.Count > 0)
+	{
+		cell = map->Table;
+		for(level = 0; level < map->Levels; level ++)
+		{
+			weight = level * 256 / (map->Levels - 1);
+			for(entry = 0; entry < 256; entry ++, cell ++)
+			{
+				color = palette->Colors[ entry ];
+				gfxRefineCell(cell, GFX_BLEND(color[ 0 ], map->FadeRed, weight),
+				                    GFX_BLEND(color[ 1 ], map->FadeGreen, weight),
+				                    GFX_BLEND(color[ 2 ], map->FadeBlue, weight),
+				              changes.Changed[ entry ], &changes, palette);
+			}
+		}
+	}
+	map->Serial = palette->Serial;
+}
+
+/*******************************************************************************
+ *
+ *	Rows
+ *
+ ******************************************************************************/
+
+/*
+ * gfxBlendRow
+ *
+ *	Looks up each pair of source and target pixels.
+ */
+
+static void gfxBlendRow(unsigned char *to, const unsigned char *from, int count, const unsigned char *table)
+{
+	unsigned long s, t;
+	for(; count >= 4; count -= 4, to += 4, from += 4)
+	{
+		s = GFX_GET_4(from);
+		t = GFX_GET_4(to);
+		GFX_PUT_4(to, (unsigned long)table[ ((s << 8) & 0xFF00) | (t & 0xFF) ] |
+		              (unsigned long)table[ (s & 0xFF00) | ((t >> 8) & 0xFF) ] << 8 |
+		              (unsigned long)table[ ((s >> 8) & 0xFF00) | ((t >> 16) & 0xFF) ] << 16 |
+		              (unsigned long)table[ ((s >> 16) & 0xFF00) | ((t >> 24) & 0xFF) ] << 24);
+	}
+	for(; count > 0; count --, to ++, from ++)
+	{
+		*to = table[ *from << 8 | *to ];
+	}
+}
+
+static void gfxBlendRowKeyed(unsigned char *to, const unsigned char *from, int count, const unsigned char *table, int key)
+{
+	for(; count > 0; count --, to ++, from ++)
+	{
+		if(*from != key)
+		{
+			*to = table[ *from << 8 | *to ];
+		}
+	}
+}
+
+/*
+ * gfxMapRow
+ *
+ *	Looks up each source pixel in one level of a colormap. Mapping a row
+ *	onto itself shades it in place.
+ */
+
+static void gfxMapRow(unsigned char *to, const unsigned char *from, int count, const unsigned char *map)
+{
+	unsigned long s;
+	for(; count >= 4; count -= 4, to += 4, from += 4)
+	{
+		s = GFX_GET_4(from);
+		GFX_PUT_4(to, (unsigned long)map[ s & 0xFF ] |
+		              (unsigned long)map[ (s >> 8) & 0xFF ] << 8 |
+		              (unsigned long)map[ (s >> 16) & 0xFF ] << 16 |
+		              (unsigned long)map[ (s >> 24) & 0xFF ] << 24);
+	}
+	for(; count > 0; count --, to ++, from ++)
+	{
+		*to = map[ *from ];
+	}
+}
+
+static void gfxMapRowKeyed(unsigned char *to, const unsigned char *from, int count, const unsigned char *map, int key)
+{
+	for(; count > 0; count --, to ++, from ++)
+	{
+		if(*from != key)
+		{
+			*to = map[ *from ];
+		}
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Lookup blits
+ *
+ ******************************************************************************/
+
+/*
+ * gfxClipLookup
+ *
+ *	Clips a blit between 8 bit surfaces to the source and to the clip
+ *	rectangle of the target.
+ *
+ *	returns
+ *		True if anything is left to draw.
+ */
+
+static BOOL gfxClipLookup(GFXsurface *target, GFXsurface *source, int *left, int *top, int *width, int *height, int *dstLeft, int *dstTop)
+{
+	int cut;
+	if(target->BytesPerPixel != 1 || source->BytesPerPixel != 1)
+	{
+		return FALSE;
+	}
+	if(*left < 0)
+	{
+		*width   += *left;
+		*dstLeft -= *left;
+		*left     = 0;
+	}
+	if(*top < 0)
+	{
+		*height += *top;
+		*dstTop -= *top;
+		*top     = 0;
+	}
+	*width  = min(*width,  source->Width - *left);
+	*height = min(*height, source->Height - *top);
+	cut = target->ClipLeft - *dstLeft;
+	if(cut > 0)
+	{
+		*width   -= cut;
+		*left    += cut;
+		*dstLeft += cut;
+	}
+	cut = target->ClipTop - *dstTop;
+	if(cut > 0)
+	{
+		*height -= cut;
+		*top    += cut;
+		*dstTop += cut;
+	}
+	*width  = min(*width,  target->ClipRight - *dstLeft);
+	*height = min(*height, target->ClipBottom - *dstTop);
+	return *width > 0 && *height > 0;
+}
+
+/*
+ * gfxBlendBlit
+ *
+ *	Draws a rectangle of an 8 bit surface translucently, each pixel mixed
+ *	with the one under it through a blend table.
+ *
+ *	GFXsurface * target
+ *		Pointer to the 8 bit surface to draw on.
+ *	GFXsurface * source
+ *		Pointer to the 8 bit surface to draw, not overlapping the target.
+ *	GFXblendTable * table
+ *		Pointer to the blend table to mix with.
+ *	int left, top
+ *		Top left corner of the source rectangle.
+ *	int width, height
+ *		Size in pixels.
+ *	int dstLeft, dstTop
+ *		Top left corner of the target rectangle.
+ *	int flags
+ *		GFX_LOOKUP_COLORKEY to leave the target alone under the key.
+ *	unsigned long key
+ *		Source pixel value to skip.
+ */
+
+void gfxBlendBlit(GFXsurface *target, GFXsurface *source, GFXblendTable *table, int left, int top, int width, int height, int dstLeft, int dstTop, int flags, unsigned long key)
+{
+	unsigned char *from, *to;
+	int row;
+	if(!gfxClipLookup(target, source, &left, &top, &width, &height, &dstLeft, &dstTop))
+	{
+		return;
+	}
+	gfxUpdateBlendTable(table);
+	from = source->Bits + top * source->BytesPerLine + left;
+	to   = target->Bits + dstTop * target->BytesPerLine + dstLeft;
+	for(row = 0; row < height; row ++, from += source->BytesPerLine, to += target->BytesPerLine)
+	{
+		if(flags & GFX_LOOKUP_COLORKEY)
+		{
+			gfxBlendRowKeyed(to, from, width, table->Table, (int)key);
+		}
+		else
+		{
+			gfxBlendRow(to, from, width, table->Table);
+		}
+	}
+}
+
+/*
+ * gfxColormapBlit
+ *
+ *	Draws a rectangle of an 8 bit surface lit to one level of a colormap.
+ *
+ *	GFXcolormap * map
+ *		Pointer to the colormap to light with.
+ *	int level
+ *		Light level, clamped to the levels of the colormap.
+ */
+
+void gfxColormapBlit(GFXsurface *target, GFXsurface *source, GFXcolormap *map, int level, int left, int top, int width, int height, int dstLeft, int dstTop, int flags, unsigned long key)
+{
+	const unsigned char *table;
+	unsigned char *from, *to;
+	int row;
+	if(!gfxClipLookup(target, source, &left, &top, &width, &height, &dstLeft, &dstTop))
+	{
+		return;
+	}
+	gfxUpdateColormap(map);
+	table = map->Table + max(0, min(level, map->Levels - 1)) * 256;
+	from  = source->Bits + top * source->BytesPerLine + left;
+	to    = target->Bits + dstTop * target->BytesPerLine + dstLeft;
+	for(row = 0; row < height; row ++, from += source->BytesPerLine, to += target->BytesPerLine)
+	{
+		if(flags & GFX_LOOKUP_COLORKEY)
+		{
+			gfxMapRowKeyed(to, from, width, table, (int)key);
+		}
+		else
+		{
+			gfxMapRow(to, from, width, table);
+		}
+	}
+}
+
+/*
+ * gfxColormapRect
+ *
+ *	Lights a rectangle of an 8 bit surface in place, for shadows and fades.
+ *	As with the clip rectangle the maximum coordinates are inclusive.
+ *
+ *	GFXsurface * surface
+ *		Pointer to the 8 bit surface.
+ *	GFXcolormap * map
+ *		Pointer to the colormap to light with.
+ *	int level
+ *		Light level, clamped to the levels of the colormap.
+ */
+
+void gfxColormapRect(GFXsurface *surface, GFXcolormap *map, int level, int xmin, int ymin, int xmax, int ymax)
+{
+	gfxColormapBlit(surface, surface, map, level, xmin, ymin, xmax - xmin + 1, ymax - ymin + 1, xmin, ymin, 0, 0);
+}
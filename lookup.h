@@ -0,0 +1,80 @@
+/*******************************************************************************
+ *
+ *	Lookup library
+ *
+ *	Translucency and lighting for 8 bit surfaces through tables built from
+ *	the shadow palette. A blend table gives the palette entry nearest to a
+ *	mix of any two entries, and a colormap gives each entry faded towards a
+ *	color over a number of light levels. Drawing through them costs one
+ *	table read per pixel.
+ *
+ *	Tables remember the palette serial they were built at and are brought
+ *	up to date before each use, redoing only the cells a palette write can
+ *	have changed.
+ */
+
+#ifndef lookup_h
+#define lookup_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Lookup structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	unsigned char *Table;			/* 256 x 256, indexed by source << 8 | target */
+	int            Weight;			/* Of the source, 0-256 */
+	unsigned long  Serial;			/* Palette serial built at, 0 for never */
+
+} GFXblendTable;
+
+typedef struct
+{
+	unsigned char *Table;			/* Levels x 256, indexed by level << 8 | color */
+	int            Levels;			/* Level 0 is the fade color, the last the palette */
+	int            FadeRed;
+	int            FadeGreen;
+	int            FadeBlue;
+	unsigned long  Serial;
+
+} GFXcolormap;
+
+/*******************************************************************************
+ *
+ *	Lookup flags
+ *
+ ******************************************************************************/
+
+#define GFX_LOOKUP_COLORKEY			0x01	/* Skip source pixels equal to the key */
+
+/*******************************************************************************
+ *
+ *	Lookup functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreateBlendTable(GFXblendTable *table, int weight);
+
+void gfxDestroyBlendTable(GFXblendTable *table);
+
+void gfxUpdateBlendTable(GFXblendTable *table);
+
+BOOL gfxCreateColormap(GFXcolormap *map, int levels, int red, int green, int blue);
+
+void gfxDestroyColormap(GFXcolormap *map);
+
+void gfxUpdateColormap(GFXcolormap *map);
+
+void gfxBlendBlit(GFXsurface *target, GFXsurface *source, GFXblendTable *table, int left, int top, int width, int height, int dstLeft, int dstTop, int flags, unsigned long key);
+
+void gfxColormapBlit(GFXsurface *target, GFXsurface *source, GFXcolormap *map, int level, int left, int top, int width, int height, int dstLeft, int dstTop, int flags, unsigned long key);
+
+void gfxColormapRect(GFXsurface *surface, GFXcolormap *map, int level, int xmin, int ymin, int xmax, int ymax);
+
+
+#endif /* lookup_h */
@@ -0,0 +1,116 @@
+/*******************************************************************************
+ *
+ *	Low resolution library
+ *
+ *	Shows a smaller frame buffer on the timings of the current mode by
+ *	having the CRT controller repeat each line two or four times and the
+ *	sequencer halve the dot clock so each pixel is twice as wide. The
+ *	monitor sees the same line and frame rates, and drawing touches a half
+ *	to an eighth as many pixels, with no scaling pass.
+ *
+ *	Halving the dot clock alone would halve the line rate, so the
+ *	horizontal counts are halved with it. The line offset is halved too,
+ *	so the lines of the smaller frame buffer follow each other closely.
+ */
+
+#include "farseg.h"
+#include "VGAio.h"
+#include "lowres.h"
+
+/* CRT controller registers saved, up to and including the line compare */
+
+#define GFX_LOWRES_CRTC_REGISTERS		(VGA_LINE_COMPARE + 1)
+
+static struct
+{
+	BOOL Active;
+	int  CRTC[GFX_LOWRES_CRTC_REGISTERS];
+	BOOL Halved;
+
+} Saved = { FALSE };
+
+/*
+ * gfxEnterLowRes
+ *
+ *	Programs the current mode to show a smaller frame buffer and describes
+ *	it as a surface. The registers change at the start of vertical retrace.
+ *
+ *	GFXsurface * lowres
+ *		Pointer to a surface structure to fill in with the smaller frame
+ *		buffer, which starts where the mode's does.
+ *	GFXsurface * mode
+ *		The frame buffer of the current mode, as from 'gfxModeSurface'.
+ *	int xScale
+ *		1, or 2 to halve the dot clock.
+ *	int yScale
+ *		1, 2 or 4 lines shown for each line of the frame buffer, on top of
+ *		any repeat the mode already has.
+ *	returns
+ *		False if the scales are not supported or the mode's lines cannot
+ *		be packed closer.
+ */
+
+BOOL gfxEnterLowRes(GFXsurface *lowres, GFXsurface *mode, int xScale, int yScale)
+{
+	int index, repeat, offset;
+	if(Saved.Active || (xScale != 1 && xScale != 2) || (yScale != 1 && yScale != 2 && yScale != 4))
+	{
+		return FALSE;
+	}
+	vgaResolveCRTCAddresses();
+	repeat = vgaGetScanRepeat() * yScale;
+	offset = vgaQueryCRTC(VGA_OFFSET);
+	if(repeat > 32 || (xScale == 2 && ((offset & 1) || (mode->BytesPerLine & 1) || vgaIsDotClockHalved())))
+	{
+		return FALSE;
+	}
+	for(index = 0; index < GFX_LOWRES_CRTC_REGISTERS; index ++)
+	{
+		Saved.CRTC[ index ] = vgaQueryCRTC(index);
+	}
+	Saved.Halved = vgaIsDotClockHalved();
+	Saved.Active = TRUE;
+	vgaOnSync();
+	if(xScale == 2)
+	{
+		vgaSetDotClockHalved(TRUE);
+		vgaHalveHorizontalTiming();
+		vgaWriteCRTC(VGA_OFFSET, offset / 2);
+	}
+	vgaSetScanRepeat(repeat);
+	*lowres              = *mode;
+	lowres->Width        = mode->Width / xScale;
+	lowres->Height       = mode->Height / yScale;
+	lowres->BytesPerLine = mode->BytesPerLine / xScale;
+	lowres->Allocated    = FALSE;
+	gfxSetClipRect(lowres, 0, 0, lowres->Width - 1, lowres->Height - 1);
+	return TRUE;
+}
+
+/*
+ * gfxLeaveLowRes
+ *
+ *	Puts back the registers changed by 'gfxEnterLowRes'.
+ */
+
+void gfxLeaveLowRes(void)
+{
+	int index;
+	if(!Saved.Active)
+	{
+		return;
+	}
+	vgaOnSync();
+	vgaSetDotClockHalved(Saved.Halved);
+	/* The protect bit is in the vertical retrace end, which is written last */
+	vgaWriteCRTC(VGA_VERTICAL_RETRACE_END, Saved.CRTC[ VGA_VERTICAL_RETRACE_END ] & ~VGA_CRTC_REGISTERS_PROTECT_ENABLE_BIT);
+	for(index = 0; index < GFX_LOWRES_CRTC_REGISTERS; index ++)
+	{
+		if(index != VGA_VERTICAL_RETRACE_END)
+		{
+			vgaWriteCRTC(index, Saved.CRTC[ index ]);
+		}
+	}
+	vgaWriteCRTC(VGA_VERTICAL_RETRACE_END, Saved.CRTC[ VGA_VERTICAL_RETRACE_END ]);
+	Saved.Active = FALSE;
+}
@@ -0,0 +1,32 @@
+/*******************************************************************************
+ *
+ *	Low resolution library
+ *
+ *	Shows a smaller frame buffer on the timings of the current mode by
+ *	having the CRT controller repeat each line two or four times and the
+ *	sequencer halve the dot clock so each pixel is twice as wide. The
+ *	monitor sees the same line and frame rates, and drawing touches a half
+ *	to an eighth as many pixels, with no scaling pass.
+ *
+ *	The registers are the standard VGA ones, so this works in VGA modes and
+ *	in those VBE modes the BIOS reports as VGA compatible.
+ */
+
+#ifndef lowres_h
+#define lowres_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Low resolution functions
+ *
+ ******************************************************************************/
+
+BOOL gfxEnterLowRes(GFXsurface *lowres, GFXsurface *mode, int xScale, int yScale);
+
+void gfxLeaveLowRes(void);
+
+
+#endif /* lowres_h */
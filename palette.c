@@ -0,0 +1,336 @@
+/*******************************************************************************
+ *
+ *	Palette library
+ *
+ *	Keeps a shadow copy of the 256 DAC registers with 8 bits per gun, so
+ *	drawing code can look colors up without reading the DAC back. Every
+ *	write goes through the shadow and then to the DAC. Each entry is
+ *	stamped with the serial number of the write that last changed it, so
+ *	tables built from the palette can redo only what a write touched.
+ *
+ *	The DAC is written with 6 bits per gun through the VGA ports until
+ *	'gfxNegotiateDAC' finds out what the card can do. A switchable DAC is
+ *	set to 8 bits, and a DAC that is not VGA compatible is written through
+ *	VBE, during vertical retrace if the card needs the blank bit. Setting
+ *	a mode puts the DAC back to 6 bits, so once 'vgaSetMode' or 'vbeSetMode'
+ *	has run the palette goes back to 6 bits through the VGA ports until
+ *	'gfxNegotiateDAC' is called again. The shadow keeps 8 bits either way
+ *	and is scaled on the way out.
+ *	A color correction ramp is applied on the way out too, so correcting
+ *	the display changes neither the shadow nor any table built from it.
+ */
+
+#include <string.h>
+
+#include "intern.h"
+#include "VGAio.h"
+#include "VBE.h"
+#include "palette.h"
+
+/* Serial 0 is left for tables that were never built */
+
+static GFXpalette Palette = { { { 0 } }, { 0 }, 1 };
+
+static int           DACBits       = 6;
+static BOOL          DACThroughVBE = FALSE;
+static BOOL          DACBlank      = FALSE;	/* Written during vertical retrace */
+static unsigned long DACModeSets   = 0;	/* Mode sets when negotiated */
+
+static GFXramp Ramp;
+static BOOL    Ramped = FALSE;
+
+/*
+ * gfxCheckDAC
+ *
+ *	Goes back to the DAC a mode set leaves, if a mode was set since the
+ *	DAC was negotiated.
+ */
+
+static void gfxCheckDAC(void)
+{
+	unsigned long modeSets = vgaGetModeSets() + vbeGetModeSets();
+	if(modeSets != DACModeSets)
+	{
+		DACBits       = 6;
+		DACThroughVBE = FALSE;
+		DACBlank      = FALSE;
+		DACModeSets   = modeSets;
+	}
+}
+
+/*
+ * gfxWriteDAC
+ *
+ *	Copies a range of the shadow palette to the DAC, through the ramp.
+ */
+
+static void gfxWriteDAC(int index, int count)
+{
+	char dac[256][3], vbe[256][4];
+	int entry, red, green, blue, shift;
+	gfxCheckDAC();
+	shift = 8 - DACBits;
+	for(entry = index; entry < index + count; entry ++)
+	{
+		red   = Palette.Colors[ entry ][ 0 ];
+		green = Palette.Colors[ entry ][ 1 ];
+		blue  = Palette.Colors[ entry ][ 2 ];
+		if(Ramped)
+		{
+			red   = Ramp.Red[ red ];
+			green = Ramp.Green[ green ];
+			blue  = Ramp.Blue[ blue ];
+		}
+		dac[ entry ][ 0 ] = red >> shift;
+		dac[ entry ][ 1 ] = green >> shift;
+		dac[ entry ][ 2 ] = blue >> shift;
+	}
+	if(DACThroughVBE)
+	{
+		for(entry = index; entry < index + count; entry ++)
+		{
+			vbe[ entry ][ 0 ] = dac[ entry ][ 2 ];
+			vbe[ entry ][ 1 ] = dac[ entry ][ 1 ];
+			vbe[ entry ][ 2 ] = dac[ entry ][ 0 ];
+			vbe[ entry ][ 3 ] = 0;
+		}
+		if(!DACBlank || !vbeSetPaletteOnSync(index, count, vbe))
+		{
+			vbeSetPalette(index, count, vbe);
+		}
+		return;
+	}
+	vgaWritePaletteRange(dac, index, count);
+}
+
+/*
+ * gfxNegotiateDAC
+ *
+ *	Sets the DAC to the widest guns the card offers and writes the shadow
+ *	palette out again at that width. Setting a mode puts the DAC back to 6
+ *	bits, and the palette with it, so this is called after each mode set.
+ *
+ *	VBEinfo * info
+ *		Controller information from 'vbeGetInfo', or NULL for a plain VGA.
+ *	returns
+ *		The number of bits per gun in use, 6 or 8.
+ */
+
+int gfxNegotiateDAC(VBEinfo *info)
+{
+	int bits = 6;
+	if(info && (info->Capabilities & VBE_SWITCHABLE_DAC))
+	{
+		bits = vbeSetPaletteDepth(8);
+		if(bits < 6 || bits > 8)
+		{
+			bits = 6;
+		}
+	}
+	DACBits       = bits;
+	DACThroughVBE = info && (info->Capabilities & VBE_NON_VGA_CONTROLLER);
+	DACBlank      = DACThroughVBE && (info->Capabilities & VBE_BLANK_RAMDAC);
+	DACModeSets   = vgaGetModeSets() + vbeGetModeSets();
+	gfxWriteDAC(0, 256);
+	return DACBits;
+}
+
+/*
+ * gfxGetDACBits
+ *
+ *	returns
+ *		The number of bits per gun the DAC is written with.
+ */
+
+int gfxGetDACBits(void)
+{
+	gfxCheckDAC();
+	return DACBits;
+}
+
+/*
+ * gfxSetPaletteRamp
+ *
+ *	Sets the color correction applied to the palette as it is written to
+ *	the DAC, and writes the whole palette out again.
+ *
+ *	GFXramp * ramp
+ *		The ramp to apply, NULL for none.
+ */
+
+void gfxSetPaletteRamp(GFXramp *ramp)
+{
+	Ramped = (ramp != NULL);
+	if(ramp)
+	{
+		memcpy(&Ramp, ramp, sizeof(GFXramp));
+	}
+	gfxWriteDAC(0, 256);
+}
+
+/*
+ * gfxGetPalette
+ *
+ *	returns
+ *		The shadow palette, to be read only.
+ */
+
+const GFXpalette *gfxGetPalette(void)
+{
+	return &Palette;
+}
+
+/*
+ * gfxSetPalette
+ *
+ *	Sets a range of palette entries. Only the entries whose color differs
+ *	are stamped as changed, though the whole range is sent to the DAC.
+ *
+ *	unsigned char colors[256][3]
+ *		Red, green and blue 0-255, indexed from 0 like the palette.
+ *	int index
+ *		First entry to set.
+ *	int count
+ *		Number of entries.
+ */
+
+void gfxSetPalette(unsigned char colors[256][3], int index, int count)
+{
+	int entry;
+	if(index < 0 || count <= 0 || index + count > 256)
+	{
+		return;
+	}
+	Palette.Serial ++;
+	for(entry = index; entry < index + count; entry ++)
+	{
+		if(memcmp(Palette.Colors[ entry ], colors[ entry ], 3) != 0)
+		{
+			memcpy(Palette.Colors[ entry ], colors[ entry ], 3);
+			Palette.Changed[ entry ] = Palette.Serial;
+		}
+	}
+	gfxWriteDAC(index, count);
+}
+
+/*
+ * gfxSetPaletteColor
+ */
+
+void gfxSetPaletteColor(int index, int red, int green, int blue)
+{
+	unsigned char colors[256][3];
+	colors[ index & 0xFF ][ 0 ] = (unsigned char)red;
+	colors[ index & 0xFF ][ 1 ] = (unsigned char)green;
+	colors[ index & 0xFF ][ 2 ] = (unsigned char)blue;
+	gfxSetPalette(colors, index, 1);
+}
+
+/*
+ * gfxGetPaletteColor
+ */
+
+void gfxGetPaletteColor(int index, int *red, int *green, int *blue)
+{
+	index &= 0xFF;
+	setsafe(red,   Palette.Colors[ index ][ 0 ]);
+	setsafe(green, Palette.Colors[ index ][ 1 ]);
+	setsafe(blue,  Palette.Colors[ index ][ 2 ]);
+}
+
+/*
+ * gfxReadPalette
+ *
+ *	Loads the shadow palette from the DAC, after a mode set or after other
+ *	code has written the DAC directly.
+ */
+
+void gfxReadPalette(void)
+{
+	char dac[256][3], vbe[256][4];
+	unsigned char colors[256][3];
+	int entry, gun, value, mask;
+	gfxCheckDAC();
+	mask = (1 << DACBits) - 1;
+	if(DACThroughVBE)
+	{
+		vbeGetPalette(0, 256, vbe);
+		for(entry = 0; entry < 256; entry ++)
+		{
+			dac[ entry ][ 0 ] = vbe[ entry ][ 2 ];
+			dac[ entry ][ 1 ] = vbe[ entry ][ 1 ];
+			dac[ entry ][ 2 ] = vbe[ entry ][ 0 ];
+		}
+	}
+	else
+	{
+		vgaReadEntirePalette(dac);
+	}
+	for(entry = 0; entry < 256; entry ++)
+	{
+		for(gun = 0; gun < 3; gun ++)
+		{
+			/* Stretch the guns over 0-255 */
+			value = dac[ entry ][ gun ] & mask;
+			colors[ entry ][ gun ] = (unsigned char)((value << (8 - DACBits)) | (value >> (2 * DACBits - 8)));
+		}
+	}
+	gfxSetPalette(colors, 0, 256);
+}
+
+/*
+ * gfxPaletteChanges
+ *
+ *	Finds the entries written since a table was built.
+ *
+ *	unsigned long serial
+ *		Palette serial the table was built at, 0 for all entries.
+ *	BOOL changed[256]
+ *		Set for each entry changed after that serial.
+ *	returns
+ *		The number of entries changed.
+ */
+
+int gfxPaletteChanges(unsigned long serial, BOOL changed[256])
+{
+	int entry, count = 0;
+	for(entry = 0; entry < 256; entry ++)
+	{
+		changed[ entry ] = (serial == 0 || Palette.Changed[ entry ] > serial);
+		if(changed[ entry ])
+		{
+			count ++;
+		}
+	}
+	return count;
+}
+
+/*
+ * gfxNearestColor
+ *
+ *	Searches the palette for the entry closest to a color.
+ *
+ *	int red, green, blue
+ *		Color 0-255.
+ *	returns
+ *		The index of the closest entry, the lowest on a tie.
+ */
+
+int gfxNearestColor(int red, int green, int blue)
+{
+	long distance, best = 0x7FFFFFFFL;
+	int entry, nearest = 0, dr, dg, db;
+	for(entry = 0; entry < 256 && best > 0; entry ++)
+	{
+		dr = Palette.Colors[ entry ][ 0 ] - red;
+		dg = Palette.Colors[ entry ][ 1 ] - green;
+		db = Palette.Colors[ entry ][ 2 ] - blue;
+		distance = (long)dr * dr + (long)dg * dg + (long)db * db;
+		if(distance < best)
+		{
+			best    = distance;
+			nearest = entry;
+		}
+	}
+	return nearest;
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ *
+ *	Palette library
+ *
+ *	Keeps a shadow copy of the 256 DAC registers with 8 bits per gun, so
+ *	drawing code can look colors up without reading the DAC back. Every
+ *	write goes through the shadow and then to the DAC. Each entry is
+ *	stamped with the serial number of the write that last changed it, so
+ *	tables built from the palette can redo only what a write touched.
+ *
+ *	The shadow is scaled to the width of the DAC guns when it is written
+ *	out, so callers never deal in 6 bit values. The DAC is taken to have 6
+ *	bit guns behind the VGA ports until 'gfxNegotiateDAC' is called, and
+ *	again after every mode set through 'vgaSetMode' or 'vbeSetMode', so
+ *	call it after each mode set for an 8 bit DAC.
+ */
+
+#ifndef palette_h
+#define palette_h
+
+#include "VGA.h"
+#include "VBE.h"
+#include "gamma.h"
+
+/*******************************************************************************
+ *
+ *	Palette structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	unsigned char Colors[256][3];		/* Red, green and blue, 0-255 */
+	unsigned long Changed[256];		/* Serial of the last write to each entry */
+	unsigned long Serial;			/* Serial of the last write, from 1 */
+
+} GFXpalette;
+
+/*******************************************************************************
+ *
+ *	Palette functions
+ *
+ ******************************************************************************/
+
+int gfxNegotiateDAC(VBEinfo *info);
+
+int gfxGetDACBits(void);
+
+void gfxSetPaletteRamp(GFXramp *ramp);
+
+const GFXpalette *gfxGetPalette(void);
+
+void gfxSetPalette(unsigned char colors[256][3], int index, int count);
+
+void gfxSetPaletteColor(int index, int red, int green, int blue);
+
+void gfxGetPaletteColor(int index, int *red, int *green, int *blue);
+
+void gfxReadPalette(void);
+
+int gfxPaletteChanges(unsigned long serial, BOOL changed[256]);
+
+int gfxNearestColor(int red, int green, int blue);
+
+
+#endif /* palette_h */
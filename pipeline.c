@@ -0,0 +1,877 @@
+/*******************************************************************************
+ *
+ *	Pipeline library
+ *
+ *	Draws small 3D scenes with the polygon, shade and texture libraries.
+ *	Vertices are transformed by a floating point matrix, clipped to the
+ *	view frustum, culled when facing away and projected onto the surface.
+ *
+ *	Hidden surfaces are removed with either a 16 bit z-buffer or a span
+ *	buffer. Both sit between the scan converter and the span function of
+ *	the material, cutting each span into the runs that are visible, so
+ *	every material works with either.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "polygon.h"
+#include "shade.h"
+#include "texture.h"
+#include "pipeline.h"
+
+/* Z-buffer values of the near and far planes, kept clear of the ends so
+   stepping past the edge of a triangle cannot wrap */
+
+#define GFX_DEPTH_NEAR				65279.0
+#define GFX_DEPTH_FAR				256.0
+
+#define GFX_COVERED_PER_LINE			4	/* Covered spans allocated per line at first */
+#define GFX_QUEUE_SIZE				256	/* Queued triangles allocated at first */
+
+/* Frustum planes */
+
+enum
+{
+	GFX_PLANE_NEAR,
+	GFX_PLANE_FAR,
+	GFX_PLANE_LEFT,
+	GFX_PLANE_RIGHT,
+	GFX_PLANE_TOP,
+	GFX_PLANE_BOTTOM,
+	GFX_PLANES
+};
+
+/* Solid fill span writer context */
+
+typedef struct
+{
+	GFXsurface   *Surface;
+	unsigned long Color;
+
+} GFXsolid;
+
+/* Hidden surface span writer context, passing visible runs on */
+
+typedef struct
+{
+	GFXview        *View;
+	GFXspanFunction Span;			/* Span function of the material */
+	void           *Context;
+	int             OriginX;		/* Pixel the depth is given at */
+	int             OriginY;
+	float           Depth;			/* Z-buffer value as a plane over the screen */
+	float           DepthX;
+	float           DepthY;
+
+} GFXdepth;
+
+/*******************************************************************************
+ *
+ *	Matrices
+ *
+ ******************************************************************************/
+
+/*
+ * gfxMatrixIdentity
+ *
+ *	GFXmatrix * matrix
+ *		Pointer to the matrix to set to leave vertices unchanged.
+ */
+
+void gfxMatrixIdentity(GFXmatrix *matrix)
+{
+	memset(matrix, 0, sizeof(GFXmatrix));
+	matrix->M[ 0 ][ 0 ] = 1.0f;
+	matrix->M[ 1 ][ 1 ] = 1.0f;
+	matrix->M[ 2 ][ 2 ] = 1.0f;
+}
+
+/*
+ * gfxMatrixMultiply
+ *
+ *	GFXmatrix * result
+ *		Pointer to the product, which may be either of the others.
+ *	GFXmatrix * a, b
+ *		The matrices to multiply. Vertices go through b first, then a.
+ */
+
+void gfxMatrixMultiply(GFXmatrix *result, GFXmatrix *a, GFXmatrix *b)
+{
+	GFXmatrix product;
+	int row, column;
+	for(row = 0; row < 3; row ++)
+	{
+		for(column = 0; column < 4; column ++)
+		{
+			product.M[ row ][ column ] = a->M[ row ][ 0 ] * b->M[ 0 ][ column ] +
+			                             a->M[ row ][ 1 ] * b->M[ 1 ][ column ] +
+			                             a->M[ row ][ 2 ] * b->M[ 2 ][ column ];
+		}
+		product.M[ row ][ 3 ] += a->M[ row ][ 3 ];
+	}
+	*result = product;
+}
+
+/*
+ * gfxMatrixTranslate, gfxMatrixScale, gfxMatrixRotateX/Y/Z
+ *
+ *	Add a step after those already in the matrix. Angles are in radians,
+ *	positive turning Y towards Z, Z towards X and X towards Y.
+ */
+
+void gfxMatrixTranslate(GFXmatrix *matrix, float x, float y, float z)
+{
+	matrix->M[ 0 ][ 3 ] += x;
+	matrix->M[ 1 ][ 3 ] += y;
+	matrix->M[ 2 ][ 3 ] += z;
+}
+
+void gfxMatrixScale(GFXmatrix *matrix, float x, float y, float z)
+{
+	int column;
+	for(column = 0; column < 4; column ++)
+	{
+		matrix->M[ 0 ][ column ] *= x;
+		matrix->M[ 1 ][ column ] *= y;
+		matrix->M[ 2 ][ column ] *= z;
+	}
+}
+
+static void gfxMatrixRotate(GFXmatrix *matrix, int from, int to, float angle)
+{
+	GFXmatrix rotate;
+	float c = (float)cos(angle), s = (float)sin(angle);
+	gfxMatrixIdentity(&rotate);
+	rotate.M[ from ][ from ] = c;
+	rotate.M[ from ][ to   ] = -s;
+	rotate.M[ to   ][ from ] = s;
+	rotate.M[ to   ][ to   ] = c;
+	gfxMatrixMultiply(matrix, &rotate, matrix);
+}
+
+void gfxMatrixRotateX(GFXmatrix *matrix, float angle)
+{
+	gfxMatrixRotate(matrix, 1, 2, angle);
+}
+
+void gfxMatrixRotateY(GFXmatrix *matrix, float angle)
+{
+	gfxMatrixRotate(matrix, 2, 0, angle);
+}
+
+void gfxMatrixRotateZ(GFXmatrix *matrix, float angle)
+{
+	gfxMatrixRotate(matrix, 0, 1, angle);
+}
+
+/*******************************************************************************
+ *
+ *	Clipping and projection
+ *
+ ******************************************************************************/
+
+static void gfxTransform(GFXmatrix *matrix, GFXvertex *in, GFXvertex *out)
+{
+	*out   = *in;
+	out->X = matrix->M[ 0 ][ 0 ] * in->X + matrix->M[ 0 ][ 1 ] * in->Y + matrix->M[ 0 ][ 2 ] * in->Z + matrix->M[ 0 ][ 3 ];
+	out->Y = matrix->M[ 1 ][ 0 ] * in->X + matrix->M[ 1 ][ 1 ] * in->Y + matrix->M[ 1 ][ 2 ] * in->Z + matrix->M[ 1 ][ 3 ];
+	out->Z = matrix->M[ 2 ][ 0 ] * in->X + matrix->M[ 2 ][ 1 ] * in->Y + matrix->M[ 2 ][ 2 ] * in->Z + matrix->M[ 2 ][ 3 ];
+}
+
+/*
+ * gfxPlaneDistance
+ *
+ *	returns
+ *		How far a vertex in view space is inside a frustum plane, negative
+ *		when outside. The sides are those of the whole surface; the span
+ *		writer clips to the clip rectangle.
+ */
+
+static float gfxPlaneDistance(GFXview *view, GFXvertex *vertex, int plane)
+{
+	switch(plane)
+	{
+	case GFX_PLANE_NEAR:
+		return vertex->Z - view->Near;
+	case GFX_PLANE_FAR:
+		return view->Far - vertex->Z;
+	case GFX_PLANE_LEFT:
+		return vertex->X * view->Focal + vertex->Z * view->CenterX;
+	case GFX_PLANE_RIGHT:
+		return vertex->Z * (view->Surface->Width - view->CenterX) - vertex->X * view->Focal;
+	case GFX_PLANE_TOP:
+		return vertex->Z * view->CenterY - vertex->Y * view->Focal;
+	default:
+		return vertex->Y * view->Focal + vertex->Z * (view->Surface->Height - view->CenterY);
+	}
+}
+
+static void gfxLerpVertex(GFXvertex *out, GFXvertex *a, GFXvertex *b, float t)
+{
+	out->X     = a->X + (b->X - a->X) * t;
+	out->Y     = a->Y + (b->Y - a->Y) * t;
+	out->Z     = a->Z + (b->Z - a->Z) * t;
+	out->U     = a->U + (long)((b->U - a->U) * t);
+	out->V     = a->V + (long)((b->V - a->V) * t);
+	out->Red   = a->Red   + (int)((b->Red   - a->Red)   * t);
+	out->Green = a->Green + (int)((b->Green - a->Green) * t);
+	out->Blue  = a->Blue  + (int)((b->Blue  - a->Blue)  * t);
+}
+
+/*
+ * gfxClipPlane
+ *
+ *	Clips a convex polygon to one plane, Sutherland-Hodgman style.
+ *
+ *	returns
+ *		The number of vertices left, at most one more than given.
+ */
+
+static int gfxClipPlane(GFXview *view, int plane, GFXvertex *in, int count, GFXvertex *out)
+{
+	float distance[ GFX_CLIP_VERTICES ];
+	int index, next, length = 0;
+	for(index = 0; index < count; index ++)
+	{
+		distance[ index ] = gfxPlaneDistance(view, &in[ index ], plane);
+	}
+	for(index = 0; index < count; index ++)
+	{
+		next = index + 1 < count ? index + 1 : 0;
+		if(distance[ index ] >= 0)
+		{
+			out[ length ++ ] = in[ index ];
+		}
+		if((distance[ index ] >= 0) != (distance[ next ] >= 0))
+		{
+			gfxLerpVertex(&out[ length ++ ], &in[ index ], &in[ next ],
+			              distance[ index ] / (distance[ index ] - distance[ next ]));
+		}
+	}
+	return length;
+}
+
+static void gfxProject(GFXview *view, GFXvertex *in, GFXprojected *out)
+{
+	float scale = view->Focal / in->Z;
+	out->X     = (long)((view->CenterX + in->X * scale) * 65536.0f);
+	out->Y     = (long)((view->CenterY - in->Y * scale) * 65536.0f);
+	out->Z     = in->Z;
+	out->U     = in->U;
+	out->V     = in->V;
+	out->Red   = in->Red;
+	out->Green = in->Green;
+	out->Blue  = in->Blue;
+}
+
+/*******************************************************************************
+ *
+ *	Hidden surface removal
+ *
+ ******************************************************************************/
+
+static void gfxSolidSpan(void *context, int y, int x1, int x2)
+{
+	GFXsolid *solid = context;
+	gfxFillSpan(solid->Surface, solid->Color, y, x1, x2);
+}
+
+/*
+ * gfxSetupDepth
+ *
+ *	Finds the plane of the z-buffer value over the screen. The value is
+ *	proportional to 1/z, which unlike z is linear in screen space, and is
+ *	greater for nearer pixels.
+ */
+
+static void gfxSetupDepth(GFXdepth *depth, GFXview *view, GFXprojected *v1, GFXprojected *v2, GFXprojected *v3)
+{
+	double scale = (GFX_DEPTH_NEAR - GFX_DEPTH_FAR) * view->Near * view->Far / (view->Far - view->Near);
+	double offset = GFX_DEPTH_FAR - scale / view->Far;
+	double x1 = v1->X / 65536.0, y1 = v1->Y / 65536.0;
+	double dx1 = (v2->X - v1->X) / 65536.0, dy1 = (v2->Y - v1->Y) / 65536.0;
+	double dx2 = (v3->X - v1->X) / 65536.0, dy2 = (v3->Y - v1->Y) / 65536.0;
+	double det = dx1 * dy2 - dx2 * dy1;
+	double a1 = offset + scale / v1->Z, a2 = offset + scale / v2->Z, a3 = offset + scale / v3->Z;
+	double stepX = 0, stepY = 0;
+	if(det != 0.0)
+	{
+		stepX = ((a2 - a1) * dy2 - (a3 - a1) * dy1) / det;
+		stepY = ((a3 - a1) * dx1 - (a2 - a1) * dx2) / det;
+	}
+	depth->OriginX = (int)floor(x1 + 0.5);
+	depth->OriginY = (int)floor(y1 + 0.5);
+	depth->Depth   = (float)(a1 + stepX * (depth->OriginX - x1) + stepY * (depth->OriginY - y1));
+	depth->DepthX  = (float)stepX;
+	depth->DepthY  = (float)stepY;
+}
+
+/*
+ * gfxZBufferSpan
+ *
+ *	Steps the depth across the span in 16.16 fixed point, keeps the pixels
+ *	nearer than those already drawn and passes each run of them on.
+ */
+
+static void gfxZBufferSpan(void *context, int y, int x1, int x2)
+{
+	GFXdepth *depth = context;
+	unsigned short *line = depth->View->ZBuffer + y * depth->View->Surface->Width;
+	float start = depth->Depth + depth->DepthX * (x1 - depth->OriginX) + depth->DepthY * (y - depth->OriginY);
+	unsigned long value, step = (unsigned long)(long)(depth->DepthX * 65536.0f);
+	int x, run = x1;
+	start = start < GFX_DEPTH_FAR ? GFX_DEPTH_FAR : start > GFX_DEPTH_NEAR ? GFX_DEPTH_NEAR : start;
+	value = (unsigned long)(start * 65536.0f);
+	for(x = x1; x < x2; x ++, value += step)
+	{
+		if((unsigned short)(value >> 16) > line[ x ])
+		{
+			line[ x ] = (unsigned short)(value >> 16);
+			continue;
+		}
+		if(x > run)
+		{
+			depth->Span(depth->Context, y, run, x);
+		}
+		run = x + 1;
+	}
+	if(x2 > run)
+	{
+		depth->Span(depth->Context, y, run, x2);
+	}
+}
+
+/*
+ * gfxGrowCovered
+ *
+ *	Makes room for one more covered span. Nodes are referred to by index so
+ *	the pool can move.
+ */
+
+static BOOL gfxGrowCovered(GFXview *view)
+{
+	GFXcovered *covered;
+	if(view->CoveredCount < view->CoveredSize)
+	{
+		return TRUE;
+	}
+	covered = realloc(view->Covered, view->CoveredSize * 2 * sizeof(GFXcovered));
+	if(covered == NULL)
+	{
+		return FALSE;
+	}
+	view->Covered     = covered;
+	view->CoveredSize = view->CoveredSize * 2;
+	return TRUE;
+}
+
+/*
+ * gfxAddCovered
+ *
+ *	Appends a covered span to the run being rebuilt on a line, joining it
+ *	to the last one when both lie on the same plane.
+ *
+ *	int * head
+ *		First span of the run, set by the first span added.
+ *	int * last
+ *		Last span of the run, -1 before the first.
+ *	float depth, depthX
+ *		Depth plane of the span along the line, at x = 0 and per pixel.
+ */
+
+static void gfxAddCovered(GFXview *view, int *head, int *last, int left, int right, float depth, float depthX)
+{
+	GFXcovered *covered;
+	if(left >= right)
+	{
+		return;
+	}
+	if(*last >= 0)
+	{
+		covered = &view->Covered[ *last ];
+		if(covered->Right == left && covered->Depth == depth && covered->DepthX == depthX)
+		{
+			covered->Right = (short)right;
+			return;
+		}
+	}
+	if(!gfxGrowCovered(view))
+	{
+		return;
+	}
+	covered = &view->Covered[ view->CoveredCount ];
+	covered->Left   = (short)left;
+	covered->Right  = (short)right;
+	covered->Depth  = depth;
+	covered->DepthX = depthX;
+	covered->Next   = -1;
+	if(*last >= 0)
+	{
+		view->Covered[ *last ].Next = view->CoveredCount;
+	}
+	else
+	{
+		*head = view->CoveredCount;
+	}
+	*last = view->CoveredCount ++;
+}
+
+/*
+ * gfxDrawVisible
+ *
+ *	Collects the visible runs of a span, passing each on once it can grow
+ *	no further.
+ *
+ *	int * from, * to
+ *		The run waiting to be drawn, empty when equal.
+ */
+
+static void gfxDrawVisible(GFXdepth *depth, int y, int *from, int *to, int left, int right)
+{
+	if(left >= right)
+	{
+		return;
+	}
+	if(left != *to)
+	{
+		if(*to > *from)
+		{
+			depth->Span(depth->Context, y, *from, *to);
+		}
+		*from = left;
+	}
+	*to = right;
+}
+
+/*
+ * gfxSBufferSpan
+ *
+ *	Compares the span with those already covering its line, each of which
+ *	keeps the depth plane of its triangle along the line. Where they
+ *	overlap the two planes cross at most once, so the new span is nearer
+ *	over one end of the overlap, found by solving for the crossing. Those
+ *	parts and the gaps are drawn and take the place of what they cover,
+ *	splitting the covered spans, so the line stays a sorted list of spans
+ *	that never overlap. Greater depth values are nearer.
+ */
+
+static void gfxSBufferSpan(void *context, int y, int x1, int x2)
+{
+	GFXdepth *depth = context;
+	GFXview *view = depth->View;
+	float plane = depth->Depth + depth->DepthY * (y - depth->OriginY) - depth->DepthX * depth->OriginX;
+	float planeX = depth->DepthX;
+	GFXcovered covered;
+	int previous = -1, node, head = -1, last = -1, x = x1;
+	int left, right, nearLeft, nearRight, from = x1, to = x1;
+	double difference, slope, cross;
+	if(x2 <= x1)
+	{
+		return;
+	}
+	/* Skip the spans wholly to the left */
+	node = view->Lines[ y ];
+	while(node >= 0 && view->Covered[ node ].Right <= x1)
+	{
+		previous = node;
+		node     = view->Covered[ node ].Next;
+	}
+	/* Rebuild the run of spans it overlaps */
+	while(node >= 0 && view->Covered[ node ].Left < x2)
+	{
+		/* A copy, since adding spans may move the pool */
+		covered = view->Covered[ node ];
+		node    = covered.Next;
+		gfxAddCovered(view, &head, &last, covered.Left, min(covered.Right, x1), covered.Depth, covered.DepthX);
+		/* The gap before it */
+		if(covered.Left > x)
+		{
+			gfxDrawVisible(depth, y, &from, &to, x, covered.Left);
+			gfxAddCovered(view, &head, &last, x, covered.Left, plane, planeX);
+		}
+		/* The overlap, nearer over [nearLeft, nearRight) */
+		left       = max(covered.Left, x1);
+		right      = min(covered.Right, x2);
+		difference = (double)plane - covered.Depth;
+		slope      = (double)planeX - covered.DepthX;
+		nearLeft   = left;
+		nearRight  = right;
+		if(slope == 0.0)
+		{
+			if(difference <= 0.0)
+			{
+				nearLeft = right;
+			}
+		}
+		else
+		{
+			cross = -difference / slope;
+			if(slope > 0.0)
+			{
+				/* Nearer right of the crossing */
+				nearLeft = cross < left ? left : cross >= right ? right : (int)floor(cross) + 1;
+			}
+			else
+			{
+				/* Nearer left of it */
+				nearRight = cross <= left ? left : cross > right ? right : (int)ceil(cross);
+			}
+		}
+		if(nearLeft >= nearRight)
+		{
+			nearLeft  = right;
+			nearRight = right;
+		}
+		gfxAddCovered(view, &head, &last, left, nearLeft, covered.Depth, covered.DepthX);
+		gfxDrawVisible(depth, y, &from, &to, nearLeft, nearRight);
+		gfxAddCovered(view, &head, &last, nearLeft, nearRight, plane, planeX);
+		gfxAddCovered(view, &head, &last, nearRight, right, covered.Depth, covered.DepthX);
+		gfxAddCovered(view, &head, &last, max(covered.Left, x2), covered.Right, covered.Depth, covered.DepthX);
+		x = right;
+	}
+	/* The gap after the last */
+	if(x < x2)
+	{
+		gfxDrawVisible(depth, y, &from, &to, x, x2);
+		gfxAddCovered(view, &head, &last, x, x2, plane, planeX);
+	}
+	if(to > from)
+	{
+		depth->Span(depth->Context, y, from, to);
+	}
+	/* Put the rebuilt run in place of the old one */
+	if(last < 0)
+	{
+		return;
+	}
+	view->Covered[ last ].Next = node;
+	if(previous < 0)
+	{
+		view->Lines[ y ] = head;
+	}
+	else
+	{
+		view->Covered[ previous ].Next = head;
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Rasterizing
+ *
+ ******************************************************************************/
+
+/*
+ * gfxRasterize
+ *
+ *	Sets up the span function of the material and, in front of it, the one
+ *	removing hidden surfaces, then scan converts the triangle.
+ */
+
+static void gfxRasterize(GFXview *view, GFXmaterial *material, GFXprojected *points)
+{
+	GFXsurface *surface = view->Surface;
+	GFXsolid solid;
+	GFXgradient gradient;
+	GFXmapper mapper;
+	GFXdepth depth;
+	GFXspanWriter writer;
+	GFXshadePoint shade[ 3 ];
+	GFXtexPoint tex[ 3 ];
+	GFXfxpoint p[ 3 ];
+	GFXspanFunction span;
+	void *context;
+	int index;
+	for(index = 0; index < 3; index ++)
+	{
+		p[ index ].X = points[ index ].X;
+		p[ index ].Y = points[ index ].Y;
+	}
+	if(material->Type & GFX_MATERIAL_TEXTURED)
+	{
+		for(index = 0; index < 3; index ++)
+		{
+			tex[ index ].X = points[ index ].X;
+			tex[ index ].Y = points[ index ].Y;
+			tex[ index ].U = points[ index ].U;
+			tex[ index ].V = points[ index ].V;
+			tex[ index ].Z = points[ index ].Z;
+		}
+		if(!gfxSetupMapper(&mapper, surface, material->Texture, &tex[ 0 ], &tex[ 1 ], &tex[ 2 ],
+		                   material->Type & GFX_MATERIAL_PERSPECTIVE ? GFX_TEXTURE_PERSPECTIVE : GFX_TEXTURE_AFFINE))
+		{
+			return;
+		}
+		span    = gfxTextureSpan;
+		context = &mapper;
+	}
+	else if(material->Type & GFX_MATERIAL_GOURAUD)
+	{
+		for(index = 0; index < 3; index ++)
+		{
+			shade[ index ].X     = points[ index ].X;
+			shade[ index ].Y     = points[ index ].Y;
+			shade[ index ].Red   = points[ index ].Red;
+			shade[ index ].Green = points[ index ].Green;
+			shade[ index ].Blue  = points[ index ].Blue;
+		}
+		if(!gfxGouraudGradient(&gradient, surface, &shade[ 0 ], &shade[ 1 ], &shade[ 2 ]))
+		{
+			return;
+		}
+		span    = gfxGradientSpan;
+		context = &gradient;
+	}
+	else
+	{
+		solid.Surface = surface;
+		solid.Color   = material->Color;
+		span          = gfxSolidSpan;
+		context       = &solid;
+	}
+	if(view->Hidden != GFX_HIDDEN_NONE)
+	{
+		depth.View    = view;
+		depth.Span    = span;
+		depth.Context = context;
+		gfxSetupDepth(&depth, view, &points[ 0 ], &points[ 1 ], &points[ 2 ]);
+		span = view->Hidden == GFX_HIDDEN_ZBUFFER ? gfxZBufferSpan : gfxSBufferSpan;
+		context = &depth;
+	}
+	gfxSpanWriter(&writer, surface, span, context);
+	gfxScanTri(&writer, &p[ 0 ], &p[ 1 ], &p[ 2 ], 0, 0);
+}
+
+/*
+ * gfxEmitTri
+ *
+ *	Culls a projected triangle and draws it, or queues it so the span
+ *	buffer can take the scene front to back.
+ */
+
+static void gfxEmitTri(GFXview *view, GFXmaterial *material, GFXprojected *v1, GFXprojected *v2, GFXprojected *v3)
+{
+	GFXqueued *queued;
+	long long cross = (long long)(v2->X - v1->X) * (v3->Y - v1->Y) - (long long)(v3->X - v1->X) * (v2->Y - v1->Y);
+	/* Front faces run clockwise on the screen */
+	if(view->Cull && cross <= 0)
+	{
+		return;
+	}
+	if(view->Hidden == GFX_HIDDEN_SBUFFER)
+	{
+		if(view->QueueCount == view->QueueSize)
+		{
+			queued = realloc(view->Queue, view->QueueSize * 2 * sizeof(GFXqueued));
+			if(queued == NULL)
+			{
+				return;
+			}
+			view->Queue     = queued;
+			view->QueueSize = view->QueueSize * 2;
+		}
+		queued = &view->Queue[ view->QueueCount ++ ];
+		queued->Material    = material;
+		queued->Points[ 0 ] = *v1;
+		queued->Points[ 1 ] = *v2;
+		queued->Points[ 2 ] = *v3;
+		queued->Depth       = min(v1->Z, min(v2->Z, v3->Z));
+		return;
+	}
+	{
+		GFXprojected points[ 3 ];
+		points[ 0 ] = *v1;
+		points[ 1 ] = *v2;
+		points[ 2 ] = *v3;
+		gfxRasterize(view, material, points);
+	}
+}
+
+static int gfxCompareQueued(const void *a, const void *b)
+{
+	float depthA = ((const GFXqueued *)a)->Depth, depthB = ((const GFXqueued *)b)->Depth;
+	return depthA < depthB ? -1 : depthA > depthB;
+}
+
+/*******************************************************************************
+ *
+ *	Pipeline functions
+ *
+ ******************************************************************************/
+
+/*
+ * gfxCreateView
+ *
+ *	Sets up a view of the whole surface, with the view axis through its
+ *	center, the identity matrix and back faces culled.
+ *
+ *	GFXview * view
+ *		Pointer to a view structure to fill in.
+ *	GFXsurface * surface
+ *		Surface to draw on.
+ *	float fieldOfView
+ *		Angle across the width of the surface in radians.
+ *	float nearPlane, farPlane
+ *		Depths to clip at, the near one greater than 0.
+ *	int hidden
+ *		How to remove hidden surfaces.
+ *			GFX_HIDDEN_NONE
+ *			GFX_HIDDEN_ZBUFFER
+ *			GFX_HIDDEN_SBUFFER
+ *	returns
+ *		False if the planes are out of order or memory ran out.
+ */
+
+BOOL gfxCreateView(GFXview *view, GFXsurface *surface, float fieldOfView, float nearPlane, float farPlane, int hidden)
+{
+	memset(view, 0, sizeof(GFXview));
+	if(nearPlane <= 0 || farPlane <= nearPlane || fieldOfView <= 0)
+	{
+		return FALSE;
+	}
+	view->Surface = surface;
+	view->CenterX = surface->Width / 2.0f;
+	view->CenterY = surface->Height / 2.0f;
+	view->Focal   = view->CenterX / (float)tan(fieldOfView / 2);
+	view->Near    = nearPlane;
+	view->Far     = farPlane;
+	view->Hidden  = hidden;
+	view->Cull    = TRUE;
+	gfxMatrixIdentity(&view->Matrix);
+	if(hidden == GFX_HIDDEN_ZBUFFER)
+	{
+		view->ZBuffer = malloc(surface->Width * surface->Height * sizeof(unsigned short));
+		if(view->ZBuffer == NULL)
+		{
+			return FALSE;
+		}
+	}
+	else if(hidden == GFX_HIDDEN_SBUFFER)
+	{
+		view->CoveredSize = surface->Height * GFX_COVERED_PER_LINE;
+		view->QueueSize   = GFX_QUEUE_SIZE;
+		view->Lines       = malloc(surface->Height * sizeof(int));
+		view->Covered     = malloc(view->CoveredSize * sizeof(GFXcovered));
+		view->Queue       = malloc(view->QueueSize * sizeof(GFXqueued));
+		if(view->Lines == NULL || view->Covered == NULL || view->Queue == NULL)
+		{
+			gfxDestroyView(view);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * gfxDestroyView
+ *
+ *	Frees the buffers of a view.
+ */
+
+void gfxDestroyView(GFXview *view)
+{
+	free(view->ZBuffer);
+	free(view->Lines);
+	free(view->Covered);
+	free(view->Queue);
+	view->ZBuffer = NULL;
+	view->Lines   = NULL;
+	view->Covered = NULL;
+	view->Queue   = NULL;
+}
+
+/*
+ * gfxBeginScene
+ *
+ *	Clears the z-buffer or the covered spans. The surface itself is not
+ *	cleared.
+ */
+
+void gfxBeginScene(GFXview *view)
+{
+	int y;
+	if(view->ZBuffer)
+	{
+		memset(view->ZBuffer, 0, view->Surface->Width * view->Surface->Height * sizeof(unsigned short));
+	}
+	if(view->Lines)
+	{
+		for(y = 0; y < view->Surface->Height; y ++)
+		{
+			view->Lines[ y ] = -1;
+		}
+	}
+	view->CoveredCount = 0;
+	view->QueueCount   = 0;
+}
+
+/*
+ * gfxDrawTriangle3d
+ *
+ *	Transforms, clips, culls and projects a triangle, then draws it. With
+ *	the span buffer it is only queued until the end of the scene, so the
+ *	material must stay valid until then.
+ *
+ *	GFXview * view
+ *		Pointer to the view.
+ *	GFXmaterial * material
+ *		How to fill the triangle. Textures must have the pixel size of the
+ *		surface.
+ *	GFXvertex * v1, v2, v3
+ *		The vertices in model space.
+ */
+
+void gfxDrawTriangle3d(GFXview *view, GFXmaterial *material, GFXvertex *v1, GFXvertex *v2, GFXvertex *v3)
+{
+	GFXvertex polygon[ 2 ][ GFX_CLIP_VERTICES ];
+	GFXprojected points[ GFX_CLIP_VERTICES ];
+	int count = 3, current = 0, plane, index;
+	gfxTransform(&view->Matrix, v1, &polygon[ 0 ][ 0 ]);
+	gfxTransform(&view->Matrix, v2, &polygon[ 0 ][ 1 ]);
+	gfxTransform(&view->Matrix, v3, &polygon[ 0 ][ 2 ]);
+	for(plane = 0; plane < GFX_PLANES; plane ++)
+	{
+		count   = gfxClipPlane(view, plane, polygon[ current ], count, polygon[ current ^ 1 ]);
+		current = current ^ 1;
+		if(count < 3)
+		{
+			return;
+		}
+	}
+	for(index = 0; index < count; index ++)
+	{
+		gfxProject(view, &polygon[ current ][ index ], &points[ index ]);
+	}
+	for(index = 1; index < count - 1; index ++)
+	{
+		gfxEmitTri(view, material, &points[ 0 ], &points[ index ], &points[ index + 1 ]);
+	}
+}
+
+/*
+ * gfxEndScene
+ *
+ *	Draws the triangles queued for the span buffer, roughly nearest first
+ *	by their nearest vertex. The order only saves drawing: a triangle
+ *	hidden behind those before it is cut away by the span buffer, and one
+ *	in front of them is drawn over them.
+ */
+
+void gfxEndScene(GFXview *view)
+{
+	int index;
+	if(view->Hidden != GFX_HIDDEN_SBUFFER)
+	{
+		return;
+	}
+	qsort(view->Queue, view->QueueCount, sizeof(GFXqueued), gfxCompareQueued);
+	for(index = 0; index < view->QueueCount; index ++)
+	{
+		gfxRasterize(view, view->Queue[ index ].Material, view->Queue[ index ].Points);
+	}
+	view->QueueCount = 0;
+}
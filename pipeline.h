@@ -0,0 +1,175 @@
+/*******************************************************************************
+ *
+ *	Pipeline library
+ *
+ *	Draws small 3D scenes with the polygon, shade and texture libraries.
+ *	Vertices are transformed by a floating point matrix, clipped to the
+ *	view frustum, culled when facing away and projected onto the surface.
+ *
+ *	Hidden surfaces are removed with either a 16 bit z-buffer or a span
+ *	buffer. The z-buffer tests every pixel and draws triangles as they come.
+ *	The span buffer keeps, for each line, the spans already covered with
+ *	the depth plane of each, and compares a new span with them once per
+ *	overlap rather than once per pixel, splitting where the planes cross.
+ *	The scene is sorted front to back when it ends, so most of what is
+ *	hidden is never drawn and there is no depth memory to read.
+ */
+
+#ifndef pipeline_h
+#define pipeline_h
+
+#include "VGA.h"
+#include "surface.h"
+#include "texture.h"
+
+/*******************************************************************************
+ *
+ *	Pipeline flags
+ *
+ ******************************************************************************/
+
+/* Hidden surface removal */
+
+#define GFX_HIDDEN_NONE				0x00	/* Draw in the order given */
+#define GFX_HIDDEN_ZBUFFER			0x01	/* 16 bit depth per pixel */
+#define GFX_HIDDEN_SBUFFER			0x02	/* Covered spans and their depth per line */
+
+/* GFXmaterial */
+
+#define GFX_MATERIAL_FLAT			0x00	/* One pixel value */
+#define GFX_MATERIAL_GOURAUD			0x01	/* Vertex colors blended */
+#define GFX_MATERIAL_TEXTURED			0x02	/* Texture, affine unless perspective is set */
+#define GFX_MATERIAL_PERSPECTIVE		0x04	/* With textured, correct for depth */
+
+#define GFX_CLIP_VERTICES			9	/* A triangle clipped by six planes */
+
+/*******************************************************************************
+ *
+ *	Pipeline structures
+ *
+ ******************************************************************************/
+
+/* Rotation and translation, applied as M * [x y z 1] */
+
+typedef struct
+{
+	float M[3][4];
+
+} GFXmatrix;
+
+typedef struct
+{
+	float X;
+	float Y;
+	float Z;
+	long  U;				/* 16.16 fixed point texel position */
+	long  V;
+	int   Red;				/* Color components in the range 0-255 */
+	int   Green;
+	int   Blue;
+
+} GFXvertex;
+
+typedef struct
+{
+	int           Type;			/* GFX_MATERIAL_x */
+	unsigned long Color;		/* Pixel value for flat materials */
+	GFXtexture   *Texture;		/* Texture for textured materials */
+
+} GFXmaterial;
+
+/* A projected vertex */
+
+typedef struct
+{
+	long  X;				/* 16.16 fixed point screen position */
+	long  Y;
+	float Z;
+	long  U;
+	long  V;
+	int   Red;
+	int   Green;
+	int   Blue;
+
+} GFXprojected;
+
+typedef struct
+{
+	GFXmaterial  *Material;
+	GFXprojected  Points[3];
+	float         Depth;		/* Nearest vertex, for sorting */
+
+} GFXqueued;
+
+typedef struct
+{
+	short Left;
+	short Right;			/* Exclusive */
+	int   Next;			/* Index of the next span on the line, -1 at the end */
+	float Depth;			/* Depth plane along the line, at x = 0 */
+	float DepthX;			/* Change per pixel */
+
+} GFXcovered;
+
+typedef struct
+{
+	GFXsurface     *Surface;
+	GFXmatrix       Matrix;		/* Model to view, the eye looks down +Z */
+	float           Focal;		/* Pixels per unit at a depth of one */
+	float           Near;
+	float           Far;
+	float           CenterX;	/* Screen position of the view axis */
+	float           CenterY;
+	int             Hidden;		/* GFX_HIDDEN_x */
+	BOOL            Cull;		/* Drop triangles running counterclockwise on the screen */
+	/* Z-buffer */
+	unsigned short *ZBuffer;
+	/* Span buffer */
+	int            *Lines;		/* First covered span of each line */
+	GFXcovered     *Covered;
+	int             CoveredCount;
+	int             CoveredSize;
+	GFXqueued      *Queue;
+	int             QueueCount;
+	int             QueueSize;
+
+} GFXview;
+
+/*******************************************************************************
+ *
+ *	Pipeline functions
+ *
+ ******************************************************************************/
+
+/* Matrices */
+
+void gfxMatrixIdentity(GFXmatrix *matrix);
+
+void gfxMatrixMultiply(GFXmatrix *result, GFXmatrix *a, GFXmatrix *b);
+
+void gfxMatrixTranslate(GFXmatrix *matrix, float x, float y, float z);
+
+void gfxMatrixScale(GFXmatrix *matrix, float x, float y, float z);
+
+void gfxMatrixRotateX(GFXmatrix *matrix, float angle);
+
+void gfxMatrixRotateY(GFXmatrix *matrix, float angle);
+
+void gfxMatrixRotateZ(GFXmatrix *matrix, float angle);
+
+/* Views */
+
+BOOL gfxCreateView(GFXview *view, GFXsurface *surface, float fieldOfView, float nearPlane, float farPlane, int hidden);
+
+void gfxDestroyView(GFXview *view);
+
+/* Scenes */
+
+void gfxBeginScene(GFXview *view);
+
+void gfxDrawTriangle3d(GFXview *view, GFXmaterial *material, GFXvertex *v1, GFXvertex *v2, GFXvertex *v3);
+
+void gfxEndScene(GFXview *view);
+
+
+#endif /* pipeline_h */
@@ -0,0 +1,383 @@
+/*******************************************************************************
+ *
+ *	Polygon library
+ *
+ *	Scan converts the trapezoids, triangles and quads of the accelerator
+ *	interface. Vertices are 16.16 fixed point. Edges are walked one line at
+ *	a time with no divides past the setup of each edge, and spans are
+ *	handed to a span writer so other fills can share the edge walking.
+ *
+ *	A pixel is covered when the point at its integer coordinates is inside
+ *	the shape or on a top or left edge, so shapes sharing an edge never
+ *	draw a pixel twice or leave a gap between them.
+ *
+ *	Based on the official specification
+ *	http://www.vesa.org/public/VBE/vbeaf.pdf
+ */
+
+#include "intern.h"
+#include "raster.h"
+#include "polygon.h"
+
+/* Smallest integer not less than a 16.16 fixed point value */
+
+#define GFX_CEIL(x)				((int)(((x) + 0xFFFF) >> 16))
+
+/* Steepest edge slope kept, 16.16 fixed point pixels per line */
+
+#define GFX_SLOPE_MAX				0x3FFFFFFFLL
+
+typedef struct
+{
+	long X;					/* 16.16 fixed point, on line Y */
+	long Slope;				/* 16.16 fixed point change per line */
+	int  Y;					/* First line the edge covers */
+
+} GFXedge;
+
+/* Solid fill span writer context */
+
+typedef struct
+{
+	GFXsurface   *Surface;
+	unsigned long Color;
+
+} GFXsolid;
+
+/*******************************************************************************
+ *
+ *	Edge walking
+ *
+ ******************************************************************************/
+
+/*
+ * gfxSetupEdge
+ *
+ *	Finds the first line at or below the upper end of an edge and where the
+ *	edge crosses it.
+ *
+ *	GFXfxpoint * a
+ *		Upper end.
+ *	GFXfxpoint * b
+ *		Lower end.
+ */
+
+static void gfxSetupEdge(GFXedge *edge, GFXfxpoint *a, GFXfxpoint *b)
+{
+	long long dx = (long long)b->X - a->X;
+	long long dy = (long long)b->Y - a->Y;
+	long long slope;
+	edge->Y = GFX_CEIL(a->Y);
+	if(dy <= 0 || edge->Y >= GFX_CEIL(b->Y))
+	{
+		/* Covers no line */
+		edge->Slope = 0;
+		edge->X     = a->X;
+		return;
+	}
+	/* Only an edge spanning a line or so gets this steep, and a step
+	   then leaves any surface, so clamping changes no covered pixel */
+	slope = (dx << 16) / dy;
+	if(slope > GFX_SLOPE_MAX)
+	{
+		slope = GFX_SLOPE_MAX;
+	}
+	else if(slope < -GFX_SLOPE_MAX)
+	{
+		slope = -GFX_SLOPE_MAX;
+	}
+	edge->Slope = (long)slope;
+	edge->X     = a->X + (long)(dx * (((long long)edge->Y << 16) - a->Y) / dy);
+}
+
+/*
+ * gfxStepEdges
+ *
+ *	Moves both edges down a number of lines.
+ */
+
+static void gfxStepEdges(GFXedge *left, GFXedge *right, int lines)
+{
+	left->X  += left->Slope  * lines;
+	right->X += right->Slope * lines;
+}
+
+/*
+ * gfxScanEdges
+ *
+ *	Emits the spans between two edges for a run of lines. Lines above the
+ *	clip rectangle are stepped over in one go.
+ *
+ *	GFXspanWriter * writer
+ *		Where the spans go.
+ *	GFXedge * left, right
+ *		The edges, both positioned on line y.
+ *	int y
+ *		First line.
+ *	int end
+ *		Line after the last.
+ */
+
+static void gfxScanEdges(GFXspanWriter *writer, GFXedge *left, GFXedge *right, int y, int end)
+{
+	int x1, x2;
+	if(y < writer->ClipTop)
+	{
+		int skip = min(writer->ClipTop, end) - y;
+		if(skip > 0)
+		{
+			gfxStepEdges(left, right, skip);
+			y += skip;
+		}
+	}
+	for(; y < end; y ++)
+	{
+		if(y >= writer->ClipBottom)
+		{
+			/* Keep the edges where the caller expects them */
+			gfxStepEdges(left, right, end - y);
+			return;
+		}
+		x1 = max(GFX_CEIL(left->X),  writer->ClipLeft);
+		x2 = min(GFX_CEIL(right->X), writer->ClipRight);
+		if(x1 < x2)
+		{
+			writer->Span(writer->Context, y, x1, x2);
+		}
+		left->X  += left->Slope;
+		right->X += right->Slope;
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Scan conversion
+ *
+ ******************************************************************************/
+
+/*
+ * gfxSpanWriter
+ *
+ *	Sets up a span writer clipped to the clip rectangle of a surface.
+ *
+ *	GFXspanWriter * writer
+ *		Pointer to a span writer structure to initialize.
+ *	GFXsurface * surface
+ *		Surface whose clip rectangle is used.
+ *	GFXspanFunction span
+ *		Called with each span.
+ *	void * context
+ *		Passed to the span function.
+ */
+
+void gfxSpanWriter(GFXspanWriter *writer, GFXsurface *surface, GFXspanFunction span, void *context)
+{
+	writer->Span       = span;
+	writer->Context    = context;
+	writer->ClipLeft   = surface->ClipLeft;
+	writer->ClipTop    = surface->ClipTop;
+	writer->ClipRight  = surface->ClipRight;
+	writer->ClipBottom = surface->ClipBottom;
+}
+
+/*
+ * gfxScanTrap
+ *
+ *	As the accelerator function, the trapezoid is left describing the line
+ *	after the last one drawn, so the next trapezoid of a shape can follow.
+ *	The ends may cross.
+ *
+ *	GFXspanWriter * writer
+ *		Where the spans go.
+ *	GFXtrap * trap
+ *		Pointer to the trapezoid.
+ */
+
+void gfxScanTrap(GFXspanWriter *writer, GFXtrap *trap)
+{
+	int y   = trap->Y;
+	int end = trap->Y + trap->Count;
+	int x1, x2, swap;
+	for(; y < end; y ++)
+	{
+		if(y >= writer->ClipTop && y < writer->ClipBottom)
+		{
+			x1 = GFX_CEIL(trap->X1);
+			x2 = GFX_CEIL(trap->X2);
+			if(x2 < x1)
+			{
+				swap = x1;
+				x1   = x2;
+				x2   = swap;
+			}
+			x1 = max(x1, writer->ClipLeft);
+			x2 = min(x2, writer->ClipRight);
+			if(x1 < x2)
+			{
+				writer->Span(writer->Context, y, x1, x2);
+			}
+		}
+		trap->X1 += trap->Slope1;
+		trap->X2 += trap->Slope2;
+	}
+	trap->Y = end;
+}
+
+/*
+ * gfxScanTri
+ *
+ *	The vertices are sorted from top to bottom. The edge from the top vertex
+ *	to the bottom one spans the whole height, with the other two edges on
+ *	the opposite side, one above the middle vertex and one below it.
+ *
+ *	GFXspanWriter * writer
+ *		Where the spans go.
+ *	GFXfxpoint * v1, v2, v3
+ *		The vertices, in any order.
+ *	long xOffset, yOffset
+ *		16.16 fixed point amounts added to every vertex.
+ */
+
+void gfxScanTri(GFXspanWriter *writer, GFXfxpoint *v1, GFXfxpoint *v2, GFXfxpoint *v3, long xOffset, long yOffset)
+{
+	GFXfxpoint point[3], swap;
+	GFXedge whole, part;
+	long long cross;
+	int middle;
+	point[ 0 ].X = v1->X + xOffset; point[ 0 ].Y = v1->Y + yOffset;
+	point[ 1 ].X = v2->X + xOffset; point[ 1 ].Y = v2->Y + yOffset;
+	point[ 2 ].X = v3->X + xOffset; point[ 2 ].Y = v3->Y + yOffset;
+	#define SORT(a, b) \
+		if(point[ b ].Y < point[ a ].Y) { swap = point[ a ]; point[ a ] = point[ b ]; point[ b ] = swap; }
+	SORT(0, 1);
+	SORT(1, 2);
+	SORT(0, 1);
+	#undef SORT
+	/* Positive when the middle vertex is right of the long edge */
+	cross = (long long)(point[ 1 ].X - point[ 0 ].X) * (point[ 2 ].Y - point[ 0 ].Y) -
+	        (long long)(point[ 1 ].Y - point[ 0 ].Y) * (point[ 2 ].X - point[ 0 ].X);
+	if(!cross)
+	{
+		return;
+	}
+	middle = GFX_CEIL(point[ 1 ].Y);
+	gfxSetupEdge(&whole, &point[ 0 ], &point[ 2 ]);
+	gfxSetupEdge(&part,  &point[ 0 ], &point[ 1 ]);
+	if(cross > 0)
+	{
+		gfxScanEdges(writer, &whole, &part, whole.Y, middle);
+	}
+	else
+	{
+		gfxScanEdges(writer, &part, &whole, whole.Y, middle);
+	}
+	gfxSetupEdge(&part, &point[ 1 ], &point[ 2 ]);
+	if(cross > 0)
+	{
+		gfxScanEdges(writer, &whole, &part, middle, GFX_CEIL(point[ 2 ].Y));
+	}
+	else
+	{
+		gfxScanEdges(writer, &part, &whole, middle, GFX_CEIL(point[ 2 ].Y));
+	}
+}
+
+/*
+ * gfxScanQuad
+ *
+ *	Draws a convex quad as two triangles sharing the diagonal from the
+ *	first vertex to the third. The fill rule keeps the diagonal from being
+ *	drawn twice.
+ *
+ *	GFXspanWriter * writer
+ *		Where the spans go.
+ *	GFXfxpoint * v1, v2, v3, v4
+ *		The vertices, in order around the quad.
+ *	long xOffset, yOffset
+ *		16.16 fixed point amounts added to every vertex.
+ */
+
+void gfxScanQuad(GFXspanWriter *writer, GFXfxpoint *v1, GFXfxpoint *v2, GFXfxpoint *v3, GFXfxpoint *v4, long xOffset, long yOffset)
+{
+	gfxScanTri(writer, v1, v2, v3, xOffset, yOffset);
+	gfxScanTri(writer, v1, v3, v4, xOffset, yOffset);
+}
+
+/*******************************************************************************
+ *
+ *	Solid fills
+ *
+ ******************************************************************************/
+
+static void gfxSolidSpan(void *context, int y, int x1, int x2)
+{
+	GFXsolid *solid = context;
+	gfxFillSpan(solid->Surface, solid->Color, y, x1, x2);
+}
+
+/*
+ * gfxDrawTrap
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	unsigned long color
+ *		Pixel value.
+ *	GFXtrap * trap
+ *		Pointer to the trapezoid, updated as by 'gfxScanTrap'.
+ */
+
+void gfxDrawTrap(GFXsurface *surface, unsigned long color, GFXtrap *trap)
+{
+	GFXsolid solid;
+	GFXspanWriter writer;
+	solid.Surface = surface;
+	solid.Color   = color;
+	gfxSpanWriter(&writer, surface, gfxSolidSpan, &solid);
+	gfxScanTrap(&writer, trap);
+}
+
+/*
+ * gfxDrawTri
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	unsigned long color
+ *		Pixel value.
+ *	GFXfxpoint * v1, v2, v3
+ *		The vertices.
+ *	long xOffset, yOffset
+ *		16.16 fixed point amounts added to every vertex.
+ */
+
+void gfxDrawTri(GFXsurface *surface, unsigned long color, GFXfxpoint *v1, GFXfxpoint *v2, GFXfxpoint *v3, long xOffset, long yOffset)
+{
+	GFXsolid solid;
+	GFXspanWriter writer;
+	solid.Surface = surface;
+	solid.Color   = color;
+	gfxSpanWriter(&writer, surface, gfxSolidSpan, &solid);
+	gfxScanTri(&writer, v1, v2, v3, xOffset, yOffset);
+}
+
+/*
+ * gfxDrawQuad
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	unsigned long color
+ *		Pixel value.
+ *	GFXfxpoint * v1, v2, v3, v4
+ *		The vertices, in order around the quad.
+ *	long xOffset, yOffset
+ *		16.16 fixed point amounts added to every vertex.
+ */
+
+void gfxDrawQuad(GFXsurface *surface, unsigned long color, GFXfxpoint *v1, GFXfxpoint *v2, GFXfxpoint *v3, GFXfxpoint *v4, long xOffset, long yOffset)
+{
+	GFXsolid solid;
+	GFXspanWriter writer;
+	solid.Surface = surface;
+	solid.Color   = color;
+	gfxSpanWriter(&writer, surface, gfxSolidSpan, &solid);
+	gfxScanQuad(&writer, v1, v2, v3, v4, xOffset, yOffset);
+}
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ *
+ *	Polygon library
+ *
+ *	Scan converts the trapezoids, triangles and quads of the accelerator
+ *	interface. Vertices are 16.16 fixed point. Edges are walked one line at
+ *	a time with no divides past the setup of each edge, and spans are
+ *	handed to a span writer so other fills can share the edge walking.
+ *
+ *	A pixel is covered when the point at its integer coordinates is inside
+ *	the shape or on a top or left edge, so shapes sharing an edge never
+ *	draw a pixel twice or leave a gap between them.
+ *
+ *	Based on the official specification
+ *	http://www.vesa.org/public/VBE/vbeaf.pdf
+ */
+
+#ifndef polygon_h
+#define polygon_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Polygon structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	long X;					/* 16.16 fixed point */
+	long Y;					/* 16.16 fixed point */
+
+} GFXfxpoint;
+
+typedef struct
+{
+	int  Y;					/* First line */
+	int  Count;				/* Lines to draw */
+	long X1;				/* 16.16 fixed point ends on the first line */
+	long X2;
+	long Slope1;				/* 16.16 fixed point change per line */
+	long Slope2;
+
+} GFXtrap;
+
+typedef void (*GFXspanFunction)(void *context, int y, int x1, int x2);
+
+typedef struct
+{
+	GFXspanFunction Span;			/* Called for every span, x2 exclusive */
+	void           *Context;		/* Passed to the span function */
+	/* Spans are clipped to this before the span function sees them */
+	int             ClipLeft;
+	int             ClipTop;
+	int             ClipRight;
+	int             ClipBottom;
+
+} GFXspanWriter;
+
+/*******************************************************************************
+ *
+ *	Polygon functions
+ *
+ ******************************************************************************/
+
+/* Scan conversion */
+
+void gfxSpanWriter(GFXspanWriter *writer, GFXsurface *surface, GFXspanFunction span, void *context);
+
+void gfxScanTrap(GFXspanWriter *writer, GFXtrap *trap);
+
+void gfxScanTri(GFXspanWriter *writer, GFXfxpoint *v1, GFXfxpoint *v2, GFXfxpoint *v3, long xOffset, long yOffset);
+
+void gfxScanQuad(GFXspanWriter *writer, GFXfxpoint *v1, GFXfxpoint *v2, GFXfxpoint *v3, GFXfxpoint *v4, long xOffset, long yOffset);
+
+/* Solid fills */
+
+void gfxDrawTrap(GFXsurface *surface, unsigned long color, GFXtrap *trap);
+
+void gfxDrawTri(GFXsurface *surface, unsigned long color, GFXfxpoint *v1, GFXfxpoint *v2, GFXfxpoint *v3, long xOffset, long yOffset);
+
+void gfxDrawQuad(GFXsurface *surface, unsigned long color, GFXfxpoint *v1, GFXfxpoint *v2, GFXfxpoint *v3, GFXfxpoint *v4, long xOffset, long yOffset);
+
+
+#endif /* polygon_h */
@@ -0,0 +1,329 @@
+/*******************************************************************************
+ *
+ *	Present library
+ *
+ *	Copies the dirty rectangles of a back buffer in system memory to the
+ *	frame buffer without tearing and without a second page in video memory.
+ *	Each band of rows is written either while the beam is still above it,
+ *	so it is complete before it is scanned, or once the beam has gone past
+ *	it, so it is complete before the next frame scans it. Bands that fit
+ *	neither way within the measured bandwidth wait for the next frame.
+ *
+ *	The beam is located from the time since the start of retrace, using the
+ *	display timing measured from the retrace and display disabled bits.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "farseg.h"
+#include "intern.h"
+#include "VGAio.h"
+#include "present.h"
+
+/*******************************************************************************
+ *
+ *	Bands
+ *
+ ******************************************************************************/
+
+/*
+ * gfxAddBands
+ *
+ *	Clips a rectangle to the frame buffer and splits it into bands of at
+ *	most GFX_PRESENT_BAND rows.
+ *
+ *	returns
+ *		The new number of bands, or -1 if the list could not grow.
+ */
+
+static int gfxAddBands(GFXpresenter *presenter, int count, GFXrect *rect)
+{
+	GFXrect clip;
+	int top;
+	clip.Left   = max(rect->Left, 0);
+	clip.Top    = max(rect->Top, 0);
+	clip.Right  = min(rect->Right,  presenter->Target->Width);
+	clip.Bottom = min(rect->Bottom, presenter->Target->Height);
+	if(clip.Left >= clip.Right)
+	{
+		return count;
+	}
+	for(top = clip.Top; top < clip.Bottom; top += GFX_PRESENT_BAND)
+	{
+		if(count == presenter->BandsSize)
+		{
+			int size = presenter->BandsSize ? presenter->BandsSize * 2 : GFX_PRESENT_PENDING;
+			GFXrect *bands = realloc(presenter->Bands, size * sizeof(GFXrect));
+			if(!bands)
+			{
+				return -1;
+			}
+			presenter->Bands     = bands;
+			presenter->BandsSize = size;
+		}
+		presenter->Bands[ count ].Left   = clip.Left;
+		presenter->Bands[ count ].Right  = clip.Right;
+		presenter->Bands[ count ].Top    = top;
+		presenter->Bands[ count ].Bottom = min(top + GFX_PRESENT_BAND, clip.Bottom);
+		count ++;
+	}
+	return count;
+}
+
+static int gfxCompareTop(const void *a, const void *b)
+{
+	return ((const GFXrect *)a)->Top - ((const GFXrect *)b)->Top;
+}
+
+static int gfxCompareBottom(const void *a, const void *b)
+{
+	return ((const GFXrect *)a)->Bottom - ((const GFXrect *)b)->Bottom;
+}
+
+/*
+ * gfxBandCost
+ *
+ *	returns
+ *		Time stamp counter ticks needed to write the band.
+ */
+
+static unsigned long long gfxBandCost(GFXpresenter *presenter, GFXrect *band)
+{
+	unsigned long long bytes = (unsigned long long)(band->Right - band->Left) * (band->Bottom - band->Top) * presenter->Source->BytesPerPixel;
+	return bytes * presenter->Timing->Frequency / ((unsigned long long)presenter->Bandwidth * 1000000);
+}
+
+/*
+ * gfxCopyBand
+ */
+
+static void gfxCopyBand(GFXpresenter *presenter, GFXrect *band)
+{
+	GFXsurface *source = presenter->Source;
+	GFXsurface *target = presenter->Target;
+	int length = (band->Right - band->Left) * source->BytesPerPixel;
+	unsigned char *from = source->Bits + band->Top * source->BytesPerLine + band->Left * source->BytesPerPixel;
+	unsigned char *to   = target->Bits + band->Top * target->BytesPerLine + band->Left * target->BytesPerPixel;
+	int row;
+	for(row = band->Top; row < band->Bottom; row ++)
+	{
+		if(presenter->Correction)
+		{
+			gfxCorrectRow(presenter->Correction, to, from, band->Right - band->Left);
+		}
+		else
+		{
+			memcpy(to, from, length);
+		}
+		from += source->BytesPerLine;
+		to   += target->BytesPerLine;
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Present functions
+ *
+ ******************************************************************************/
+
+/*
+ * gfxCreatePresenter
+ *
+ *	GFXpresenter * presenter
+ *		Pointer to a presenter structure to initialize.
+ *	GFXsurface * source
+ *		The back buffer.
+ *	GFXsurface * target
+ *		The frame buffer, same size and pixel format as the back buffer.
+ *	VGAtiming * timing
+ *		Display timing as measured by 'vgaTimeCalibrate'.
+ *	long bandwidth
+ *		Bytes per microsecond the frame buffer takes, 0 to measure it with
+ *		'gfxMeasureBandwidth'.
+ *	returns
+ *		True if the presenter is ready.
+ */
+
+BOOL gfxCreatePresenter(GFXpresenter *presenter, GFXsurface *source, GFXsurface *target, VGAtiming *timing, long bandwidth)
+{
+	memset(presenter, 0, sizeof(GFXpresenter));
+	if(source->Width != target->Width || source->Height != target->Height ||
+	   source->BytesPerPixel != target->BytesPerPixel || !timing->Period)
+	{
+		return FALSE;
+	}
+	presenter->Source    = source;
+	presenter->Target    = target;
+	presenter->Timing    = timing;
+	presenter->Bandwidth = bandwidth;
+	presenter->Port      = vgaIsColorMode() ? VGA_COLOR_INPUT_STATUS_1 : VGA_MONO_INPUT_STATUS_1;
+	if(!gfxCreateDirty(&presenter->Pending, GFX_PRESENT_PENDING))
+	{
+		return FALSE;
+	}
+	if(!bandwidth)
+	{
+		gfxMeasureBandwidth(presenter);
+	}
+	return presenter->Bandwidth > 0;
+}
+
+/*
+ * gfxDestroyPresenter
+ */
+
+void gfxDestroyPresenter(GFXpresenter *presenter)
+{
+	gfxDestroyDirty(&presenter->Pending);
+	free(presenter->Bands);
+	presenter->Bands     = NULL;
+	presenter->BandsSize = 0;
+}
+
+/*
+ * gfxMeasureBandwidth
+ *
+ *	Times a copy of the whole back buffer to the frame buffer, which also
+ *	brings the display up to date.
+ *
+ *	GFXpresenter * presenter
+ *		Pointer to a presenter structure.
+ *	returns
+ *		Bytes per microsecond, also kept by the presenter.
+ */
+
+long gfxMeasureBandwidth(GFXpresenter *presenter)
+{
+	GFXrect whole;
+	unsigned long long start, end;
+	long microseconds;
+	whole.Left   = 0;
+	whole.Top    = 0;
+	whole.Right  = presenter->Target->Width;
+	whole.Bottom = presenter->Target->Height;
+	rdtsc(start);
+	gfxCopyBand(presenter, &whole);
+	rdtsc(end);
+	microseconds = vgaTimeMicroseconds(presenter->Timing, end - start);
+	presenter->Bandwidth = (long)whole.Right * whole.Bottom * presenter->Target->BytesPerPixel / max(microseconds, 1);
+	if(presenter->Bandwidth < 1)
+	{
+		presenter->Bandwidth = 1;
+	}
+	return presenter->Bandwidth;
+}
+
+/*
+ * gfxPresent
+ *
+ *	Waits for the start of retrace, then writes what it can of the dirty
+ *	rectangles and of the work left over from earlier frames. While the beam
+ *	is in the blank or above a band the band may be written if it will be
+ *	finished before the beam reaches it. The rest are written in the order
+ *	the beam leaves them, as long as they will be finished before the beam
+ *	comes back around.
+ *
+ *	GFXpresenter * presenter
+ *		Pointer to a presenter structure.
+ *	GFXdirty * dirty
+ *		Rectangles changed in the back buffer since the last call. The list
+ *		may be cleared once this returns.
+ *	returns
+ *		Number of rectangles carried over to the next frame.
+ */
+
+int gfxPresent(GFXpresenter *presenter, GFXdirty *dirty)
+{
+	VGAtiming *timing = presenter->Timing;
+	unsigned long long start, now, line, cost, passed, due;
+	int count = 0, index;
+	GFXrect *band;
+	for(index = 0; index < presenter->Pending.Count && count >= 0; index ++)
+	{
+		count = gfxAddBands(presenter, count, &presenter->Pending.Rects[ index ]);
+	}
+	for(index = 0; index < dirty->Count && count >= 0; index ++)
+	{
+		count = gfxAddBands(presenter, count, &dirty->Rects[ index ]);
+	}
+	if(count < 0)
+	{
+		/* Out of memory, leave the work where it is */
+		for(index = 0; index < dirty->Count; index ++)
+		{
+			gfxAddDirtyRect(&presenter->Pending, &dirty->Rects[ index ]);
+		}
+		return presenter->Pending.Count;
+	}
+	gfxClearDirty(&presenter->Pending);
+	if(count == 0)
+	{
+		return 0;
+	}
+	line = timing->Active / presenter->Target->Height;
+	qsort(presenter->Bands, count, sizeof(GFXrect), gfxCompareTop);
+	/* Start of retrace */
+	while(inportb(presenter->Port) & VGA_VERTICAL_RETRACE_BIT);
+	while(!(inportb(presenter->Port) & VGA_VERTICAL_RETRACE_BIT));
+	rdtsc(start);
+	/* Ahead of the beam */
+	for(index = 0; index < count; index ++)
+	{
+		band = &presenter->Bands[ index ];
+		cost = gfxBandCost(presenter, band);
+		rdtsc(now);
+		if(now + cost <= start + timing->Display + band->Top * line)
+		{
+			gfxCopyBand(presenter, band);
+			/* Leave it empty so the second pass skips it */
+			band->Bottom = band->Top;
+		}
+	}
+	/* Behind the beam */
+	qsort(presenter->Bands, count, sizeof(GFXrect), gfxCompareBottom);
+	for(index = 0; index < count; index ++)
+	{
+		band = &presenter->Bands[ index ];
+		if(band->Bottom == band->Top)
+		{
+			continue;
+		}
+		cost   = gfxBandCost(presenter, band);
+		passed = start + timing->Display + band->Bottom * line;
+		due    = start + timing->Period + timing->Display + band->Top * line;
+		rdtsc(now);
+		if(max(now, passed) + cost > due)
+		{
+			gfxAddDirtyRect(&presenter->Pending, band);
+			continue;
+		}
+		while(now < passed)
+		{
+			rdtsc(now);
+		}
+		gfxCopyBand(presenter, band);
+	}
+	return presenter->Pending.Count;
+}
+
+/*
+ * gfxSetPresentCorrection
+ *
+ *	Sets the color correction applied while copying to the frame buffer,
+ *	for direct color modes where the DAC cannot apply it. The whole frame
+ *	is queued for the next present so it all shows the new correction.
+ *	Copies cost more with a correction, so the bandwidth may need to be
+ *	measured again.
+ *
+ *	GFXpresenter * presenter
+ *		Pointer to a presenter structure.
+ *	GFXcorrection * correction
+ *		Correction made for the layout of the back buffer, NULL for none.
+ */
+
+void gfxSetPresentCorrection(GFXpresenter *presenter, GFXcorrection *correction)
+{
+	presenter->Correction = correction;
+	gfxAddDirty(&presenter->Pending, 0, 0, presenter->Target->Width - 1, presenter->Target->Height - 1);
+}
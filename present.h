@@ -0,0 +1,68 @@
+/*******************************************************************************
+ *
+ *	Present library
+ *
+ *	Copies the dirty rectangles of a back buffer in system memory to the
+ *	frame buffer without tearing and without a second page in video memory.
+ *	Each band of rows is written either while the beam is still above it,
+ *	so it is complete before it is scanned, or once the beam has gone past
+ *	it, so it is complete before the next frame scans it. Bands that fit
+ *	neither way within the measured bandwidth wait for the next frame.
+ */
+
+#ifndef present_h
+#define present_h
+
+#include "VGA.h"
+#include "VGAtime.h"
+#include "surface.h"
+#include "region.h"
+#include "gamma.h"
+
+/*******************************************************************************
+ *
+ *	Present flags
+ *
+ ******************************************************************************/
+
+#define GFX_PRESENT_BAND			16	/* Most rows written as one piece */
+#define GFX_PRESENT_PENDING			64	/* Rectangles carried between frames */
+
+/*******************************************************************************
+ *
+ *	Present structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	GFXsurface    *Source;			/* Back buffer */
+	GFXsurface    *Target;			/* Frame buffer, same size and format */
+	VGAtiming     *Timing;			/* Calibrated display timing */
+	long           Bandwidth;		/* Bytes written to the frame buffer per microsecond */
+	GFXdirty       Pending;			/* Work left over from earlier frames */
+	GFXrect       *Bands;			/* Work for the current frame */
+	int            BandsSize;
+	int            Port;			/* Input status 1 */
+	GFXcorrection *Correction;		/* Applied while copying, NULL for a plain copy */
+
+} GFXpresenter;
+
+/*******************************************************************************
+ *
+ *	Present functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreatePresenter(GFXpresenter *presenter, GFXsurface *source, GFXsurface *target, VGAtiming *timing, long bandwidth);
+
+void gfxDestroyPresenter(GFXpresenter *presenter);
+
+long gfxMeasureBandwidth(GFXpresenter *presenter);
+
+int gfxPresent(GFXpresenter *presenter, GFXdirty *dirty);
+
+void gfxSetPresentCorrection(GFXpresenter *presenter, GFXcorrection *correction);
+
+
+#endif /* present_h */
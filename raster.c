@@ -0,0 +1,381 @@
+/*******************************************************************************
+ *
+ *	Raster library
+ *
+ *	Software versions of the solid drawing functions of the accelerator
+ *	interface, for 8, 15, 16, 24 and 32 bit surfaces. They take the same
+ *	arguments as the entry points in AFdc, with a surface in place of the
+ *	device context, except that 'gfxDrawLine' takes whole pixel end points
+ *	where DrawLine takes 16.16 fixed point, so a fallback for DrawLine
+ *	shifts its coordinates right by 16 first. All of them clip to the clip
+ *	rectangle of the surface. The inner loops are written once for each
+ *	pixel size.
+ *
+ *	Based on the official specification
+ *	http://www.vesa.org/public/VBE/vbeaf.pdf
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "raster.h"
+
+/*******************************************************************************
+ *
+ *	Spans
+ *
+ ******************************************************************************/
+
+static void gfxFill1(unsigned char *pixel, int count, unsigned long color)
+{
+	memset(pixel, (int)color, count);
+}
+
+static void gfxFill2(unsigned char *pixel, int count, unsigned long color)
+{
+	unsigned long pair = (color & 0xFFFF) | (color << 16);
+	if(((unsigned long)pixel & 2) && count)
+	{
+		GFX_PUT_2(pixel, color);
+		pixel += 2;
+		count --;
+	}
+	for(; count >= 2; count -= 2, pixel += 4)
+	{
+		GFX_PUT_4(pixel, pair);
+	}
+	if(count)
+	{
+		GFX_PUT_2(pixel, color);
+	}
+}
+
+static void gfxFill3(unsigned char *pixel, int count, unsigned long color)
+{
+	/* Four pixels fit exactly in three dwords */
+	unsigned long first, second, third;
+	color &= 0xFFFFFF;
+	first  = color | (color << 24);
+	second = (color >> 8) | (color << 16);
+	third  = (color >> 16) | (color << 8);
+	for(; count >= 4; count -= 4, pixel += 12)
+	{
+		GFX_PUT_4(pixel,     first);
+		GFX_PUT_4(pixel + 4, second);
+		GFX_PUT_4(pixel + 8, third);
+	}
+	for(; count > 0; count --, pixel += 3)
+	{
+		GFX_PUT_3(pixel, color);
+	}
+}
+
+static void gfxFill4(unsigned char *pixel, int count, unsigned long color)
+{
+	for(; count > 0; count --, pixel += 4)
+	{
+		GFX_PUT_4(pixel, color);
+	}
+}
+
+static void (*Fills[5])(unsigned char *pixel, int count, unsigned long color) =
+{
+	NULL, gfxFill1, gfxFill2, gfxFill3, gfxFill4
+};
+
+/*******************************************************************************
+ *
+ *	Lines
+ *
+ ******************************************************************************/
+
+/*
+ * gfxLine
+ *
+ *	Bresenham's line, stepping along the major axis every pixel and along
+ *	the minor axis when the error term crosses zero.
+ *
+ *	unsigned char * pixel
+ *		First pixel of the line.
+ *	int count
+ *		Pixels to draw.
+ *	int major, minor
+ *		Byte offsets of one step along each axis.
+ *	int dmajor, dminor
+ *		Length of the line along each axis.
+ */
+
+#define GFX_LINE(name, bytes) \
+static void name(unsigned char *pixel, int count, int major, int minor, int dmajor, int dminor, unsigned long color) \
+{ \
+	int error = 2 * dminor - dmajor; \
+	while(count --) \
+	{ \
+		GFX_PUT_##bytes(pixel, color); \
+		if(error >= 0) \
+		{ \
+			pixel += minor; \
+			error -= 2 * dmajor; \
+		} \
+		pixel += major; \
+		error += 2 * dminor; \
+	} \
+}
+
+GFX_LINE(gfxLine1, 1)
+GFX_LINE(gfxLine2, 2)
+GFX_LINE(gfxLine3, 3)
+GFX_LINE(gfxLine4, 4)
+
+static void (*Lines[5])(unsigned char *pixel, int count, int major, int minor, int dmajor, int dminor, unsigned long color) =
+{
+	NULL, gfxLine1, gfxLine2, gfxLine3, gfxLine4
+};
+
+/* Cohen-Sutherland outcodes */
+
+#define GFX_CLIP_LEFT				0x01
+#define GFX_CLIP_RIGHT				0x02
+#define GFX_CLIP_TOP				0x04
+#define GFX_CLIP_BOTTOM				0x08
+
+static int gfxOutCode(GFXsurface *surface, int x, int y)
+{
+	int code = 0;
+	if(x < surface->ClipLeft)
+	{
+		code |= GFX_CLIP_LEFT;
+	}
+	else if(x >= surface->ClipRight)
+	{
+		code |= GFX_CLIP_RIGHT;
+	}
+	if(y < surface->ClipTop)
+	{
+		code |= GFX_CLIP_TOP;
+	}
+	else if(y >= surface->ClipBottom)
+	{
+		code |= GFX_CLIP_BOTTOM;
+	}
+	return code;
+}
+
+/*
+ * gfxClipLine
+ *
+ *	Cohen-Sutherland clipping. Each end outside the clip rectangle is moved
+ *	to where the line crosses the edge it is outside of, until both ends are
+ *	inside or both are outside the same edge.
+ *
+ *	returns
+ *		True if some of the line is left to draw.
+ */
+
+static BOOL gfxClipLine(GFXsurface *surface, int *x1, int *y1, int *x2, int *y2)
+{
+	int code1 = gfxOutCode(surface, *x1, *y1);
+	int code2 = gfxOutCode(surface, *x2, *y2);
+	while(code1 | code2)
+	{
+		int code, x, y;
+		long long dx = *x2 - *x1, dy = *y2 - *y1;
+		if(code1 & code2)
+		{
+			return FALSE;
+		}
+		code = code1 ? code1 : code2;
+		if(code & GFX_CLIP_TOP)
+		{
+			y = surface->ClipTop;
+			x = *x1 + (int)(dx * (y - *y1) / dy);
+		}
+		else if(code & GFX_CLIP_BOTTOM)
+		{
+			y = surface->ClipBottom - 1;
+			x = *x1 + (int)(dx * (y - *y1) / dy);
+		}
+		else if(code & GFX_CLIP_LEFT)
+		{
+			x = surface->ClipLeft;
+			y = *y1 + (int)(dy * (x - *x1) / dx);
+		}
+		else
+		{
+			x = surface->ClipRight - 1;
+			y = *y1 + (int)(dy * (x - *x1) / dx);
+		}
+		if(code == code1)
+		{
+			*x1 = x;
+			*y1 = y;
+			code1 = gfxOutCode(surface, x, y);
+		}
+		else
+		{
+			*x2 = x;
+			*y2 = y;
+			code2 = gfxOutCode(surface, x, y);
+		}
+	}
+	return TRUE;
+}
+
+/*******************************************************************************
+ *
+ *	Raster functions
+ *
+ ******************************************************************************/
+
+/*
+ * gfxFillSpan
+ *
+ *	Fills part of a line with no clipping, for code that has clipped
+ *	already.
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	unsigned long color
+ *		Pixel value.
+ *	int y
+ *		Line to fill.
+ *	int x1, x2
+ *		First pixel and the pixel after the last.
+ */
+
+void gfxFillSpan(GFXsurface *surface, unsigned long color, int y, int x1, int x2)
+{
+	int bytes = surface->BytesPerPixel;
+	Fills[ bytes ](surface->Bits + y * surface->BytesPerLine + x1 * bytes, x2 - x1, color);
+}
+
+/*
+ * gfxDrawScan
+ *
+ *	As the accelerator function, the ends may come in either order and the
+ *	greater one is not drawn.
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	unsigned long color
+ *		Pixel value.
+ *	int y
+ *		Line to draw on.
+ *	int x1, x2
+ *		Ends of the span.
+ */
+
+void gfxDrawScan(GFXsurface *surface, unsigned long color, int y, int x1, int x2)
+{
+	if(x2 < x1)
+	{
+		int swap = x1;
+		x1 = x2;
+		x2 = swap;
+	}
+	if(y < surface->ClipTop || y >= surface->ClipBottom)
+	{
+		return;
+	}
+	x1 = max(x1, surface->ClipLeft);
+	x2 = min(x2, surface->ClipRight);
+	if(x1 < x2)
+	{
+		gfxFillSpan(surface, color, y, x1, x2);
+	}
+}
+
+/*
+ * gfxDrawScanList
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	unsigned long color
+ *		Pixel value.
+ *	int y
+ *		Line of the first span.
+ *	int length
+ *		Number of spans, one for each line down from the first.
+ *	short * scans
+ *		Pairs of ends, as for 'gfxDrawScan'.
+ */
+
+void gfxDrawScanList(GFXsurface *surface, unsigned long color, int y, int length, short *scans)
+{
+	int index;
+	for(index = 0; index < length; index ++)
+	{
+		gfxDrawScan(surface, color, y + index, scans[ index * 2 ], scans[ index * 2 + 1 ]);
+	}
+}
+
+/*
+ * gfxDrawRect
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	unsigned long color
+ *		Pixel value.
+ *	int left, top
+ *		Top left corner.
+ *	int width, height
+ *		Size in pixels.
+ */
+
+void gfxDrawRect(GFXsurface *surface, unsigned long color, int left, int top, int width, int height)
+{
+	int right  = min(left + width, surface->ClipRight);
+	int bottom = min(top + height, surface->ClipBottom);
+	int bytes  = surface->BytesPerPixel;
+	unsigned char *line;
+	left = max(left, surface->ClipLeft);
+	top  = max(top,  surface->ClipTop);
+	if(left >= right || top >= bottom)
+	{
+		return;
+	}
+	line = surface->Bits + top * surface->BytesPerLine + left * bytes;
+	for(; top < bottom; top ++)
+	{
+		Fills[ bytes ](line, right - left, color);
+		line += surface->BytesPerLine;
+	}
+}
+
+/*
+ * gfxDrawLine
+ *
+ *	Draws a line including both end points.
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	unsigned long color
+ *		Pixel value.
+ *	int x1, y1
+ *		Start of the line.
+ *	int x2, y2
+ *		End of the line.
+ */
+
+void gfxDrawLine(GFXsurface *surface, unsigned long color, int x1, int y1, int x2, int y2)
+{
+	int bytes = surface->BytesPerPixel;
+	int dx, dy, sx, sy;
+	if(!gfxClipLine(surface, &x1, &y1, &x2, &y2))
+	{
+		return;
+	}
+	dx = abs(x2 - x1);
+	dy = abs(y2 - y1);
+	sx = x2 < x1 ? -bytes : bytes;
+	sy = y2 < y1 ? -surface->BytesPerLine : surface->BytesPerLine;
+	if(dx >= dy)
+	{
+		Lines[ bytes ](surface->Bits + y1 * surface->BytesPerLine + x1 * bytes, dx + 1, sx, sy, dx, dy, color);
+	}
+	else
+	{
+		Lines[ bytes ](surface->Bits + y1 * surface->BytesPerLine + x1 * bytes, dy + 1, sy, sx, dy, dx, color);
+	}
+}
@@ -0,0 +1,61 @@
+/*******************************************************************************
+ *
+ *	Raster library
+ *
+ *	Software versions of the solid drawing functions of the accelerator
+ *	interface, for 8, 15, 16, 24 and 32 bit surfaces. They take the same
+ *	arguments as the entry points in AFdc, with a surface in place of the
+ *	device context, except that 'gfxDrawLine' takes whole pixel end points
+ *	where DrawLine takes 16.16 fixed point, so a fallback for DrawLine
+ *	shifts its coordinates right by 16 first. All of them clip to the clip
+ *	rectangle of the surface. The inner loops are written once for each
+ *	pixel size.
+ *
+ *	Based on the official specification
+ *	http://www.vesa.org/public/VBE/vbeaf.pdf
+ */
+
+#ifndef raster_h
+#define raster_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	Pixel access
+ *
+ ******************************************************************************/
+
+/* Store a pixel of 1, 2, 3 or 4 bytes, unaligned stores are fine on x86 */
+
+#define GFX_PUT_1(p, c)		(*(p) = (unsigned char)(c))
+#define GFX_PUT_2(p, c)		(*(unsigned short *)(p) = (unsigned short)(c))
+#define GFX_PUT_3(p, c)		((p)[0] = (unsigned char)(c), (p)[1] = (unsigned char)((c) >> 8), (p)[2] = (unsigned char)((c) >> 16))
+#define GFX_PUT_4(p, c)		(*(unsigned long *)(p) = (unsigned long)(c))
+
+/* Load a pixel of 1, 2, 3 or 4 bytes */
+
+#define GFX_GET_1(p)		((unsigned long)*(p))
+#define GFX_GET_2(p)		((unsigned long)*(unsigned short *)(p))
+#define GFX_GET_3(p)		((unsigned long)(p)[0] | ((unsigned long)(p)[1] << 8) | ((unsigned long)(p)[2] << 16))
+#define GFX_GET_4(p)		(*(unsigned long *)(p))
+
+/*******************************************************************************
+ *
+ *	Raster functions
+ *
+ ******************************************************************************/
+
+void gfxFillSpan(GFXsurface *surface, unsigned long color, int y, int x1, int x2);
+
+void gfxDrawScan(GFXsurface *surface, unsigned long color, int y, int x1, int x2);
+
+void gfxDrawScanList(GFXsurface *surface, unsigned long color, int y, int length, short *scans);
+
+void gfxDrawRect(GFXsurface *surface, unsigned long color, int left, int top, int width, int height);
+
+void gfxDrawLine(GFXsurface *surface, unsigned long color, int x1, int y1, int x2, int y2);
+
+
+#endif /* raster_h */
@@ -0,0 +1,132 @@
+/*******************************************************************************
+ *
+ *	Region library
+ *
+ *	Collects the rectangles of a surface changed since the last present so
+ *	only those are copied to the display. The list has a fixed size; once
+ *	full a new rectangle is merged into the one it grows the least.
+ */
+
+#include <stdlib.h>
+
+#include "intern.h"
+#include "region.h"
+
+/*
+ * gfxRectArea
+ */
+
+static long gfxRectArea(int left, int top, int right, int bottom)
+{
+	return (long)(right - left) * (bottom - top);
+}
+
+/*
+ * gfxCreateDirty
+ *
+ *	GFXdirty * dirty
+ *		Pointer to a dirty list structure to initialize.
+ *	int size
+ *		Most rectangles kept before merging.
+ *	returns
+ *		True if the list was allocated.
+ */
+
+BOOL gfxCreateDirty(GFXdirty *dirty, int size)
+{
+	dirty->Count = 0;
+	dirty->Size  = size;
+	dirty->Rects = malloc(size * sizeof(GFXrect));
+	return dirty->Rects != NULL;
+}
+
+/*
+ * gfxDestroyDirty
+ */
+
+void gfxDestroyDirty(GFXdirty *dirty)
+{
+	free(dirty->Rects);
+	dirty->Rects = NULL;
+	dirty->Count = 0;
+	dirty->Size  = 0;
+}
+
+/*
+ * gfxClearDirty
+ */
+
+void gfxClearDirty(GFXdirty *dirty)
+{
+	dirty->Count = 0;
+}
+
+/*
+ * gfxAddDirty
+ *
+ *	As with the clip rectangle the maximum coordinates are inclusive.
+ *
+ *	GFXdirty * dirty
+ *		Pointer to a dirty list structure.
+ */
+
+void gfxAddDirty(GFXdirty *dirty, int xmin, int ymin, int xmax, int ymax)
+{
+	GFXrect rect;
+	rect.Left   = xmin;
+	rect.Top    = ymin;
+	rect.Right  = xmax + 1;
+	rect.Bottom = ymax + 1;
+	gfxAddDirtyRect(dirty, &rect);
+}
+
+/*
+ * gfxAddDirtyRect
+ *
+ *	Adds a rectangle unless it is already covered.
+ *
+ *	GFXdirty * dirty
+ *		Pointer to a dirty list structure.
+ *	GFXrect * rect
+ *		The rectangle, right and bottom edges exclusive.
+ */
+
+void gfxAddDirtyRect(GFXdirty *dirty, GFXrect *rect)
+{
+	int index, best = 0;
+	long growth, least = 0;
+	if(rect->Left >= rect->Right || rect->Top >= rect->Bottom || dirty->Size <= 0)
+	{
+		return;
+	}
+	for(index = 0; index < dirty->Count; index ++)
+	{
+		GFXrect *other = &dirty->Rects[ index ];
+		int left   = min(other->Left,   rect->Left);
+		int top    = min(other->Top,    rect->Top);
+		int right  = max(other->Right,  rect->Right);
+		int bottom = max(other->Bottom, rect->Bottom);
+		growth = gfxRectArea(left, top, right, bottom) - gfxRectArea(other->Left, other->Top, other->Right, other->Bottom);
+		if(growth == 0)
+		{
+			return;
+		}
+		if(index == 0 || growth < least)
+		{
+			least = growth;
+			best  = index;
+		}
+	}
+	if(dirty->Count < dirty->Size)
+	{
+		dirty->Rects[ dirty->Count ++ ] = *rect;
+	}
+	else
+	{
+		GFXrect *other = &dirty->Rects[ best ];
+		other->Left   = min(other->Left,   rect->Left);
+		other->Top    = min(other->Top,    rect->Top);
+		other->Right  = max(other->Right,  rect->Right);
+		other->Bottom = max(other->Bottom, rect->Bottom);
+	}
+}
@@ -0,0 +1,55 @@
+/*******************************************************************************
+ *
+ *	Region library
+ *
+ *	Collects the rectangles of a surface changed since the last present so
+ *	only those are copied to the display. The list has a fixed size; once
+ *	full a new rectangle is merged into the one it grows the least.
+ */
+
+#ifndef region_h
+#define region_h
+
+#include "VGA.h"
+
+/*******************************************************************************
+ *
+ *	Region structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	int Left;
+	int Top;
+	int Right;				/* Exclusive */
+	int Bottom;				/* Exclusive */
+
+} GFXrect;
+
+typedef struct
+{
+	GFXrect *Rects;
+	int      Count;
+	int      Size;				/* Rectangles allocated */
+
+} GFXdirty;
+
+/*******************************************************************************
+ *
+ *	Region functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreateDirty(GFXdirty *dirty, int size);
+
+void gfxDestroyDirty(GFXdirty *dirty);
+
+void gfxClearDirty(GFXdirty *dirty);
+
+void gfxAddDirty(GFXdirty *dirty, int xmin, int ymin, int xmax, int ymax);
+
+void gfxAddDirtyRect(GFXdirty *dirty, GFXrect *rect);
+
+
+#endif /* region_h */
@@ -0,0 +1,288 @@
+/*******************************************************************************
+ *
+ *	RLE library
+ *
+ *	Run length encoded sprites. Each row is stored as pairs of a run of
+ *	transparent pixels to skip and a run of pixels to copy, so drawing
+ *	costs nothing for transparent pixels and tests no color key. Rows are
+ *	found through a table of offsets, so clipped rows are not walked, and
+ *	runs are clipped as whole runs against the clip rectangle.
+ *
+ *	Sprites draw onto surfaces of their own pixel size, packed or in Mode X
+ *	where the four planes each hold every fourth pixel. In Mode X each plane
+ *	is drawn in turn, so the map mask is written four times per sprite
+ *	rather than once per pixel.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "VGAio.h"
+#include "rle.h"
+
+static unsigned long gfxGetPixel(const unsigned char *pixel, int bytes)
+{
+	switch(bytes)
+	{
+	case 2:  return GFX_GET_2(pixel);
+	case 3:  return GFX_GET_3(pixel);
+	case 4:  return GFX_GET_4(pixel);
+	default: return GFX_GET_1(pixel);
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Encoding
+ *
+ ******************************************************************************/
+
+/*
+ * gfxEncodeRow
+ *
+ *	Encodes one row of pixels, or only measures it.
+ *
+ *	unsigned char * data
+ *		Where to write the runs, NULL to measure.
+ *	returns
+ *		The number of bytes the row takes.
+ */
+
+static long gfxEncodeRow(unsigned char *data, const unsigned char *pixels, int width, int bytes, unsigned long key)
+{
+	GFXrun run;
+	long size = 0;
+	int x = 0;
+	while(x < width)
+	{
+		for(run.Skip = 0; x < width && gfxGetPixel(pixels + x * bytes, bytes) == key; x ++)
+		{
+			run.Skip ++;
+		}
+		if(x == width)
+		{
+			break;
+		}
+		for(run.Copy = 0; x < width && gfxGetPixel(pixels + x * bytes, bytes) != key; x ++)
+		{
+			run.Copy ++;
+		}
+		if(data)
+		{
+			memcpy(data + size, &run, sizeof(GFXrun));
+			memcpy(data + size + sizeof(GFXrun), pixels + (x - run.Copy) * bytes, run.Copy * bytes);
+		}
+		size += sizeof(GFXrun) + run.Copy * bytes;
+	}
+	/* End of the row */
+	if(data)
+	{
+		run.Skip = 0;
+		run.Copy = 0;
+		memcpy(data + size, &run, sizeof(GFXrun));
+	}
+	return size + sizeof(GFXrun);
+}
+
+/*
+ * gfxCreateRLE
+ *
+ *	Encodes a rectangle of a surface as a sprite.
+ *
+ *	GFXrle * rle
+ *		Pointer to a sprite structure to initialize.
+ *	GFXsurface * source
+ *		Pointer to the surface holding the image.
+ *	int left, top
+ *		Top left corner of the image in the surface.
+ *	int width, height
+ *		Size of the image, within the surface and at most 65535 wide.
+ *	unsigned long key
+ *		Pixel value of the transparent color.
+ *	returns
+ *		True if the sprite was allocated.
+ */
+
+BOOL gfxCreateRLE(GFXrle *rle, GFXsurface *source, int left, int top, int width, int height, unsigned long key)
+{
+	int bytes = source->BytesPerPixel;
+	const unsigned char *pixels;
+	long size = 0;
+	int row;
+	memset(rle, 0, sizeof(GFXrle));
+	if(left < 0 || top < 0 || width <= 0 || height <= 0 || width > 0xFFFF ||
+	   left + width > source->Width || top + height > source->Height)
+	{
+		return FALSE;
+	}
+	rle->Width         = width;
+	rle->Height        = height;
+	rle->BytesPerPixel = bytes;
+	rle->Rows          = malloc(height * sizeof(long));
+	if(!rle->Rows)
+	{
+		return FALSE;
+	}
+	/* Measure, then encode */
+	pixels = source->Bits + top * source->BytesPerLine + left * bytes;
+	for(row = 0; row < height; row ++, pixels += source->BytesPerLine)
+	{
+		rle->Rows[ row ] = size;
+		size += gfxEncodeRow(NULL, pixels, width, bytes, key);
+	}
+	rle->Size = size;
+	rle->Data = malloc(size);
+	if(!rle->Data)
+	{
+		gfxDestroyRLE(rle);
+		return FALSE;
+	}
+	pixels = source->Bits + top * source->BytesPerLine + left * bytes;
+	for(row = 0; row < height; row ++, pixels += source->BytesPerLine)
+	{
+		gfxEncodeRow(rle->Data + rle->Rows[ row ], pixels, width, bytes, key);
+	}
+	return TRUE;
+}
+
+/*
+ * gfxDestroyRLE
+ */
+
+void gfxDestroyRLE(GFXrle *rle)
+{
+	free(rle->Data);
+	free(rle->Rows);
+	rle->Data = NULL;
+	rle->Rows = NULL;
+	rle->Size = 0;
+}
+
+/*******************************************************************************
+ *
+ *	Drawing
+ *
+ ******************************************************************************/
+
+/*
+ * gfxDrawRLE
+ *
+ *	Draws a sprite onto a packed pixel or direct color surface of the same
+ *	pixel size, clipped to its clip rectangle.
+ *
+ *	GFXsurface * target
+ *		Pointer to the surface to draw on.
+ *	GFXrle * rle
+ *		Pointer to the sprite.
+ *	int x, y
+ *		Position of the top left corner of the sprite.
+ */
+
+void gfxDrawRLE(GFXsurface *target, GFXrle *rle, int x, int y)
+{
+	int bytes = rle->BytesPerPixel;
+	int left = target->ClipLeft, right = target->ClipRight;
+	int row, bottom, start, end, from, to;
+	const unsigned char *data;
+	const GFXrun *run;
+	unsigned char *line;
+	if(target->BytesPerPixel != bytes || x >= right || x + rle->Width <= left)
+	{
+		return;
+	}
+	row    = max(y, target->ClipTop);
+	bottom = min(y + rle->Height, target->ClipBottom);
+	for(; row < bottom; row ++)
+	{
+		data  = rle->Data + rle->Rows[ row - y ];
+		line  = target->Bits + row * target->BytesPerLine;
+		start = x;
+		for(run = (const GFXrun *)data; run->Copy; run = (const GFXrun *)data)
+		{
+			data  += sizeof(GFXrun);
+			start += run->Skip;
+			end    = start + run->Copy;
+			if(start >= right)
+			{
+				break;
+			}
+			if(end > left)
+			{
+				from = max(start, left);
+				to   = min(end, right);
+				memcpy(line + from * bytes, data + (from - start) * bytes, (to - from) * bytes);
+			}
+			data += run->Copy * bytes;
+			start = end;
+		}
+	}
+}
+
+/*
+ * gfxDrawRLEPlanar
+ *
+ *	Draws an 8 bit sprite onto a page of Mode X video memory.
+ *
+ *	GFXsurface * target
+ *		Describes the page. 'Bits' is a near pointer to the start of the
+ *		page at a0000h, 'BytesPerLine' the bytes of one line in one
+ *		plane, a quarter of the width. Width, height and clip rectangle
+ *		are in pixels.
+ *	GFXrle * rle
+ *		Pointer to the sprite.
+ *	int x, y
+ *		Position of the top left corner of the sprite.
+ */
+
+void gfxDrawRLEPlanar(GFXsurface *target, GFXrle *rle, int x, int y)
+{
+	int left = target->ClipLeft, right = target->ClipRight;
+	int plane, mask, top, row, bottom, start, end, pixel, last;
+	const unsigned char *data;
+	const GFXrun *run;
+	unsigned char *line;
+	if(rle->BytesPerPixel != 1 || x >= right || x + rle->Width <= left)
+	{
+		return;
+	}
+	top    = max(y, target->ClipTop);
+	bottom = min(y + rle->Height, target->ClipBottom);
+	if(top >= bottom)
+	{
+		return;
+	}
+	mask = vgaQuerySequencer(VGA_MAP_MASK);
+	for(plane = 0; plane < 4; plane ++)
+	{
+		vgaWriteSequencer(VGA_MAP_MASK, 1 << plane);
+		for(row = top; row < bottom; row ++)
+		{
+			data  = rle->Data + rle->Rows[ row - y ];
+			line  = target->Bits + row * target->BytesPerLine;
+			start = x;
+			for(run = (const GFXrun *)data; run->Copy; run = (const GFXrun *)data)
+			{
+				data  += sizeof(GFXrun);
+				start += run->Skip;
+				end    = start + run->Copy;
+				if(start >= right)
+				{
+					break;
+				}
+				/* First pixel of the run in this plane, then every fourth */
+				pixel = max(start, left);
+				pixel = pixel + ((plane - pixel) & 3);
+				last  = min(end, right);
+				for(; pixel < last; pixel += 4)
+				{
+					line[ pixel >> 2 ] = data[ pixel - start ];
+				}
+				data += run->Copy;
+				start = end;
+			}
+		}
+	}
+	vgaWriteSequencer(VGA_MAP_MASK, mask);
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ *
+ *	RLE library
+ *
+ *	Run length encoded sprites. Each row is stored as pairs of a run of
+ *	transparent pixels to skip and a run of pixels to copy, so drawing
+ *	costs nothing for transparent pixels and tests no color key. Rows are
+ *	found through a table of offsets, so clipped rows are not walked, and
+ *	runs are clipped as whole runs against the clip rectangle.
+ *
+ *	Sprites draw onto surfaces of their own pixel size, packed or in Mode X
+ *	where the four planes each hold every fourth pixel.
+ */
+
+#ifndef rle_h
+#define rle_h
+
+#include "VGA.h"
+#include "surface.h"
+
+/*******************************************************************************
+ *
+ *	RLE structures
+ *
+ ******************************************************************************/
+
+/*
+ * Each row is a list of runs, each a GFXrun followed by 'Copy' pixels, and
+ * ends with a run of zero pixels to skip and zero to copy. Transparent
+ * pixels at the end of a row are not stored.
+ */
+
+typedef struct
+{
+	unsigned short Skip;			/* Transparent pixels before the copy */
+	unsigned short Copy;			/* Pixels that follow */
+
+} GFXrun;
+
+typedef struct
+{
+	int            Width;
+	int            Height;
+	int            BytesPerPixel;
+	unsigned char *Data;			/* Runs of all rows */
+	long          *Rows;			/* Offset of each row in 'Data' */
+	long           Size;			/* Bytes of 'Data' */
+
+} GFXrle;
+
+/*******************************************************************************
+ *
+ *	RLE functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreateRLE(GFXrle *rle, GFXsurface *source, int left, int top, int width, int height, unsigned long key);
+
+void gfxDestroyRLE(GFXrle *rle);
+
+void gfxDrawRLE(GFXsurface *target, GFXrle *rle, int x, int y);
+
+void gfxDrawRLEPlanar(GFXsurface *target, GFXrle *rle, int x, int y);
+
+
+#endif /* rle_h */
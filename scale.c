@@ -0,0 +1,395 @@
+/*******************************************************************************
+ *
+ *	Scale library
+ *
+ *	Presents a small back buffer on a larger display mode, scaled by any
+ *	ratio with nearest or bilinear filtering. Each source line is scaled
+ *	across once into system memory using column tables built up front, and
+ *	output lines are written to the frame buffer in order, whole lines at a
+ *	time, without reading it back.
+ *
+ *	Pixel centers line up: output pixel x samples the source at
+ *	(x + 0.5) * source width / output width, and likewise down.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "scale.h"
+
+/* Blend the fields in mask of two pixels, weight w of 1 << p for the second */
+
+#define GFX_LERP(a, b, w, m, p)		(((((a) & (m)) * ((1UL << (p)) - (w)) + ((b) & (m)) * (w)) >> (p)) & (m))
+
+/*******************************************************************************
+ *
+ *	Line scaling
+ *
+ ******************************************************************************/
+
+/*
+ * gfxStretchNearest
+ *
+ *	Scales a source line across by looking up the source pixel of each
+ *	output column.
+ */
+
+#define GFX_STRETCH_NEAREST(name, bytes) \
+static void name(GFXscaler *scaler, unsigned char *from, unsigned char *to) \
+{ \
+	int *columns = scaler->Columns; \
+	int count = scaler->Output.Right - scaler->Output.Left; \
+	for(; count > 0; count --, to += bytes, columns ++) \
+	{ \
+		GFX_PUT_##bytes(to, GFX_GET_##bytes(from + *columns)); \
+	} \
+}
+
+/*
+ * gfxStretchBilinear
+ *
+ *	Scales a source line across, blending each pair of source pixels.
+ */
+
+#define GFX_STRETCH_BILINEAR(name, bytes) \
+static void name(GFXscaler *scaler, unsigned char *from, unsigned char *to) \
+{ \
+	int *columns = scaler->Columns; \
+	unsigned short *weights = scaler->Weights; \
+	unsigned long rb = scaler->Masks[ 0 ], g = scaler->Masks[ 1 ], a, b; \
+	int precision = scaler->Precision; \
+	int count = scaler->Output.Right - scaler->Output.Left; \
+	for(; count > 0; count --, to += bytes, columns ++, weights ++) \
+	{ \
+		a = GFX_GET_##bytes(from + *columns); \
+		b = GFX_GET_##bytes(from + *columns + bytes); \
+		GFX_PUT_##bytes(to, GFX_LERP(a, b, *weights, rb, precision) | GFX_LERP(a, b, *weights, g, precision)); \
+	} \
+}
+
+/*
+ * gfxBlendLines
+ *
+ *	Blends two lines scaled across into a line of the frame buffer.
+ */
+
+#define GFX_BLEND_LINES(name, bytes) \
+static void name(GFXscaler *scaler, unsigned char *line1, unsigned char *line2, int weight, unsigned char *to) \
+{ \
+	unsigned long rb = scaler->Masks[ 0 ], g = scaler->Masks[ 1 ], a, b; \
+	int precision = scaler->Precision; \
+	int count = scaler->Output.Right - scaler->Output.Left; \
+	for(; count > 0; count --, to += bytes, line1 += bytes, line2 += bytes) \
+	{ \
+		a = GFX_GET_##bytes(line1); \
+		b = GFX_GET_##bytes(line2); \
+		GFX_PUT_##bytes(to, GFX_LERP(a, b, weight, rb, precision) | GFX_LERP(a, b, weight, g, precision)); \
+	} \
+}
+
+GFX_STRETCH_NEAREST(gfxStretchNearest1, 1)
+GFX_STRETCH_NEAREST(gfxStretchNearest2, 2)
+GFX_STRETCH_NEAREST(gfxStretchNearest3, 3)
+GFX_STRETCH_NEAREST(gfxStretchNearest4, 4)
+
+GFX_STRETCH_BILINEAR(gfxStretchBilinear2, 2)
+GFX_STRETCH_BILINEAR(gfxStretchBilinear3, 3)
+GFX_STRETCH_BILINEAR(gfxStretchBilinear4, 4)
+
+GFX_BLEND_LINES(gfxBlendLines2, 2)
+GFX_BLEND_LINES(gfxBlendLines3, 3)
+GFX_BLEND_LINES(gfxBlendLines4, 4)
+
+static void (*StretchNearests[5])(GFXscaler *scaler, unsigned char *from, unsigned char *to) =
+{
+	NULL, gfxStretchNearest1, gfxStretchNearest2, gfxStretchNearest3, gfxStretchNearest4
+};
+
+static void (*StretchBilinears[5])(GFXscaler *scaler, unsigned char *from, unsigned char *to) =
+{
+	NULL, NULL, gfxStretchBilinear2, gfxStretchBilinear3, gfxStretchBilinear4
+};
+
+static void (*BlendLines[5])(GFXscaler *scaler, unsigned char *line1, unsigned char *line2, int weight, unsigned char *to) =
+{
+	NULL, NULL, gfxBlendLines2, gfxBlendLines3, gfxBlendLines4
+};
+
+/*
+ * gfxScaledLine
+ *
+ *	Returns a source line scaled across, scaling it only if neither buffer
+ *	holds it already. The buffer holding line keep is not reused.
+ */
+
+static unsigned char *gfxScaledLine(GFXscaler *scaler, int row, int keep)
+{
+	GFXsurface *source = scaler->Source;
+	int slot;
+	if(scaler->Rows[ 0 ] == row)
+	{
+		return scaler->Lines[ 0 ];
+	}
+	if(scaler->Rows[ 1 ] == row)
+	{
+		return scaler->Lines[ 1 ];
+	}
+	slot = scaler->Rows[ 0 ] == keep ? 1 : 0;
+	if(scaler->Flags & GFX_SCALE_BILINEAR)
+	{
+		StretchBilinears[ source->BytesPerPixel ](scaler, source->Bits + row * source->BytesPerLine, scaler->Lines[ slot ]);
+	}
+	else
+	{
+		StretchNearests[ source->BytesPerPixel ](scaler, source->Bits + row * source->BytesPerLine, scaler->Lines[ slot ]);
+	}
+	scaler->Rows[ slot ] = row;
+	return scaler->Lines[ slot ];
+}
+
+/*
+ * gfxBilinearPosition
+ *
+ *	Finds the source pixel left of or above output pixel index and the
+ *	weight of the one after it, keeping both inside the source.
+ */
+
+static void gfxBilinearPosition(int index, int output, int source, int precision, int *first, int *weight)
+{
+	long long position = (((long long)(2 * index + 1) * source) << 16) / (2 * output) - 0x8000;
+	if(position < 0)
+	{
+		position = 0;
+	}
+	*first = (int)(position >> 16);
+	if(*first >= source - 1)
+	{
+		*first  = source - 2;
+		*weight = 1 << precision;
+	}
+	else
+	{
+		*weight = (int)(position & 0xFFFF) >> (16 - precision);
+	}
+}
+
+/*
+ * gfxBilinearLine
+ *
+ *	Finds the first output line whose blend starts at or below a source
+ *	line, by a binary search over 'gfxBilinearPosition', which never moves
+ *	back as the output line goes down.
+ *
+ *	returns
+ *		The output line, 'output' if there is none.
+ */
+
+static int gfxBilinearLine(int line, int output, int source)
+{
+	int low = 0, high = output, middle, first, weight;
+	while(low < high)
+	{
+		middle = (low + high) / 2;
+		gfxBilinearPosition(middle, output, source, 0, &first, &weight);
+		if(first < line)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+/*******************************************************************************
+ *
+ *	Scale functions
+ *
+ ******************************************************************************/
+
+/*
+ * gfxCreateScaler
+ *
+ *	Works out where the scaled back buffer goes on the frame buffer and
+ *	builds the column tables. The target outside the output rectangle is
+ *	never written, so borders are the caller's to clear.
+ *
+ *	GFXscaler * scaler
+ *		Pointer to a scaler structure to initialize.
+ *	GFXsurface * source
+ *		The back buffer.
+ *	GFXsurface * target
+ *		The frame buffer, with the same pixel size as the back buffer.
+ *	int flags
+ *		How to filter and fit the target.
+ *			GFX_SCALE_NEAREST
+ *			GFX_SCALE_BILINEAR
+ *			GFX_SCALE_ASPECT
+ *			GFX_SCALE_INTEGER
+ *		Without a fit flag the source is stretched over the whole target.
+ *		Bilinear filtering is dropped for 8 bit surfaces, and for direct
+ *		color layouts that do not have green between red and blue.
+ *	returns
+ *		True if the scaler is ready.
+ */
+
+BOOL gfxCreateScaler(GFXscaler *scaler, GFXsurface *source, GFXsurface *target, int flags)
+{
+	int bytes = source->BytesPerPixel;
+	int width = target->Width, height = target->Height;
+	int index, first, weight, multiple;
+	memset(scaler, 0, sizeof(GFXscaler));
+	if(target->BytesPerPixel != bytes || source->Width < 1 || source->Height < 1)
+	{
+		return FALSE;
+	}
+	multiple = min(target->Width / source->Width, target->Height / source->Height);
+	if((flags & GFX_SCALE_INTEGER) && multiple >= 1)
+	{
+		width  = source->Width * multiple;
+		height = source->Height * multiple;
+	}
+	else if(flags & (GFX_SCALE_ASPECT | GFX_SCALE_INTEGER))
+	{
+		if((long)target->Width * source->Height <= (long)target->Height * source->Width)
+		{
+			height = (int)((long)target->Width * source->Height / source->Width);
+		}
+		else
+		{
+			width = (int)((long)target->Height * source->Width / source->Height);
+		}
+	}
+	scaler->Source        = source;
+	scaler->Target        = target;
+	scaler->Flags         = flags;
+	scaler->Output.Left   = (target->Width - width) / 2;
+	scaler->Output.Top    = (target->Height - height) / 2;
+	scaler->Output.Right  = scaler->Output.Left + width;
+	scaler->Output.Bottom = scaler->Output.Top + height;
+	scaler->Rows[ 0 ]     = -1;
+	scaler->Rows[ 1 ]     = -1;
+	/* Red and blue blend in one multiply if green keeps them far enough apart */
+	scaler->Precision = min(8, source->GreenMaskSize);
+	scaler->Masks[ 0 ] = (((1UL << source->RedMaskSize) - 1) << source->RedFieldPosition) |
+	                     (((1UL << source->BlueMaskSize) - 1) << source->BlueFieldPosition);
+	scaler->Masks[ 1 ] = ((1UL << source->GreenMaskSize) - 1) << source->GreenFieldPosition;
+	if(bytes < 2 || source->Width < 2 || source->Height < 2 || scaler->Precision < 1 ||
+	   source->GreenFieldPosition != min(source->RedFieldPosition, source->BlueFieldPosition) +
+	                                 (source->RedFieldPosition < source->BlueFieldPosition ? source->RedMaskSize : source->BlueMaskSize) ||
+	   max(source->RedFieldPosition + source->RedMaskSize, source->BlueFieldPosition + source->BlueMaskSize) + scaler->Precision > 32)
+	{
+		scaler->Flags &= ~GFX_SCALE_BILINEAR;
+	}
+	scaler->Columns    = malloc(width * sizeof(int));
+	scaler->Weights    = malloc(width * sizeof(unsigned short));
+	scaler->Lines[ 0 ] = malloc(width * bytes);
+	scaler->Lines[ 1 ] = malloc(width * bytes);
+	if(!scaler->Columns || !scaler->Weights || !scaler->Lines[ 0 ] || !scaler->Lines[ 1 ])
+	{
+		gfxDestroyScaler(scaler);
+		return FALSE;
+	}
+	for(index = 0; index < width; index ++)
+	{
+		if(scaler->Flags & GFX_SCALE_BILINEAR)
+		{
+			gfxBilinearPosition(index, width, source->Width, scaler->Precision, &first, &weight);
+			scaler->Columns[ index ] = first * bytes;
+			scaler->Weights[ index ] = weight;
+		}
+		else
+		{
+			scaler->Columns[ index ] = (int)((long)(2 * index + 1) * source->Width / (2 * width)) * bytes;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * gfxDestroyScaler
+ */
+
+void gfxDestroyScaler(GFXscaler *scaler)
+{
+	free(scaler->Columns);
+	free(scaler->Weights);
+	free(scaler->Lines[ 0 ]);
+	free(scaler->Lines[ 1 ]);
+	scaler->Columns    = NULL;
+	scaler->Weights    = NULL;
+	scaler->Lines[ 0 ] = NULL;
+	scaler->Lines[ 1 ] = NULL;
+}
+
+/*
+ * gfxScaleRows
+ *
+ *	Writes the output lines that sample a band of source lines.
+ *
+ *	GFXscaler * scaler
+ *		Pointer to a scaler structure.
+ *	int top, bottom
+ *		The band of the back buffer that changed, bottom exclusive.
+ */
+
+void gfxScaleRows(GFXscaler *scaler, int top, int bottom)
+{
+	GFXsurface *source = scaler->Source;
+	GFXsurface *target = scaler->Target;
+	int width = scaler->Output.Right - scaler->Output.Left;
+	int height = scaler->Output.Bottom - scaler->Output.Top;
+	int bytes = source->BytesPerPixel;
+	int first, last, row, weight;
+	unsigned char *to;
+	top    = max(top, 0);
+	bottom = min(bottom, source->Height);
+	if(top >= bottom)
+	{
+		return;
+	}
+	/* The back buffer may have changed since the lines were scaled */
+	scaler->Rows[ 0 ] = -1;
+	scaler->Rows[ 1 ] = -1;
+	/* Output lines sampling the band */
+	if(scaler->Flags & GFX_SCALE_BILINEAR)
+	{
+		/* Those blending a line of the band with the one after or before */
+		first = gfxBilinearLine(top - 1, height, source->Height);
+		last  = gfxBilinearLine(bottom, height, source->Height);
+	}
+	else
+	{
+		first = max((int)((long)top * height / source->Height) - 1, 0);
+		last  = min((int)(((long)bottom * height + source->Height - 1) / source->Height) + 1, height);
+	}
+	to    = target->Bits + (scaler->Output.Top + first) * target->BytesPerLine + scaler->Output.Left * bytes;
+	for(; first < last; first ++, to += target->BytesPerLine)
+	{
+		if(scaler->Flags & GFX_SCALE_BILINEAR)
+		{
+			gfxBilinearPosition(first, height, source->Height, scaler->Precision, &row, &weight);
+			BlendLines[ bytes ](scaler, gfxScaledLine(scaler, row, row + 1), gfxScaledLine(scaler, row + 1, row), weight, to);
+		}
+		else
+		{
+			row = (int)((long)(2 * first + 1) * source->Height / (2 * height));
+			memcpy(to, gfxScaledLine(scaler, row, -1), width * bytes);
+		}
+	}
+}
+
+/*
+ * gfxScale
+ *
+ *	Writes the whole back buffer.
+ */
+
+void gfxScale(GFXscaler *scaler)
+{
+	gfxScaleRows(scaler, 0, scaler->Source->Height);
+}
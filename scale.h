@@ -0,0 +1,71 @@
+/*******************************************************************************
+ *
+ *	Scale library
+ *
+ *	Presents a small back buffer on a larger display mode, scaled by any
+ *	ratio with nearest or bilinear filtering. Each source line is scaled
+ *	across once into system memory using column tables built up front, and
+ *	output lines are written to the frame buffer in order, whole lines at a
+ *	time, without reading it back.
+ *
+ *	Bilinear filtering blends two color fields per multiply, red and blue
+ *	together and green on its own, with weights narrow enough that the
+ *	fields cannot carry into each other. Eight bit surfaces hold palette
+ *	indices, which cannot be blended, so they are always scaled nearest.
+ */
+
+#ifndef scale_h
+#define scale_h
+
+#include "VGA.h"
+#include "surface.h"
+#include "region.h"
+
+/*******************************************************************************
+ *
+ *	Scale flags
+ *
+ ******************************************************************************/
+
+#define GFX_SCALE_NEAREST			0x00	/* Nearest source pixel */
+#define GFX_SCALE_BILINEAR			0x01	/* Blend the four nearest source pixels */
+#define GFX_SCALE_ASPECT			0x02	/* Keep the shape of the source, centered */
+#define GFX_SCALE_INTEGER			0x04	/* Whole multiples of the source size, centered */
+
+/*******************************************************************************
+ *
+ *	Scale structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	GFXsurface     *Source;		/* Back buffer */
+	GFXsurface     *Target;		/* Frame buffer, same pixel size */
+	int             Flags;
+	GFXrect         Output;		/* Part of the target covered */
+	int            *Columns;		/* Source byte offset of each output column */
+	unsigned short *Weights;		/* Bilinear weight of the next source column */
+	unsigned char  *Lines[2];		/* Source lines scaled across */
+	int             Rows[2];		/* Source line held by each, -1 for none */
+	unsigned long   Masks[2];		/* Red and blue fields, green field */
+	int             Precision;		/* Bits of bilinear weight */
+
+} GFXscaler;
+
+/*******************************************************************************
+ *
+ *	Scale functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreateScaler(GFXscaler *scaler, GFXsurface *source, GFXsurface *target, int flags);
+
+void gfxDestroyScaler(GFXscaler *scaler);
+
+void gfxScaleRows(GFXscaler *scaler, int top, int bottom);
+
+void gfxScale(GFXscaler *scaler);
+
+
+#endif /* scale_h */
@@ -0,0 +1,552 @@
+/*******************************************************************************
+ *
+ *	Shade library
+ *
+ *	Smooth shaded fills: colors given at the vertices of a triangle, linear
+ *	gradients between two points and radial gradients around a center.
+ *	Colors are stepped across each span in 16.16 fixed point with no divides
+ *	past the setup, and written in the pixel layout of the surface. Eight
+ *	bit surfaces are dithered with a 4x4 ordered dither to hide the bands of
+ *	the 3:3:2 palette.
+ *
+ *	A gradient is kept as a plane: a color at one pixel and how much it
+ *	changes per pixel across and per line down. Vertex colors and linear
+ *	gradients both reduce to this, so they share the span code. Each
+ *	component is also kept within a range. Past the end points of a linear
+ *	gradient that holds the colors at those of the end points, just as if
+ *	the position along the gradient were clamped, since each component
+ *	only rises or only falls along it.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "shade.h"
+
+/* Largest 16.16 color component, just under 256 */
+
+#define GFX_COLOR_MAX				0xFFFFFF
+
+/* Plane values are stepped in a long when both ends of a span are within this */
+
+#define GFX_PLANE_LIMIT				0x20000000
+
+#define GFX_LIMIT(c, low, high)			((c) < (low) ? (low) : (c) > (high) ? (high) : (c))
+#define GFX_CLAMP(c)				GFX_LIMIT(c, 0, GFX_COLOR_MAX)
+
+/* 4x4 ordered dither thresholds, in sixteenths of a step */
+
+static const int Bayer[4][4] =
+{
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 }
+};
+
+/*******************************************************************************
+ *
+ *	Span shading
+ *
+ ******************************************************************************/
+
+/*
+ * gfxShade
+ *
+ *	Steps the three components across a span and packs them into the
+ *	surface layout. Clamping to the limits of the gradient is only done
+ *	when an end of the span is out of range, which for a plane means some
+ *	of the span may be.
+ */
+
+#define GFX_SHADE(name, bytes) \
+static void name(GFXsurface *surface, unsigned char *pixel, int count, long red, long green, long blue, \
+                 long redX, long greenX, long blueX, const GFXgradient *limits) \
+{ \
+	int redShift      = 24 - surface->RedMaskSize; \
+	int greenShift    = 24 - surface->GreenMaskSize; \
+	int blueShift     = 24 - surface->BlueMaskSize; \
+	int redPosition   = surface->RedFieldPosition; \
+	int greenPosition = surface->GreenFieldPosition; \
+	int bluePosition  = surface->BlueFieldPosition; \
+	long r, g, b; \
+	for(; count > 0; count --, pixel += bytes) \
+	{ \
+		r = red; \
+		g = green; \
+		b = blue; \
+		if(limits) \
+		{ \
+			r = GFX_LIMIT(r, limits->Low[ 0 ], limits->High[ 0 ]); \
+			g = GFX_LIMIT(g, limits->Low[ 1 ], limits->High[ 1 ]); \
+			b = GFX_LIMIT(b, limits->Low[ 2 ], limits->High[ 2 ]); \
+		} \
+		GFX_PUT_##bytes(pixel, ((unsigned long)r >> redShift)   << redPosition   | \
+		                       ((unsigned long)g >> greenShift) << greenPosition | \
+		                       ((unsigned long)b >> blueShift)  << bluePosition); \
+		red   += redX; \
+		green += greenX; \
+		blue  += blueX; \
+	} \
+}
+
+GFX_SHADE(gfxShade2, 2)
+GFX_SHADE(gfxShade3, 3)
+GFX_SHADE(gfxShade4, 4)
+
+static void (*Shades[5])(GFXsurface *surface, unsigned char *pixel, int count, long red, long green, long blue,
+                         long redX, long greenX, long blueX, const GFXgradient *limits) =
+{
+	NULL, NULL, gfxShade2, gfxShade3, gfxShade4
+};
+
+/*
+ * gfxDitherOffsets
+ *
+ *	Thresholds for one line of the dither, scaled to a step of a component
+ *	with the given number of bits, in 16.16 fixed point.
+ */
+
+static void gfxDitherOffsets(long offsets[4], int y, int size)
+{
+	int index;
+	for(index = 0; index < 4; index ++)
+	{
+		offsets[ index ] = ((long)Bayer[ y & 3 ][ index ] << (24 - size)) >> 4;
+	}
+}
+
+/*
+ * gfxShadeDither
+ *
+ *	Eight bit version of 'gfxShade', adding the dither threshold for each
+ *	pixel before the components are cut down to the palette.
+ */
+
+static void gfxShadeDither(GFXsurface *surface, unsigned char *pixel, int count, int x, int y,
+                           long red, long green, long blue, long redX, long greenX, long blueX, const GFXgradient *limits)
+{
+	long redDither[4], greenDither[4], blueDither[4];
+	long r, g, b;
+	gfxDitherOffsets(redDither,   y, surface->RedMaskSize);
+	gfxDitherOffsets(greenDither, y, surface->GreenMaskSize);
+	gfxDitherOffsets(blueDither,  y, surface->BlueMaskSize);
+	for(; count > 0; count --, pixel ++, x ++)
+	{
+		r = red;
+		g = green;
+		b = blue;
+		if(limits)
+		{
+			r = GFX_LIMIT(r, limits->Low[ 0 ], limits->High[ 0 ]);
+			g = GFX_LIMIT(g, limits->Low[ 1 ], limits->High[ 1 ]);
+			b = GFX_LIMIT(b, limits->Low[ 2 ], limits->High[ 2 ]);
+		}
+		r += redDither[ x & 3 ];
+		g += greenDither[ x & 3 ];
+		b += blueDither[ x & 3 ];
+		*pixel = ((unsigned long)GFX_CLAMP(r) >> (24 - surface->RedMaskSize))   << surface->RedFieldPosition   |
+		         ((unsigned long)GFX_CLAMP(g) >> (24 - surface->GreenMaskSize)) << surface->GreenFieldPosition |
+		         ((unsigned long)GFX_CLAMP(b) >> (24 - surface->BlueMaskSize))  << surface->BlueFieldPosition;
+		red   += redX;
+		green += greenX;
+		blue  += blueX;
+	}
+}
+
+/*
+ * gfxPutPixel
+ */
+
+static void gfxPutPixel(unsigned char *pixel, int bytes, unsigned long color)
+{
+	switch(bytes)
+	{
+	case 1: GFX_PUT_1(pixel, color); break;
+	case 2: GFX_PUT_2(pixel, color); break;
+	case 3: GFX_PUT_3(pixel, color); break;
+	case 4: GFX_PUT_4(pixel, color); break;
+	}
+}
+
+/*
+ * gfxDitherColor
+ *
+ *	Packs 8 bit components, dithering them first on 8 bit surfaces.
+ */
+
+static unsigned long gfxDitherColor(GFXsurface *surface, int x, int y, int red, int green, int blue)
+{
+	if(surface->BytesPerPixel == 1)
+	{
+		int threshold = Bayer[ y & 3 ][ x & 3 ];
+		red   = min(red   + ((threshold << (8 - surface->RedMaskSize))   >> 4), 255);
+		green = min(green + ((threshold << (8 - surface->GreenMaskSize)) >> 4), 255);
+		blue  = min(blue  + ((threshold << (8 - surface->BlueMaskSize))  >> 4), 255);
+	}
+	return gfxMapRGB(surface, red, green, blue);
+}
+
+/*
+ * gfxShadeWide
+ *
+ *	Slow path for spans whose ends are far out of range, stepping the
+ *	components in 64 bits so they cannot overflow.
+ */
+
+static void gfxShadeWide(GFXsurface *surface, unsigned char *pixel, int count, int x, int y,
+                         long long red, long long green, long long blue, long redX, long greenX, long blueX, const GFXgradient *limits)
+{
+	for(; count > 0; count --, pixel += surface->BytesPerPixel, x ++)
+	{
+		int r = (int)(GFX_LIMIT(red,   limits->Low[ 0 ], limits->High[ 0 ]) >> 16);
+		int g = (int)(GFX_LIMIT(green, limits->Low[ 1 ], limits->High[ 1 ]) >> 16);
+		int b = (int)(GFX_LIMIT(blue,  limits->Low[ 2 ], limits->High[ 2 ]) >> 16);
+		gfxPutPixel(pixel, surface->BytesPerPixel, gfxDitherColor(surface, x, y, r, g, b));
+		red   += redX;
+		green += greenX;
+		blue  += blueX;
+	}
+}
+
+static BOOL gfxInRange(long long value, long long low, long long high)
+{
+	return value >= low && value <= high;
+}
+
+/*******************************************************************************
+ *
+ *	Gradients
+ *
+ ******************************************************************************/
+
+/*
+ * gfxSetPlane
+ *
+ *	Stores the gradient at the pixel nearest a point.
+ *
+ *	double x, y
+ *		Point the colors are known at, in pixels.
+ *	int red, green, blue
+ *		Colors at that point.
+ */
+
+static void gfxSetPlane(GFXgradient *gradient, double x, double y, int red, int green, int blue)
+{
+	double dx, dy;
+	gradient->OriginX = (int)floor(x + 0.5);
+	gradient->OriginY = (int)floor(y + 0.5);
+	dx = gradient->OriginX - x;
+	dy = gradient->OriginY - y;
+	gradient->Red   = (long)(red   * 65536.0 + gradient->RedX   * dx + gradient->RedY   * dy);
+	gradient->Green = (long)(green * 65536.0 + gradient->GreenX * dx + gradient->GreenY * dy);
+	gradient->Blue  = (long)(blue  * 65536.0 + gradient->BlueX  * dx + gradient->BlueY  * dy);
+}
+
+/*
+ * gfxGouraudGradient
+ *
+ *	Finds the plane through the colors at three vertices.
+ *
+ *	GFXgradient * gradient
+ *		Pointer to a gradient structure to fill in.
+ *	GFXsurface * surface
+ *		Surface the gradient will be drawn on.
+ *	GFXshadePoint * v1, v2, v3
+ *		The vertices and their colors.
+ *	returns
+ *		False if the vertices are in a line.
+ */
+
+BOOL gfxGouraudGradient(GFXgradient *gradient, GFXsurface *surface, GFXshadePoint *v1, GFXshadePoint *v2, GFXshadePoint *v3)
+{
+	double dx1 = (v2->X - v1->X) / 65536.0, dy1 = (v2->Y - v1->Y) / 65536.0;
+	double dx2 = (v3->X - v1->X) / 65536.0, dy2 = (v3->Y - v1->Y) / 65536.0;
+	double det = dx1 * dy2 - dx2 * dy1;
+	memset(gradient, 0, sizeof(GFXgradient));
+	gradient->Surface = surface;
+	if(det == 0.0)
+	{
+		return FALSE;
+	}
+	#define PLANE(name) \
+		gradient->name##X = (long)(((v2->name - v1->name) * dy2 - (v3->name - v1->name) * dy1) / det * 65536.0); \
+		gradient->name##Y = (long)(((v3->name - v1->name) * dx1 - (v2->name - v1->name) * dx2) / det * 65536.0);
+	PLANE(Red);
+	PLANE(Green);
+	PLANE(Blue);
+	#undef PLANE
+	gfxSetPlane(gradient, v1->X / 65536.0, v1->Y / 65536.0, v1->Red, v1->Green, v1->Blue);
+	gradient->High[ 0 ] = GFX_COLOR_MAX;
+	gradient->High[ 1 ] = GFX_COLOR_MAX;
+	gradient->High[ 2 ] = GFX_COLOR_MAX;
+	return TRUE;
+}
+
+/*
+ * gfxLinearGradient
+ *
+ *	Colors change along the line between two points and stay the same
+ *	across it. Past either point the color of that point is used, through
+ *	the limits of each component.
+ *
+ *	GFXgradient * gradient
+ *		Pointer to a gradient structure to fill in.
+ *	GFXsurface * surface
+ *		Surface the gradient will be drawn on.
+ *	GFXshadePoint * from, to
+ *		The end points and their colors.
+ *	returns
+ *		False if the points are the same.
+ */
+
+BOOL gfxLinearGradient(GFXgradient *gradient, GFXsurface *surface, GFXshadePoint *from, GFXshadePoint *to)
+{
+	double dx = (to->X - from->X) / 65536.0, dy = (to->Y - from->Y) / 65536.0;
+	double length = dx * dx + dy * dy;
+	memset(gradient, 0, sizeof(GFXgradient));
+	gradient->Surface = surface;
+	if(length == 0.0)
+	{
+		return FALSE;
+	}
+	#define PLANE(name) \
+		gradient->name##X = (long)((to->name - from->name) * dx / length * 65536.0); \
+		gradient->name##Y = (long)((to->name - from->name) * dy / length * 65536.0);
+	PLANE(Red);
+	PLANE(Green);
+	PLANE(Blue);
+	#undef PLANE
+	gfxSetPlane(gradient, from->X / 65536.0, from->Y / 65536.0, from->Red, from->Green, from->Blue);
+	/* Hold the colors of the end points past them */
+	gradient->Low[ 0 ]  = (long)min(from->Red,   to->Red)   << 16;
+	gradient->Low[ 1 ]  = (long)min(from->Green, to->Green) << 16;
+	gradient->Low[ 2 ]  = (long)min(from->Blue,  to->Blue)  << 16;
+	gradient->High[ 0 ] = (long)max(from->Red,   to->Red)   << 16;
+	gradient->High[ 1 ] = (long)max(from->Green, to->Green) << 16;
+	gradient->High[ 2 ] = (long)max(from->Blue,  to->Blue)  << 16;
+	return TRUE;
+}
+
+/*
+ * gfxRadialGradient
+ *
+ *	Colors change with the distance from a center. The distance is found
+ *	from its square through a ramp, so no square root is taken per pixel.
+ *
+ *	GFXradial * radial
+ *		Pointer to a radial gradient structure to fill in.
+ *	GFXsurface * surface
+ *		Surface the gradient will be drawn on.
+ *	GFXshadePoint * center
+ *		The center and its color.
+ *	GFXshadePoint * edge
+ *		Any point on the circle where the outer color is reached, and that
+ *		color, which is used from there out.
+ *	returns
+ *		False if the points are the same.
+ */
+
+BOOL gfxRadialGradient(GFXradial *radial, GFXsurface *surface, GFXshadePoint *center, GFXshadePoint *edge)
+{
+	double dx = (edge->X - center->X) / 65536.0, dy = (edge->Y - center->Y) / 65536.0;
+	double t;
+	int index;
+	radial->Surface = surface;
+	radial->CenterX = (int)floor(center->X / 65536.0 + 0.5);
+	radial->CenterY = (int)floor(center->Y / 65536.0 + 0.5);
+	radial->Radius2 = (long)(dx * dx + dy * dy);
+	if(radial->Radius2 <= 0)
+	{
+		return FALSE;
+	}
+	radial->Scale = ((long)GFX_RADIAL_STEPS << 16) / radial->Radius2;
+	for(index = 0; index <= GFX_RADIAL_STEPS; index ++)
+	{
+		t = sqrt((double)index / GFX_RADIAL_STEPS);
+		radial->Ramp[ index ][ 0 ] = (unsigned char)(center->Red   + (edge->Red   - center->Red)   * t + 0.5);
+		radial->Ramp[ index ][ 1 ] = (unsigned char)(center->Green + (edge->Green - center->Green) * t + 0.5);
+		radial->Ramp[ index ][ 2 ] = (unsigned char)(center->Blue  + (edge->Blue  - center->Blue)  * t + 0.5);
+	}
+	return TRUE;
+}
+
+/*******************************************************************************
+ *
+ *	Span functions
+ *
+ ******************************************************************************/
+
+/*
+ * gfxGradientSpan
+ *
+ *	Span function for a GFXspanWriter, with the gradient as its context.
+ *	The span must already be clipped.
+ */
+
+void gfxGradientSpan(void *context, int y, int x1, int x2)
+{
+	GFXgradient *gradient = context;
+	GFXsurface *surface = gradient->Surface;
+	int count = x2 - x1, dx = x1 - gradient->OriginX, dy = y - gradient->OriginY;
+	unsigned char *pixel = surface->Bits + y * surface->BytesPerLine + x1 * surface->BytesPerPixel;
+	long long red   = gradient->Red   + (long long)gradient->RedX   * dx + (long long)gradient->RedY   * dy;
+	long long green = gradient->Green + (long long)gradient->GreenX * dx + (long long)gradient->GreenY * dy;
+	long long blue  = gradient->Blue  + (long long)gradient->BlueX  * dx + (long long)gradient->BlueY  * dy;
+	long long redEnd   = red   + (long long)gradient->RedX   * (count - 1);
+	long long greenEnd = green + (long long)gradient->GreenX * (count - 1);
+	long long blueEnd  = blue  + (long long)gradient->BlueX  * (count - 1);
+	BOOL clamp;
+	if(count <= 0)
+	{
+		return;
+	}
+	#define WITHIN(redLow, redHigh, greenLow, greenHigh, blueLow, blueHigh) \
+		(gfxInRange(red, redLow, redHigh) && gfxInRange(redEnd, redLow, redHigh) && \
+		 gfxInRange(green, greenLow, greenHigh) && gfxInRange(greenEnd, greenLow, greenHigh) && \
+		 gfxInRange(blue, blueLow, blueHigh) && gfxInRange(blueEnd, blueLow, blueHigh))
+	if(!WITHIN(-GFX_PLANE_LIMIT, GFX_PLANE_LIMIT, -GFX_PLANE_LIMIT, GFX_PLANE_LIMIT, -GFX_PLANE_LIMIT, GFX_PLANE_LIMIT))
+	{
+		gfxShadeWide(surface, pixel, count, x1, y, red, green, blue, gradient->RedX, gradient->GreenX, gradient->BlueX, gradient);
+		return;
+	}
+	clamp = !WITHIN(gradient->Low[ 0 ], gradient->High[ 0 ], gradient->Low[ 1 ], gradient->High[ 1 ], gradient->Low[ 2 ], gradient->High[ 2 ]);
+	#undef WITHIN
+	if(surface->BytesPerPixel == 1)
+	{
+		gfxShadeDither(surface, pixel, count, x1, y, (long)red, (long)green, (long)blue, gradient->RedX, gradient->GreenX, gradient->BlueX,
+		               clamp ? gradient : NULL);
+	}
+	else
+	{
+		Shades[ surface->BytesPerPixel ](surface, pixel, count, (long)red, (long)green, (long)blue, gradient->RedX, gradient->GreenX, gradient->BlueX,
+		                                 clamp ? gradient : NULL);
+	}
+}
+
+/*
+ * gfxRadialSpan
+ *
+ *	Span function for a GFXspanWriter, with the radial gradient as its
+ *	context. The square of the distance is stepped by its differences.
+ */
+
+void gfxRadialSpan(void *context, int y, int x1, int x2)
+{
+	GFXradial *radial = context;
+	GFXsurface *surface = radial->Surface;
+	int bytes = surface->BytesPerPixel;
+	unsigned char *pixel = surface->Bits + y * surface->BytesPerLine + x1 * bytes;
+	long dx = x1 - radial->CenterX, dy = y - radial->CenterY;
+	long distance = dx * dx + dy * dy;
+	unsigned char *color;
+	int x;
+	for(x = x1; x < x2; x ++, pixel += bytes)
+	{
+		color = radial->Ramp[ distance >= radial->Radius2 ? GFX_RADIAL_STEPS : (distance * radial->Scale) >> 16 ];
+		gfxPutPixel(pixel, bytes, gfxDitherColor(surface, x, y, color[ 0 ], color[ 1 ], color[ 2 ]));
+		/* (dx + 1)^2 - dx^2 */
+		distance += 2 * dx + 1;
+		dx ++;
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Fills
+ *
+ ******************************************************************************/
+
+/*
+ * gfxDrawGouraudTri
+ *
+ *	Draws a triangle with the colors of the vertices blended across it,
+ *	covering the same pixels as 'gfxDrawTri'.
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	GFXshadePoint * v1, v2, v3
+ *		The vertices and their colors.
+ */
+
+void gfxDrawGouraudTri(GFXsurface *surface, GFXshadePoint *v1, GFXshadePoint *v2, GFXshadePoint *v3)
+{
+	GFXgradient gradient;
+	GFXspanWriter writer;
+	GFXfxpoint p1, p2, p3;
+	if(!gfxGouraudGradient(&gradient, surface, v1, v2, v3))
+	{
+		return;
+	}
+	p1.X = v1->X; p1.Y = v1->Y;
+	p2.X = v2->X; p2.Y = v2->Y;
+	p3.X = v3->X; p3.Y = v3->Y;
+	gfxSpanWriter(&writer, surface, gfxGradientSpan, &gradient);
+	gfxScanTri(&writer, &p1, &p2, &p3, 0, 0);
+}
+
+/*
+ * gfxClipRect
+ *
+ *	Clips a rectangle given by its corner and size to a surface.
+ *
+ *	returns
+ *		False if nothing is left.
+ */
+
+static BOOL gfxClipRect(GFXsurface *surface, int *left, int *top, int *right, int *bottom)
+{
+	*right  = min(*right,  surface->ClipRight);
+	*bottom = min(*bottom, surface->ClipBottom);
+	*left   = max(*left,   surface->ClipLeft);
+	*top    = max(*top,    surface->ClipTop);
+	return *left < *right && *top < *bottom;
+}
+
+/*
+ * gfxDrawGradientRect
+ *
+ *	GFXgradient * gradient
+ *		Pointer to a gradient, which also names the surface.
+ *	int left, top
+ *		Top left corner.
+ *	int width, height
+ *		Size in pixels.
+ */
+
+void gfxDrawGradientRect(GFXgradient *gradient, int left, int top, int width, int height)
+{
+	int right = left + width, bottom = top + height;
+	if(gfxClipRect(gradient->Surface, &left, &top, &right, &bottom))
+	{
+		for(; top < bottom; top ++)
+		{
+			gfxGradientSpan(gradient, top, left, right);
+		}
+	}
+}
+
+/*
+ * gfxDrawRadialRect
+ *
+ *	GFXradial * radial
+ *		Pointer to a radial gradient, which also names the surface.
+ *	int left, top
+ *		Top left corner.
+ *	int width, height
+ *		Size in pixels.
+ */
+
+void gfxDrawRadialRect(GFXradial *radial, int left, int top, int width, int height)
+{
+	int right = left + width, bottom = top + height;
+	if(gfxClipRect(radial->Surface, &left, &top, &right, &bottom))
+	{
+		for(; top < bottom; top ++)
+		{
+			gfxRadialSpan(radial, top, left, right);
+		}
+	}
+}
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ *
+ *	Shade library
+ *
+ *	Smooth shaded fills: colors given at the vertices of a triangle, linear
+ *	gradients between two points and radial gradients around a center.
+ *	Colors are stepped across each span in 16.16 fixed point with no divides
+ *	past the setup, and written in the pixel layout of the surface. Eight
+ *	bit surfaces are dithered with a 4x4 ordered dither to hide the bands of
+ *	the 3:3:2 palette.
+ *
+ *	The span functions fit a GFXspanWriter, so any shape the polygon scan
+ *	converter draws can be shaded.
+ */
+
+#ifndef shade_h
+#define shade_h
+
+#include "VGA.h"
+#include "surface.h"
+#include "polygon.h"
+
+/*******************************************************************************
+ *
+ *	Shade flags
+ *
+ ******************************************************************************/
+
+#define GFX_RADIAL_STEPS			1024	/* Entries in the radial color ramp */
+
+/*******************************************************************************
+ *
+ *	Shade structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	long X;					/* 16.16 fixed point */
+	long Y;					/* 16.16 fixed point */
+	int  Red;				/* Color components in the range 0-255 */
+	int  Green;
+	int  Blue;
+
+} GFXshadePoint;
+
+/* Colors as a plane over the surface, all 16.16 fixed point */
+
+typedef struct
+{
+	GFXsurface *Surface;
+	int         OriginX;		/* Pixel the colors are given at */
+	int         OriginY;
+	long        Red;
+	long        Green;
+	long        Blue;
+	long        RedX;			/* Change per pixel across */
+	long        GreenX;
+	long        BlueX;
+	long        RedY;			/* Change per line down */
+	long        GreenY;
+	long        BlueY;
+	long        Low[3];			/* Least red, green and blue drawn */
+	long        High[3];		/* Greatest red, green and blue drawn */
+
+} GFXgradient;
+
+typedef struct
+{
+	GFXsurface   *Surface;
+	int           CenterX;
+	int           CenterY;
+	long          Radius2;		/* Square of the radius in pixels */
+	long          Scale;		/* Ramp steps per square pixel, 16.16 */
+	unsigned char Ramp[GFX_RADIAL_STEPS + 1][3];	/* Colors by distance squared */
+
+} GFXradial;
+
+/*******************************************************************************
+ *
+ *	Shade functions
+ *
+ ******************************************************************************/
+
+/* Gradients */
+
+BOOL gfxGouraudGradient(GFXgradient *gradient, GFXsurface *surface, GFXshadePoint *v1, GFXshadePoint *v2, GFXshadePoint *v3);
+
+BOOL gfxLinearGradient(GFXgradient *gradient, GFXsurface *surface, GFXshadePoint *from, GFXshadePoint *to);
+
+BOOL gfxRadialGradient(GFXradial *radial, GFXsurface *surface, GFXshadePoint *center, GFXshadePoint *edge);
+
+/* Span functions */
+
+void gfxGradientSpan(void *gradient, int y, int x1, int x2);
+
+void gfxRadialSpan(void *radial, int y, int x1, int x2);
+
+/* Fills */
+
+void gfxDrawGouraudTri(GFXsurface *surface, GFXshadePoint *v1, GFXshadePoint *v2, GFXshadePoint *v3);
+
+void gfxDrawGradientRect(GFXgradient *gradient, int left, int top, int width, int height);
+
+void gfxDrawRadialRect(GFXradial *radial, int left, int top, int width, int height);
+
+
+#endif /* shade_h */
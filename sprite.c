@@ -0,0 +1,320 @@
+/*******************************************************************************
+ *
+ *	Sprite library
+ *
+ *	Keeps many sprites as parallel arrays of positions, sizes, depths and
+ *	images, so a frame walks each array in order instead of a structure
+ *	per sprite. Drawing culls every sprite against the clip rectangle in
+ *	one pass, sorts those left by depth with a radix sort, and draws them
+ *	back to front through the run length encoded blitter in one batch,
+ *	adding where they were and where they are now to a dirty list.
+ *
+ *	The cull stores each visible sprite as one key, depth above index, so
+ *	the sort moves single dwords through two passes of eight bits and never
+ *	goes back to the arrays. A pass is skipped when every key falls in the
+ *	same bucket, as when all sprites share a depth.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "sprite.h"
+
+/*
+ * gfxCreateSprites
+ *
+ *	GFXsprites * sprites
+ *		Pointer to a sprite list structure to initialize.
+ *	int size
+ *		Most sprites, up to GFX_SPRITE_MAX.
+ *	int images
+ *		Most images.
+ *	returns
+ *		True if the lists were allocated.
+ */
+
+BOOL gfxCreateSprites(GFXsprites *sprites, int size, int images)
+{
+	memset(sprites, 0, sizeof(GFXsprites));
+	if(size <= 0 || size > GFX_SPRITE_MAX || images <= 0 || images >= GFX_SPRITE_HIDDEN)
+	{
+		return FALSE;
+	}
+	sprites->Size      = size;
+	sprites->ImageSize = images;
+	sprites->X         = malloc(size * sizeof(int));
+	sprites->Y         = malloc(size * sizeof(int));
+	sprites->Width     = malloc(size * sizeof(unsigned short));
+	sprites->Height    = malloc(size * sizeof(unsigned short));
+	sprites->Depth     = malloc(size * sizeof(unsigned short));
+	sprites->Image     = malloc(size * sizeof(unsigned short));
+	sprites->Keys      = malloc(size * sizeof(unsigned long));
+	sprites->Sorted    = malloc(size * sizeof(unsigned long));
+	sprites->Images    = malloc(images * sizeof(GFXrle *));
+	if(!sprites->X || !sprites->Y || !sprites->Width || !sprites->Height || !sprites->Depth ||
+	   !sprites->Image || !sprites->Keys || !sprites->Sorted || !sprites->Images ||
+	   !gfxCreateDirty(&sprites->Drawn, GFX_SPRITE_DRAWN))
+	{
+		gfxDestroySprites(sprites);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * gfxDestroySprites
+ *
+ *	Frees the lists, not the images.
+ */
+
+void gfxDestroySprites(GFXsprites *sprites)
+{
+	free(sprites->X);
+	free(sprites->Y);
+	free(sprites->Width);
+	free(sprites->Height);
+	free(sprites->Depth);
+	free(sprites->Image);
+	free(sprites->Keys);
+	free(sprites->Sorted);
+	free(sprites->Images);
+	gfxDestroyDirty(&sprites->Drawn);
+	memset(sprites, 0, sizeof(GFXsprites));
+}
+
+/*
+ * gfxAddSpriteImage
+ *
+ *	GFXsprites * sprites
+ *		Pointer to the sprite list.
+ *	GFXrle * image
+ *		Encoded image, kept for the life of the list.
+ *	returns
+ *		Handle of the image, -1 if the list of images is full.
+ */
+
+int gfxAddSpriteImage(GFXsprites *sprites, GFXrle *image)
+{
+	if(sprites->ImageCount == sprites->ImageSize)
+	{
+		return -1;
+	}
+	sprites->Images[ sprites->ImageCount ] = image;
+	return sprites->ImageCount ++;
+}
+
+/*
+ * gfxAddSprite
+ *
+ *	GFXsprites * sprites
+ *		Pointer to the sprite list.
+ *	int image
+ *		Handle of the image, or GFX_SPRITE_HIDDEN.
+ *	int x, y
+ *		Position of the top left corner.
+ *	int depth
+ *		0 to 65535, greater is drawn over lesser.
+ *	returns
+ *		Index of the sprite, -1 if the list is full.
+ */
+
+int gfxAddSprite(GFXsprites *sprites, int image, int x, int y, int depth)
+{
+	int index = sprites->Count;
+	if(index == sprites->Size)
+	{
+		return -1;
+	}
+	sprites->Count ++;
+	sprites->X[ index ]     = x;
+	sprites->Y[ index ]     = y;
+	sprites->Depth[ index ] = (unsigned short)depth;
+	gfxSetSpriteImage(sprites, index, image);
+	return index;
+}
+
+/*
+ * gfxRemoveSprite
+ *
+ *	Moves the last sprite into the place of the one removed, so the index
+ *	of the last sprite changes to 'index'.
+ */
+
+void gfxRemoveSprite(GFXsprites *sprites, int index)
+{
+	int last = sprites->Count - 1;
+	if(index < 0 || index > last)
+	{
+		return;
+	}
+	sprites->X[ index ]      = sprites->X[ last ];
+	sprites->Y[ index ]      = sprites->Y[ last ];
+	sprites->Width[ index ]  = sprites->Width[ last ];
+	sprites->Height[ index ] = sprites->Height[ last ];
+	sprites->Depth[ index ]  = sprites->Depth[ last ];
+	sprites->Image[ index ]  = sprites->Image[ last ];
+	sprites->Count = last;
+}
+
+/*
+ * gfxSetSpriteImage
+ *
+ *	Changes the image of a sprite, and with it the size the cull uses.
+ *
+ *	int image
+ *		Handle of the image, or GFX_SPRITE_HIDDEN to stop drawing it.
+ */
+
+void gfxSetSpriteImage(GFXsprites *sprites, int index, int image)
+{
+	if(image < 0 || image >= sprites->ImageCount)
+	{
+		image = GFX_SPRITE_HIDDEN;
+	}
+	sprites->Image[ index ]  = (unsigned short)image;
+	sprites->Width[ index ]  = image == GFX_SPRITE_HIDDEN ? 0 : (unsigned short)sprites->Images[ image ]->Width;
+	sprites->Height[ index ] = image == GFX_SPRITE_HIDDEN ? 0 : (unsigned short)sprites->Images[ image ]->Height;
+}
+
+/*
+ * gfxCullSprites
+ *
+ *	Writes a key for every sprite overlapping the clip rectangle. The index
+ *	is always written and the count only moves on for visible sprites, so
+ *	the loop has no branch to mispredict. A hidden sprite has no width.
+ *
+ *	returns
+ *		The number of keys.
+ */
+
+static int gfxCullSprites(GFXsprites *sprites, GFXsurface *target)
+{
+	const int *x = sprites->X, *y = sprites->Y;
+	const unsigned short *width = sprites->Width, *height = sprites->Height, *depth = sprites->Depth;
+	unsigned long *keys = sprites->Keys;
+	int left = target->ClipLeft, top = target->ClipTop, right = target->ClipRight, bottom = target->ClipBottom;
+	int index, count = 0;
+	for(index = 0; index < sprites->Count; index ++)
+	{
+		keys[ count ] = (unsigned long)depth[ index ] << 16 | index;
+		count += (x[ index ] < right) & (x[ index ] + width[ index ] > left) &
+		         (y[ index ] < bottom) & (y[ index ] + height[ index ] > top) & (width[ index ] != 0);
+	}
+	return count;
+}
+
+/*
+ * gfxRadixPass
+ *
+ *	Stable counting sort of keys on one byte.
+ *
+ *	unsigned long * counts
+ *		Keys in each bucket.
+ *	int shift
+ *		Position of the byte in the key.
+ */
+
+static void gfxRadixPass(unsigned long *to, const unsigned long *from, int count, unsigned long *counts, int shift)
+{
+	unsigned long offsets[256], offset = 0;
+	int bucket, index;
+	for(bucket = 0; bucket < 256; bucket ++)
+	{
+		offsets[ bucket ] = offset;
+		offset += counts[ bucket ];
+	}
+	for(index = 0; index < count; index ++)
+	{
+		to[ offsets[ (from[ index ] >> shift) & 0xFF ] ++ ] = from[ index ];
+	}
+}
+
+/*
+ * gfxSortSprites
+ *
+ *	Sorts the keys by depth, low byte then high byte.
+ *
+ *	returns
+ *		The sorted keys, in 'Keys' or 'Sorted'.
+ */
+
+static unsigned long *gfxSortSprites(GFXsprites *sprites, int count)
+{
+	unsigned long low[256], high[256];
+	unsigned long *from = sprites->Keys, *to = sprites->Sorted, *swap;
+	int index;
+	if(count < 2)
+	{
+		return from;
+	}
+	memset(low, 0, sizeof(low));
+	memset(high, 0, sizeof(high));
+	for(index = 0; index < count; index ++)
+	{
+		low[ (from[ index ] >> 16) & 0xFF ] ++;
+		high[ (from[ index ] >> 24) & 0xFF ] ++;
+	}
+	if(low[ (from[ 0 ] >> 16) & 0xFF ] != (unsigned long)count)
+	{
+		gfxRadixPass(to, from, count, low, 16);
+		swap = from;
+		from = to;
+		to   = swap;
+	}
+	if(high[ (from[ 0 ] >> 24) & 0xFF ] != (unsigned long)count)
+	{
+		gfxRadixPass(to, from, count, high, 24);
+		from = to;
+	}
+	return from;
+}
+
+/*
+ * gfxDrawSprites
+ *
+ *	Draws every visible sprite, back to front, clipped to the target. The
+ *	caller restores what was under the sprites, the rectangles of 'Drawn',
+ *	before calling.
+ *
+ *	GFXsprites * sprites
+ *		Pointer to the sprite list.
+ *	GFXsurface * target
+ *		Surface to draw on, with the pixel size of the images.
+ *	GFXdirty * dirty
+ *		Receives the rectangles drawn by the last frame and this one,
+ *		or NULL.
+ *	returns
+ *		The number of sprites drawn.
+ */
+
+int gfxDrawSprites(GFXsprites *sprites, GFXsurface *target, GFXdirty *dirty)
+{
+	int count = gfxCullSprites(sprites, target);
+	unsigned long *keys = gfxSortSprites(sprites, count);
+	int iterator, index;
+	GFXrect rect;
+	if(dirty)
+	{
+		for(iterator = 0; iterator < sprites->Drawn.Count; iterator ++)
+		{
+			gfxAddDirtyRect(dirty, &sprites->Drawn.Rects[ iterator ]);
+		}
+	}
+	gfxClearDirty(&sprites->Drawn);
+	for(iterator = 0; iterator < count; iterator ++)
+	{
+		index = (int)(keys[ iterator ] & 0xFFFF);
+		gfxDrawRLE(target, sprites->Images[ sprites->Image[ index ] ], sprites->X[ index ], sprites->Y[ index ]);
+		rect.Left   = max(sprites->X[ index ], target->ClipLeft);
+		rect.Top    = max(sprites->Y[ index ], target->ClipTop);
+		rect.Right  = min(sprites->X[ index ] + sprites->Width[ index ], target->ClipRight);
+		rect.Bottom = min(sprites->Y[ index ] + sprites->Height[ index ], target->ClipBottom);
+		gfxAddDirtyRect(&sprites->Drawn, &rect);
+		if(dirty)
+		{
+			gfxAddDirtyRect(dirty, &rect);
+		}
+	}
+	return count;
+}
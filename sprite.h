@@ -0,0 +1,86 @@
+/*******************************************************************************
+ *
+ *	Sprite library
+ *
+ *	Keeps many sprites as parallel arrays of positions, sizes, depths and
+ *	images, so a frame walks each array in order instead of a structure
+ *	per sprite. Drawing culls every sprite against the clip rectangle in
+ *	one pass, sorts those left by depth with a radix sort, and draws them
+ *	back to front through the run length encoded blitter in one batch,
+ *	adding where they were and where they are now to a dirty list.
+ */
+
+#ifndef sprite_h
+#define sprite_h
+
+#include "VGA.h"
+#include "surface.h"
+#include "region.h"
+#include "rle.h"
+
+/*******************************************************************************
+ *
+ *	Sprite flags
+ *
+ ******************************************************************************/
+
+#define GFX_SPRITE_HIDDEN			0xFFFF	/* Image of a sprite not drawn */
+#define GFX_SPRITE_MAX				65536	/* Most sprites, indices fit in 16 bits */
+#define GFX_SPRITE_DRAWN			64	/* Rectangles kept of the last frame */
+
+/*******************************************************************************
+ *
+ *	Sprite structures
+ *
+ ******************************************************************************/
+
+/*
+ * The arrays may be written directly, except 'Width' and 'Height' which
+ * follow 'Image' through 'gfxSetSpriteImage'. Sprites of greater depth are
+ * drawn over those of lesser depth, and of equal depth in index order.
+ */
+
+typedef struct
+{
+	/* One entry per sprite */
+	int            *X;
+	int            *Y;
+	unsigned short *Width;
+	unsigned short *Height;
+	unsigned short *Depth;
+	unsigned short *Image;			/* Handle, or GFX_SPRITE_HIDDEN */
+	int             Count;
+	int             Size;			/* Sprites allocated */
+	/* Images by handle */
+	GFXrle        **Images;
+	int             ImageCount;
+	int             ImageSize;
+	/* Work for a frame, depth and index in each key */
+	unsigned long  *Keys;
+	unsigned long  *Sorted;
+	GFXdirty        Drawn;			/* Rectangles drawn by the last frame */
+
+} GFXsprites;
+
+/*******************************************************************************
+ *
+ *	Sprite functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreateSprites(GFXsprites *sprites, int size, int images);
+
+void gfxDestroySprites(GFXsprites *sprites);
+
+int gfxAddSpriteImage(GFXsprites *sprites, GFXrle *image);
+
+int gfxAddSprite(GFXsprites *sprites, int image, int x, int y, int depth);
+
+void gfxRemoveSprite(GFXsprites *sprites, int index);
+
+void gfxSetSpriteImage(GFXsprites *sprites, int index, int image);
+
+int gfxDrawSprites(GFXsprites *sprites, GFXsurface *target, GFXdirty *dirty);
+
+
+#endif /* sprite_h */
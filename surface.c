@@ -0,0 +1,267 @@
+/*******************************************************************************
+ *
+ *	Surface library
+ *
+ *	Describes a block of pixels in system memory or in a linear frame buffer
+ *	so that software drawing code can work on any of the packed pixel and
+ *	direct color formats reported in VBEmodeInfo.
+ *
+ *	Based on the official specification
+ *	http://www.vesa.org/public/VBE/vbe3.pdf
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "intern.h"
+#include "surface.h"
+
+/*
+ * gfxSetLayout
+ *
+ *	Fills in the direct color layout used for a pixel size when none is
+ *	given by the hardware. Eight bit surfaces assume a 3:3:2 palette.
+ */
+
+static void gfxSetLayout(GFXsurface *surface)
+{
+	switch(surface->BitsPerPixel)
+	{
+	case 8:
+		surface->RedMaskSize   = 3; surface->RedFieldPosition   = 5;
+		surface->GreenMaskSize = 3; surface->GreenFieldPosition = 2;
+		surface->BlueMaskSize  = 2; surface->BlueFieldPosition  = 0;
+		break;
+	case 15:
+		surface->RedMaskSize   = 5; surface->RedFieldPosition   = 10;
+		surface->GreenMaskSize = 5; surface->GreenFieldPosition = 5;
+		surface->BlueMaskSize  = 5; surface->BlueFieldPosition  = 0;
+		surface->ReservedMaskSize = 1; surface->ReservedFieldPosition = 15;
+		break;
+	case 16:
+		surface->RedMaskSize   = 5; surface->RedFieldPosition   = 11;
+		surface->GreenMaskSize = 6; surface->GreenFieldPosition = 5;
+		surface->BlueMaskSize  = 5; surface->BlueFieldPosition  = 0;
+		break;
+	case 32:
+		surface->ReservedMaskSize = 8; surface->ReservedFieldPosition = 24;
+		/* Fall through */
+	case 24:
+		surface->RedMaskSize   = 8; surface->RedFieldPosition   = 16;
+		surface->GreenMaskSize = 8; surface->GreenFieldPosition = 8;
+		surface->BlueMaskSize  = 8; surface->BlueFieldPosition  = 0;
+		break;
+	}
+}
+
+/*
+ * gfxCreateSurface
+ *
+ *	Allocates a surface in system memory.
+ *
+ *	GFXsurface * surface
+ *		Pointer to a surface structure to initialize.
+ *	int width
+ *		Width in pixels.
+ *	int height
+ *		Height in pixels.
+ *	int bitsPerPixel
+ *		One of 8, 15, 16, 24 or 32. Direct color surfaces get the common
+ *		5:5:5, 5:6:5 or 8:8:8 layouts with red in the high bits.
+ *	returns
+ *		True if the pixel memory was allocated.
+ */
+
+BOOL gfxCreateSurface(GFXsurface *surface, int width, int height, int bitsPerPixel)
+{
+	memset(surface, 0, sizeof(GFXsurface));
+	surface->BitsPerPixel  = bitsPerPixel;
+	surface->BytesPerPixel = (bitsPerPixel + 7) / 8;
+	surface->Width         = width;
+	surface->Height        = height;
+	/* Keep every line dword aligned */
+	surface->BytesPerLine  = (width * surface->BytesPerPixel + 3) & ~3;
+	surface->Bits          = calloc(height, surface->BytesPerLine);
+	if(!surface->Bits)
+	{
+		return FALSE;
+	}
+	surface->Allocated = TRUE;
+	gfxSetLayout(surface);
+	gfxSetClipRect(surface, 0, 0, width - 1, height - 1);
+	return TRUE;
+}
+
+/*
+ * gfxModeSurface
+ *
+ *	Describes the linear frame buffer of a video mode as a surface. The VBE
+ *	3.0 linear fields are used when the BIOS fills them in.
+ *
+ *	GFXsurface * surface
+ *		Pointer to a surface structure to initialize.
+ *	VBEmodeInfo * info
+ *		Mode information as returned by 'vbeGetModeInfo'.
+ *	void * bits
+ *		Near pointer to the frame buffer, as from 'vesaLock'.
+ *	returns
+ *		True if the mode is a packed pixel or direct color mode.
+ */
+
+BOOL gfxModeSurface(GFXsurface *surface, VBEmodeInfo *info, void *bits)
+{
+	memset(surface, 0, sizeof(GFXsurface));
+	if(info->MemoryModel != VBE_MODEL_PACKED && info->MemoryModel != VBE_MODEL_RGB)
+	{
+		return FALSE;
+	}
+	surface->Bits          = bits;
+	surface->Width         = info->XResolution;
+	surface->Height        = info->YResolution;
+	surface->BitsPerPixel  = info->BitsPerPixel;
+	surface->BytesPerLine  = info->BytesPerScanLine;
+	if(info->LinearBytesPerScanLine)
+	{
+		surface->BytesPerLine = info->LinearBytesPerScanLine;
+	}
+	if(info->LinearRedMaskSize)
+	{
+		surface->RedMaskSize           = info->LinearRedMaskSize;
+		surface->RedFieldPosition      = info->LinearRedFieldPosition;
+		surface->GreenMaskSize         = info->LinearGreenMaskSize;
+		surface->GreenFieldPosition    = info->LinearGreenFieldPosition;
+		surface->BlueMaskSize          = info->LinearBlueMaskSize;
+		surface->BlueFieldPosition     = info->LinearBlueFieldPosition;
+		surface->ReservedMaskSize      = info->LinearReservedMaskSize;
+		surface->ReservedFieldPosition = info->LinearReservedFieldPosition;
+	}
+	else if(info->RedMaskSize)
+	{
+		surface->RedMaskSize           = info->RedMaskSize;
+		surface->RedFieldPosition      = info->RedFieldPosition;
+		surface->GreenMaskSize         = info->GreenMaskSize;
+		surface->GreenFieldPosition    = info->GreenFieldPosition;
+		surface->BlueMaskSize          = info->BlueMaskSize;
+		surface->BlueFieldPosition     = info->BlueFieldPosition;
+		surface->ReservedMaskSize      = info->ReservedMaskSize;
+		surface->ReservedFieldPosition = info->ReservedFieldPosition;
+	}
+	else
+	{
+		gfxSetLayout(surface);
+	}
+	/* Some BIOSes report 5:5:5 modes as 16 bits per pixel */
+	if(surface->BitsPerPixel == 16 && surface->GreenMaskSize == 5)
+	{
+		surface->BitsPerPixel = 15;
+	}
+	surface->BytesPerPixel = (surface->BitsPerPixel + 7) / 8;
+	gfxSetClipRect(surface, 0, 0, surface->Width - 1, surface->Height - 1);
+	return TRUE;
+}
+
+/*
+ * gfxDestroySurface
+ *
+ *	Releases the pixel memory if it was allocated by 'gfxCreateSurface'.
+ *
+ *	GFXsurface * surface
+ *		Pointer to a surface structure.
+ */
+
+void gfxDestroySurface(GFXsurface *surface)
+{
+	if(surface->Allocated)
+	{
+		free(surface->Bits);
+	}
+	surface->Bits      = NULL;
+	surface->Allocated = FALSE;
+}
+
+/*
+ * gfxSetClipRect
+ *
+ *	Sets the rectangle drawing is restricted to. As with the accelerator
+ *	function the maximum coordinates are inclusive. The rectangle is limited
+ *	to the bounds of the surface.
+ *
+ *	GFXsurface * surface
+ *		Pointer to a surface structure.
+ */
+
+void gfxSetClipRect(GFXsurface *surface, int xmin, int ymin, int xmax, int ymax)
+{
+	surface->ClipLeft   = xmin < 0 ? 0 : xmin;
+	surface->ClipTop    = ymin < 0 ? 0 : ymin;
+	surface->ClipRight  = xmax < surface->Width  ? xmax + 1 : surface->Width;
+	surface->ClipBottom = ymax < surface->Height ? ymax + 1 : surface->Height;
+}
+
+/*
+ * gfxMapRGB
+ *
+ *	GFXsurface * surface
+ *		Pointer to a surface structure.
+ *	int red, green, blue
+ *		Color components in the range 0-255.
+ *	returns
+ *		The pixel value nearest the color in the surface layout.
+ */
+
+unsigned long gfxMapRGB(GFXsurface *surface, int red, int green, int blue)
+{
+	#define FIELD(value, name) \
+		(((unsigned long)(value) >> (8 - surface->name##MaskSize)) << surface->name##FieldPosition)
+	return FIELD(red, Red) | FIELD(green, Green) | FIELD(blue, Blue);
+	#undef FIELD
+}
+
+/*
+ * gfxExpandField
+ *
+ *	Widens a color field of the given size to eight bits, repeating the high
+ *	bits in the low ones so full intensity stays at 255.
+ */
+
+static int gfxExpandField(unsigned long field, int size)
+{
+	int value;
+	if(size <= 0)
+	{
+		return 0;
+	}
+	if(size >= 8)
+	{
+		return (field >> (size - 8)) & 0xFF;
+	}
+	value = (field & ((1 << size) - 1)) << (8 - size);
+	while(size < 8)
+	{
+		value |= value >> size;
+		size  *= 2;
+	}
+	return value & 0xFF;
+}
+
+/*
+ * gfxUnmapRGB
+ *
+ *	GFXsurface * surface
+ *		Pointer to a surface structure.
+ *	unsigned long pixel
+ *		A pixel value in the surface layout.
+ *	int * red, green, blue
+ *		Written with the color components in the range 0-255. The low
+ *		bits are filled by repeating the high bits.
+ */
+
+void gfxUnmapRGB(GFXsurface *surface, unsigned long pixel, int *red, int *green, int *blue)
+{
+	#define FIELD(name) \
+		gfxExpandField(pixel >> surface->name##FieldPosition, surface->name##MaskSize)
+	setsafe(red,   FIELD(Red));
+	setsafe(green, FIELD(Green));
+	setsafe(blue,  FIELD(Blue));
+	#undef FIELD
+}
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ *
+ *	Surface library
+ *
+ *	Describes a block of pixels in system memory or in a linear frame buffer
+ *	so that software drawing code can work on any of the packed pixel and
+ *	direct color formats reported in VBEmodeInfo.
+ *
+ *	Based on the official specification
+ *	http://www.vesa.org/public/VBE/vbe3.pdf
+ */
+
+#ifndef surface_h
+#define surface_h
+
+#include "VGA.h"
+#include "VBE.h"
+
+/*******************************************************************************
+ *
+ *	Surface structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	unsigned char *Bits;		/* First pixel of the first line */
+	int            Width;
+	int            Height;
+	int            BytesPerLine;	/* Distance from one line to the next */
+	int            BitsPerPixel;	/* 8, 15, 16, 24 or 32 */
+	int            BytesPerPixel;	/* 1, 2, 3 or 4 */
+	/* Direct color layout, see VBEmodeInfo */
+	unsigned char  RedMaskSize;
+	unsigned char  RedFieldPosition;
+	unsigned char  GreenMaskSize;
+	unsigned char  GreenFieldPosition;
+	unsigned char  BlueMaskSize;
+	unsigned char  BlueFieldPosition;
+	unsigned char  ReservedMaskSize;
+	unsigned char  ReservedFieldPosition;
+	/* Clip rectangle, right and bottom edges are exclusive */
+	int            ClipLeft;
+	int            ClipTop;
+	int            ClipRight;
+	int            ClipBottom;
+	/* Bits were allocated by gfxCreateSurface */
+	BOOL           Allocated;
+
+} GFXsurface;
+
+/*******************************************************************************
+ *
+ *	Surface functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreateSurface(GFXsurface *surface, int width, int height, int bitsPerPixel);
+
+BOOL gfxModeSurface(GFXsurface *surface, VBEmodeInfo *info, void *bits);
+
+void gfxDestroySurface(GFXsurface *surface);
+
+void gfxSetClipRect(GFXsurface *surface, int xmin, int ymin, int xmax, int ymax);
+
+unsigned long gfxMapRGB(GFXsurface *surface, int red, int green, int blue);
+
+void gfxUnmapRGB(GFXsurface *surface, unsigned long pixel, int *red, int *green, int *blue);
+
+
+#endif /* surface_h */
@@ -0,0 +1,330 @@
+/*******************************************************************************
+ *
+ *	Texture library
+ *
+ *	Maps power of two textures onto spans. Texture coordinates are planes
+ *	over the screen set up from three vertices, stepped per pixel in 16.16
+ *	fixed point. Perspective correct mapping steps u/z, v/z and 1/z instead
+ *	and divides only every few pixels, mapping linearly in between.
+ *
+ *	Textures hold pixels in the layout of the target, palette indices for 8
+ *	bit surfaces or direct color otherwise, so texels are copied unchanged.
+ *	The span functions fit a GFXspanWriter and spans can also be given as
+ *	lists, in the same form as 'gfxDrawScanList'.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "intern.h"
+#include "raster.h"
+#include "texture.h"
+
+/*******************************************************************************
+ *
+ *	Span mapping
+ *
+ ******************************************************************************/
+
+/*
+ * gfxMap
+ *
+ *	The inner loop. Texture coordinates are stepped in 16.16 fixed point and
+ *	wrapped by masking, so they may run off either side of the texture.
+ */
+
+#define GFX_MAP(name, bytes) \
+static void name(unsigned char *pixel, int count, GFXtexture *texture, unsigned long u, unsigned long v, long du, long dv) \
+{ \
+	const unsigned char *texels = texture->Bits; \
+	unsigned long uMask = texture->WidthMask, vMask = texture->HeightMask; \
+	int shift = texture->WidthShift; \
+	for(; count > 0; count --, pixel += bytes) \
+	{ \
+		const unsigned char *texel = texels + (((((v >> 16) & vMask) << shift) | ((u >> 16) & uMask)) * bytes); \
+		GFX_PUT_##bytes(pixel, GFX_GET_##bytes(texel)); \
+		u += du; \
+		v += dv; \
+	} \
+}
+
+GFX_MAP(gfxMap1, 1)
+GFX_MAP(gfxMap2, 2)
+GFX_MAP(gfxMap3, 3)
+GFX_MAP(gfxMap4, 4)
+
+static void (*Maps[5])(unsigned char *pixel, int count, GFXtexture *texture, unsigned long u, unsigned long v, long du, long dv) =
+{
+	NULL, gfxMap1, gfxMap2, gfxMap3, gfxMap4
+};
+
+/*
+ * gfxMapPerspective
+ *
+ *	Finds the true texture coordinates at the ends of each run of pixels
+ *	and maps linearly between them. Only the last run of a span can be
+ *	short, and only it needs an integer divide for the steps.
+ */
+
+static void gfxMapPerspective(GFXmapper *mapper, unsigned char *pixel, int count, float uz, float vz, float iz)
+{
+	void (*map)(unsigned char *, int, GFXtexture *, unsigned long, unsigned long, long, long) = Maps[ mapper->Surface->BytesPerPixel ];
+	int bytes = mapper->Surface->BytesPerPixel;
+	int length = 1 << mapper->Subdivide;
+	float z = 1.0f / iz;
+	long u = (long)(uz * z * 65536.0f), v = (long)(vz * z * 65536.0f);
+	long uEnd, vEnd, du, dv;
+	int run;
+	while(count > 0)
+	{
+		run = min(count, length);
+		uz += mapper->UZX * run;
+		vz += mapper->VZX * run;
+		iz += mapper->IZX * run;
+		z    = 1.0f / iz;
+		uEnd = (long)(uz * z * 65536.0f);
+		vEnd = (long)(vz * z * 65536.0f);
+		if(run == length)
+		{
+			du = (uEnd - u) >> mapper->Subdivide;
+			dv = (vEnd - v) >> mapper->Subdivide;
+		}
+		else
+		{
+			du = (uEnd - u) / run;
+			dv = (vEnd - v) / run;
+		}
+		map(pixel, run, mapper->Texture, u, v, du, dv);
+		pixel += run * bytes;
+		count -= run;
+		u = uEnd;
+		v = vEnd;
+	}
+}
+
+/*******************************************************************************
+ *
+ *	Texture functions
+ *
+ ******************************************************************************/
+
+static int gfxLog2(int value)
+{
+	int shift = 0;
+	if(value <= 0 || (value & (value - 1)))
+	{
+		return -1;
+	}
+	while((1 << shift) < value)
+	{
+		shift ++;
+	}
+	return shift;
+}
+
+/*
+ * gfxCreateTexture
+ *
+ *	Uses a surface as a texture. The texture shares the pixels of the
+ *	surface.
+ *
+ *	GFXtexture * texture
+ *		Pointer to a texture structure to fill in.
+ *	GFXsurface * image
+ *		The texels, in the pixel layout of the surfaces the texture will be
+ *		drawn on. The width and height must be powers of two and the lines
+ *		must follow each other with no gap.
+ *	returns
+ *		True if the surface can be used as a texture.
+ */
+
+BOOL gfxCreateTexture(GFXtexture *texture, GFXsurface *image)
+{
+	int shift = gfxLog2(image->Width);
+	if(shift < 0 || gfxLog2(image->Height) < 0 || image->BytesPerLine != image->Width * image->BytesPerPixel)
+	{
+		return FALSE;
+	}
+	texture->Bits          = image->Bits;
+	texture->WidthShift    = shift;
+	texture->WidthMask     = image->Width - 1;
+	texture->HeightMask    = image->Height - 1;
+	texture->BytesPerPixel = image->BytesPerPixel;
+	return TRUE;
+}
+
+/*
+ * gfxSetupMapper
+ *
+ *	Finds the planes of the texture coordinates over the screen from three
+ *	vertices. This is the only place that divides by the area.
+ *
+ *	GFXmapper * mapper
+ *		Pointer to a mapper structure to fill in.
+ *	GFXsurface * surface
+ *		Surface to draw on.
+ *	GFXtexture * texture
+ *		Texture with the same pixel size as the surface.
+ *	GFXtexPoint * v1, v2, v3
+ *		Three vertices on the plane of the texture.
+ *	int flags
+ *		How to map.
+ *			GFX_TEXTURE_AFFINE
+ *			GFX_TEXTURE_PERSPECTIVE
+ *	returns
+ *		False if the vertices are in a line, are behind the eye for
+ *		perspective mapping or the pixel sizes differ.
+ */
+
+BOOL gfxSetupMapper(GFXmapper *mapper, GFXsurface *surface, GFXtexture *texture, GFXtexPoint *v1, GFXtexPoint *v2, GFXtexPoint *v3, int flags)
+{
+	double x1 = v1->X / 65536.0, y1 = v1->Y / 65536.0;
+	double dx1 = (v2->X - v1->X) / 65536.0, dy1 = (v2->Y - v1->Y) / 65536.0;
+	double dx2 = (v3->X - v1->X) / 65536.0, dy2 = (v3->Y - v1->Y) / 65536.0;
+	double det = dx1 * dy2 - dx2 * dy1;
+	double ox, oy, a1, a2, a3, stepX, stepY;
+	memset(mapper, 0, sizeof(GFXmapper));
+	mapper->Surface   = surface;
+	mapper->Texture   = texture;
+	mapper->Flags     = flags;
+	mapper->Subdivide = GFX_TEXTURE_SUBDIVIDE;
+	if(det == 0.0 || texture->BytesPerPixel != surface->BytesPerPixel)
+	{
+		return FALSE;
+	}
+	mapper->OriginX = (int)floor(x1 + 0.5);
+	mapper->OriginY = (int)floor(y1 + 0.5);
+	ox = mapper->OriginX - x1;
+	oy = mapper->OriginY - y1;
+	/* Value at the origin and steps of the plane through a1, a2, a3 */
+	#define PLANE(value, x, y) \
+		stepX = ((a2 - a1) * dy2 - (a3 - a1) * dy1) / det; \
+		stepY = ((a3 - a1) * dx1 - (a2 - a1) * dx2) / det; \
+		mapper->value = a1 + stepX * ox + stepY * oy; \
+		mapper->x     = stepX; \
+		mapper->y     = stepY;
+	if(flags & GFX_TEXTURE_PERSPECTIVE)
+	{
+		if(v1->Z <= 0 || v2->Z <= 0 || v3->Z <= 0)
+		{
+			return FALSE;
+		}
+		a1 = v1->U / 65536.0 / v1->Z; a2 = v2->U / 65536.0 / v2->Z; a3 = v3->U / 65536.0 / v3->Z;
+		PLANE(UZ, UZX, UZY);
+		a1 = v1->V / 65536.0 / v1->Z; a2 = v2->V / 65536.0 / v2->Z; a3 = v3->V / 65536.0 / v3->Z;
+		PLANE(VZ, VZX, VZY);
+		a1 = 1.0 / v1->Z; a2 = 1.0 / v2->Z; a3 = 1.0 / v3->Z;
+		PLANE(IZ, IZX, IZY);
+	}
+	else
+	{
+		a1 = v1->U; a2 = v2->U; a3 = v3->U;
+		PLANE(U, UX, UY);
+		a1 = v1->V; a2 = v2->V; a3 = v3->V;
+		PLANE(V, VX, VY);
+	}
+	#undef PLANE
+	return TRUE;
+}
+
+/*
+ * gfxTextureSpan
+ *
+ *	Span function for a GFXspanWriter, with the mapper as its context. The
+ *	span must already be clipped.
+ */
+
+void gfxTextureSpan(void *context, int y, int x1, int x2)
+{
+	GFXmapper *mapper = context;
+	GFXsurface *surface = mapper->Surface;
+	int dx = x1 - mapper->OriginX, dy = y - mapper->OriginY;
+	unsigned char *pixel = surface->Bits + y * surface->BytesPerLine + x1 * surface->BytesPerPixel;
+	if(x2 <= x1)
+	{
+		return;
+	}
+	if(mapper->Flags & GFX_TEXTURE_PERSPECTIVE)
+	{
+		gfxMapPerspective(mapper, pixel, x2 - x1,
+		                  mapper->UZ + mapper->UZX * dx + mapper->UZY * dy,
+		                  mapper->VZ + mapper->VZX * dx + mapper->VZY * dy,
+		                  mapper->IZ + mapper->IZX * dx + mapper->IZY * dy);
+	}
+	else
+	{
+		/* Unsigned so coordinates far off the texture wrap instead of overflowing */
+		Maps[ surface->BytesPerPixel ](pixel, x2 - x1, mapper->Texture,
+		                               (unsigned long)mapper->U + (unsigned long)mapper->UX * dx + (unsigned long)mapper->UY * dy,
+		                               (unsigned long)mapper->V + (unsigned long)mapper->VX * dx + (unsigned long)mapper->VY * dy,
+		                               mapper->UX, mapper->VX);
+	}
+}
+
+/*
+ * gfxTextureScanList
+ *
+ *	Maps a list of spans on consecutive lines, clipped to the surface.
+ *
+ *	GFXmapper * mapper
+ *		Pointer to a mapper set up by 'gfxSetupMapper'.
+ *	int y
+ *		Line of the first span.
+ *	int length
+ *		Number of spans.
+ *	short * scans
+ *		Pairs of ends, in either order, the greater one not drawn.
+ */
+
+void gfxTextureScanList(GFXmapper *mapper, int y, int length, short *scans)
+{
+	GFXsurface *surface = mapper->Surface;
+	int index, x1, x2, swap;
+	for(index = 0; index < length; index ++, y ++)
+	{
+		if(y < surface->ClipTop || y >= surface->ClipBottom)
+		{
+			continue;
+		}
+		x1 = scans[ index * 2 ];
+		x2 = scans[ index * 2 + 1 ];
+		if(x2 < x1)
+		{
+			swap = x1;
+			x1   = x2;
+			x2   = swap;
+		}
+		gfxTextureSpan(mapper, y, max(x1, surface->ClipLeft), min(x2, surface->ClipRight));
+	}
+}
+
+/*
+ * gfxDrawTexturedTri
+ *
+ *	Draws a textured triangle, covering the same pixels as 'gfxDrawTri'.
+ *
+ *	GFXsurface * surface
+ *		Pointer to the surface to draw on.
+ *	GFXtexture * texture
+ *		Texture with the same pixel size as the surface.
+ *	GFXtexPoint * v1, v2, v3
+ *		The vertices.
+ *	int flags
+ *		As for 'gfxSetupMapper'.
+ */
+
+void gfxDrawTexturedTri(GFXsurface *surface, GFXtexture *texture, GFXtexPoint *v1, GFXtexPoint *v2, GFXtexPoint *v3, int flags)
+{
+	GFXmapper mapper;
+	GFXspanWriter writer;
+	GFXfxpoint p1, p2, p3;
+	if(!gfxSetupMapper(&mapper, surface, texture, v1, v2, v3, flags))
+	{
+		return;
+	}
+	p1.X = v1->X; p1.Y = v1->Y;
+	p2.X = v2->X; p2.Y = v2->Y;
+	p3.X = v3->X; p3.Y = v3->Y;
+	gfxSpanWriter(&writer, surface, gfxTextureSpan, &mapper);
+	gfxScanTri(&writer, &p1, &p2, &p3, 0, 0);
+}
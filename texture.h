@@ -0,0 +1,95 @@
+/*******************************************************************************
+ *
+ *	Texture library
+ *
+ *	Maps power of two textures onto spans. Texture coordinates are planes
+ *	over the screen set up from three vertices, stepped per pixel in 16.16
+ *	fixed point. Perspective correct mapping steps u/z, v/z and 1/z instead
+ *	and divides only every few pixels, mapping linearly in between.
+ *
+ *	Textures hold pixels in the layout of the target, palette indices for 8
+ *	bit surfaces or direct color otherwise, so texels are copied unchanged.
+ *	The span functions fit a GFXspanWriter and spans can also be given as
+ *	lists, in the same form as 'gfxDrawScanList'.
+ */
+
+#ifndef texture_h
+#define texture_h
+
+#include "VGA.h"
+#include "surface.h"
+#include "polygon.h"
+
+/*******************************************************************************
+ *
+ *	Texture flags
+ *
+ ******************************************************************************/
+
+#define GFX_TEXTURE_AFFINE			0x00	/* Interpolate texture coordinates linearly */
+#define GFX_TEXTURE_PERSPECTIVE			0x01	/* Correct for depth */
+
+#define GFX_TEXTURE_SUBDIVIDE			4	/* Log2 of pixels between divides */
+
+/*******************************************************************************
+ *
+ *	Texture structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	unsigned char *Bits;
+	int            WidthShift;		/* Log2 of the width */
+	int            WidthMask;		/* Width less one */
+	int            HeightMask;		/* Height less one */
+	int            BytesPerPixel;
+
+} GFXtexture;
+
+typedef struct
+{
+	long  X;				/* 16.16 fixed point screen position */
+	long  Y;
+	long  U;				/* 16.16 fixed point texel position */
+	long  V;
+	float Z;				/* Depth, greater than 0, for perspective mapping */
+
+} GFXtexPoint;
+
+typedef struct
+{
+	GFXsurface *Surface;
+	GFXtexture *Texture;
+	int         Flags;
+	int         Subdivide;		/* Log2 of pixels between divides */
+	int         OriginX;		/* Pixel the planes are given at */
+	int         OriginY;
+	/* Affine planes, 16.16 fixed point */
+	long        U, UX, UY;
+	long        V, VX, VY;
+	/* Perspective planes of u/z, v/z and 1/z */
+	float       UZ, UZX, UZY;
+	float       VZ, VZX, VZY;
+	float       IZ, IZX, IZY;
+
+} GFXmapper;
+
+/*******************************************************************************
+ *
+ *	Texture functions
+ *
+ ******************************************************************************/
+
+BOOL gfxCreateTexture(GFXtexture *texture, GFXsurface *image);
+
+BOOL gfxSetupMapper(GFXmapper *mapper, GFXsurface *surface, GFXtexture *texture, GFXtexPoint *v1, GFXtexPoint *v2, GFXtexPoint *v3, int flags);
+
+void gfxTextureSpan(void *mapper, int y, int x1, int x2);
+
+void gfxTextureScanList(GFXmapper *mapper, int y, int length, short *scans);
+
+void gfxDrawTexturedTri(GFXsurface *surface, GFXtexture *texture, GFXtexPoint *v1, GFXtexPoint *v2, GFXtexPoint *v3, int flags);
+
+
+#endif /* texture_h */
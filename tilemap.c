@@ -0,0 +1,398 @@
+/*******************************************************************************
+ *
+ *	Tile map library
+ *
+ *	Draws a grid of tiles into a surface larger than the view and pans the
+ *	display across it, so scrolling within a tile is free and crossing a
+ *	tile edge draws only the row or column of tiles it exposes. Changed
+ *	cells are marked in a bitmap and only those in view are drawn, so a
+ *	steady frame costs about as many tile copies as tiles that changed.
+ *	Panning goes through the VGA start address and pixel panning registers
+ *	or the VBE display start.
+ *
+ *	The target holds a window of cells one larger than the view each way.
+ *	Scrolling moves the window through the target by whole tiles, and what
+ *	is already drawn in it stays where it is. When the window would leave
+ *	the target it starts again at the far side and is drawn afresh, so a
+ *	target twice the view in each direction draws everything about once per
+ *	view of travel.
+ */
+
+#include <stdlib.h>
+
+#include "farseg.h"
+#include "intern.h"
+#include "blit.h"
+#include "VGAio.h"
+#include "tilemap.h"
+
+/*
+ * gfxInitTileset
+ *
+ *	GFXtileset * tileset
+ *		Pointer to a tileset structure to initialize.
+ *	GFXsurface * surface
+ *		Surface holding the tiles left to right, top to bottom, with the
+ *		pixel size of the target. It may be the target itself, with the
+ *		tiles outside the area the map is drawn in.
+ *	int tileWidth, tileHeight
+ *		Size of a tile in pixels.
+ */
+
+void gfxInitTileset(GFXtileset *tileset, GFXsurface *surface, int tileWidth, int tileHeight)
+{
+	tileset->Surface    = surface;
+	tileset->TileWidth  = tileWidth;
+	tileset->TileHeight = tileHeight;
+	tileset->Columns    = surface->Width / tileWidth;
+	tileset->Count      = tileset->Columns * (surface->Height / tileHeight);
+}
+
+/*
+ * gfxCreateTileMap
+ *
+ *	Makes a map of tile 0 everywhere, with nothing drawn yet.
+ *
+ *	GFXtilemap * map
+ *		Pointer to a tile map structure to initialize.
+ *	GFXtileset * tileset
+ *		The tiles, kept for the life of the map.
+ *	int columns, rows
+ *		Size of the map in cells.
+ *	GFXsurface * target
+ *		Surface to draw in. For hardware panning it covers display memory
+ *		from the start of the page, and must hold a tile more than the
+ *		view each way, better still twice the view.
+ *	int viewWidth, viewHeight
+ *		Size of the display in pixels, at most the size of the map.
+ *	int pan
+ *		How the view is moved to show the map.
+ *			GFX_PAN_NONE
+ *			GFX_PAN_VGA, 8 bpp only
+ *			GFX_PAN_VBE
+ *	returns
+ *		True if the target is large enough and the map allocated.
+ */
+
+BOOL gfxCreateTileMap(GFXtilemap *map, GFXtileset *tileset, int columns, int rows, GFXsurface *target, int viewWidth, int viewHeight, int pan)
+{
+	int width  = tileset->TileWidth;
+	int height = tileset->TileHeight;
+	map->Tileset       = tileset;
+	map->Columns       = columns;
+	map->Rows          = rows;
+	map->DirtyPitch    = (columns + 31) / 32;
+	map->Target        = target;
+	map->ViewWidth     = viewWidth;
+	map->ViewHeight    = viewHeight;
+	map->ScrollX       = 0;
+	map->ScrollY       = 0;
+	map->DisplayX      = 0;
+	map->DisplayY      = 0;
+	map->Pan           = pan;
+	map->Port          = vgaIsColorMode() ? VGA_COLOR_INPUT_STATUS_1 : VGA_MONO_INPUT_STATUS_1;
+	map->WindowColumns = min(columns, (viewWidth + width - 1) / width + 1);
+	map->WindowRows    = min(rows, (viewHeight + height - 1) / height + 1);
+	map->WindowColumn  = -1;
+	map->WindowRow     = -1;
+	map->WindowX       = 0;
+	map->WindowY       = 0;
+	map->Cells         = NULL;
+	map->Dirty         = NULL;
+	if(viewWidth > columns * width || viewHeight > rows * height ||
+	   target->BytesPerPixel != tileset->Surface->BytesPerPixel ||
+	   (pan == GFX_PAN_VGA && target->BytesPerPixel != 1) ||
+	   target->Width < map->WindowColumns * width || target->Height < map->WindowRows * height)
+	{
+		return FALSE;
+	}
+	if(pan == GFX_PAN_VGA)
+	{
+		vgaResolveCRTCAddresses();
+	}
+	map->Cells = calloc(columns * rows, sizeof(unsigned short));
+	map->Dirty = calloc(map->DirtyPitch * rows, sizeof(unsigned long));
+	if(!map->Cells || !map->Dirty)
+	{
+		gfxDestroyTileMap(map);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * gfxDestroyTileMap
+ */
+
+void gfxDestroyTileMap(GFXtilemap *map)
+{
+	free(map->Cells);
+	free(map->Dirty);
+	map->Cells = NULL;
+	map->Dirty = NULL;
+}
+
+/*
+ * gfxSetTile
+ *
+ *	Puts a tile in a cell, marking the cell for drawing if it changed.
+ *
+ *	GFXtilemap * map
+ *		Pointer to the map.
+ *	int column, row
+ *		The cell.
+ *	int tile
+ *		Index of the tile in the tileset.
+ */
+
+void gfxSetTile(GFXtilemap *map, int column, int row, int tile)
+{
+	unsigned short *cell;
+	if(column < 0 || row < 0 || column >= map->Columns || row >= map->Rows)
+	{
+		return;
+	}
+	cell = &map->Cells[ row * map->Columns + column ];
+	if(*cell != tile)
+	{
+		*cell = (unsigned short)tile;
+		map->Dirty[ row * map->DirtyPitch + column / 32 ] |= 1UL << (column & 31);
+	}
+}
+
+/*
+ * gfxGetTile
+ *
+ *	returns
+ *		Index of the tile in a cell, -1 outside the map.
+ */
+
+int gfxGetTile(GFXtilemap *map, int column, int row)
+{
+	if(column < 0 || row < 0 || column >= map->Columns || row >= map->Rows)
+	{
+		return -1;
+	}
+	return map->Cells[ row * map->Columns + column ];
+}
+
+/*
+ * gfxInvalidateTileMap
+ *
+ *	Has the next frame draw every cell in view, after the tileset or the
+ *	target changed behind the map's back.
+ */
+
+void gfxInvalidateTileMap(GFXtilemap *map)
+{
+	map->WindowColumn = -1;
+	map->WindowRow    = -1;
+}
+
+/*
+ * gfxScrollTileMap
+ *
+ *	Sets the map pixel shown at the top left of the view, kept within the
+ *	map. Nothing is drawn until 'gfxDrawTileMap'.
+ */
+
+void gfxScrollTileMap(GFXtilemap *map, int x, int y)
+{
+	map->ScrollX = max(0, min(x, map->Columns * map->Tileset->TileWidth - map->ViewWidth));
+	map->ScrollY = max(0, min(y, map->Rows * map->Tileset->TileHeight - map->ViewHeight));
+}
+
+/*
+ * gfxDrawCells
+ *
+ *	Draws cells of one row of the window, either all of them or only those
+ *	marked, and clears their marks. Unmarked dwords are passed over whole.
+ *	Each run of cells drawn side by side is added to the dirty list as one
+ *	rectangle.
+ *
+ *	int line
+ *		Row within the window.
+ *	int first, last
+ *		Columns within the window, 'last' exclusive.
+ *	BOOL all
+ *		Draw marked and unmarked cells alike.
+ *	returns
+ *		The number of tiles drawn.
+ */
+
+static int gfxDrawCells(GFXtilemap *map, int line, int first, int last, BOOL all, GFXdirty *dirty)
+{
+	GFXtileset *tileset = map->Tileset;
+	int width  = tileset->TileWidth;
+	int height = tileset->TileHeight;
+	int row    = map->WindowRow + line;
+	int top    = map->WindowY + line * height;
+	int drawn  = 0, start = -1;
+	int column, tile, cell;
+	unsigned long *bits;
+	last = min(last, map->Columns - map->WindowColumn);
+	for(cell = first; cell < last; cell ++)
+	{
+		column = map->WindowColumn + cell;
+		bits   = &map->Dirty[ row * map->DirtyPitch + column / 32 ];
+		if(!all && !(*bits & (1UL << (column & 31))))
+		{
+			if(start >= 0 && dirty)
+			{
+				gfxAddDirty(dirty, map->WindowX + start * width, top, map->WindowX + cell * width - 1, top + height - 1);
+			}
+			start = -1;
+			if(!*bits)
+			{
+				/* Rest of the dword */
+				cell += 31 - (column & 31);
+			}
+			continue;
+		}
+		*bits &= ~(1UL << (column & 31));
+		tile   = map->Cells[ row * map->Columns + column ];
+		if(tile < tileset->Count)
+		{
+			gfxBitBltLinear(map->Target, tileset->Surface,
+			                (tile % tileset->Columns) * width, (tile / tileset->Columns) * height, width, height,
+			                map->WindowX + cell * width, top, GFX_MIX_REPLACE);
+		}
+		if(start < 0)
+		{
+			start = cell;
+		}
+		drawn ++;
+	}
+	if(start >= 0 && dirty)
+	{
+		gfxAddDirty(dirty, map->WindowX + start * width, top, map->WindowX + cell * width - 1, top + height - 1);
+	}
+	return drawn;
+}
+
+/*
+ * gfxPanTileMap
+ *
+ *	Shows the target from DisplayX, DisplayY. The VGA path is for 256 color
+ *	modes only, where the start address counts dwords and the pixels left
+ *	over go in the pixel panning register. The CRTC takes the start address
+ *	at the start of vertical retrace but the attribute controller takes the
+ *	panning at once, so the address is written while the frame is still
+ *	being drawn and the panning once retrace has begun, or the two would
+ *	show on different frames.
+ */
+
+static void gfxPanTileMap(GFXtilemap *map)
+{
+	long address;
+	switch(map->Pan)
+	{
+	case GFX_PAN_VGA:
+		address = (long)map->DisplayY * map->Target->BytesPerLine + map->DisplayX * map->Target->BytesPerPixel;
+		while(inportb(map->Port) & VGA_VERTICAL_RETRACE_BIT);
+		vgaSetStartAddress((int)(address >> 2));
+		while(!(inportb(map->Port) & VGA_VERTICAL_RETRACE_BIT));
+		vgaSetPixelPanning((int)(address & 3) * 2);
+		break;
+	case GFX_PAN_VBE:
+		if(!vbeSetDisplayStartOnSync(map->DisplayX, map->DisplayY))
+		{
+			vbeSetDisplayStart(map->DisplayX, map->DisplayY);
+		}
+		break;
+	}
+}
+
+/*
+ * gfxDrawTileMap
+ *
+ *	Brings the target up to date with the map and the scroll position, then
+ *	pans the display to it. Cells that came into view are drawn, and of the
+ *	rest only those changed since the last frame.
+ *
+ *	GFXtilemap * map
+ *		Pointer to the map.
+ *	GFXdirty * dirty
+ *		Receives the rectangles drawn in target coordinates, for
+ *		presenting a back buffer, or NULL.
+ *	returns
+ *		The number of tiles drawn.
+ */
+
+int gfxDrawTileMap(GFXtilemap *map, GFXdirty *dirty)
+{
+	int width   = map->Tileset->TileWidth;
+	int height  = map->Tileset->TileHeight;
+	int column  = map->ScrollX / width;
+	int row     = map->ScrollY / height;
+	int right   = map->Target->Width - map->WindowColumns * width;
+	int bottom  = map->Target->Height - map->WindowRows * height;
+	int across  = column - map->WindowColumn;
+	int down    = row - map->WindowRow;
+	int x       = map->WindowX + across * width;
+	int y       = map->WindowY + down * height;
+	int first   = 0, last = 0, top = 0, end = 0;
+	int drawn   = 0, line;
+	if(map->WindowColumn < 0)
+	{
+		x   = 0;
+		y   = 0;
+		end = map->WindowRows;
+	}
+	else if(x < 0 || y < 0 || x > right || y > bottom ||
+	        abs(across) >= map->WindowColumns || abs(down) >= map->WindowRows)
+	{
+		/* Start again at the far side */
+		if(x < 0 || x > right)
+		{
+			x = across > 0 ? 0 : right;
+		}
+		if(y < 0 || y > bottom)
+		{
+			y = down > 0 ? 0 : bottom;
+		}
+		end = map->WindowRows;
+	}
+	else
+	{
+		/* The cells that came into view */
+		if(across > 0)
+		{
+			first = map->WindowColumns - across;
+			last  = map->WindowColumns;
+		}
+		else
+		{
+			last  = -across;
+		}
+		if(down > 0)
+		{
+			top = map->WindowRows - down;
+			end = map->WindowRows;
+		}
+		else
+		{
+			end = -down;
+		}
+	}
+	map->WindowColumn = column;
+	map->WindowRow    = row;
+	map->WindowX      = x;
+	map->WindowY      = y;
+	for(line = 0; line < map->WindowRows && row + line < map->Rows; line ++)
+	{
+		if(line >= top && line < end)
+		{
+			drawn += gfxDrawCells(map, line, 0, map->WindowColumns, TRUE, dirty);
+		}
+		else
+		{
+			drawn += gfxDrawCells(map, line, first, last, TRUE, dirty);
+			drawn += gfxDrawCells(map, line, 0, map->WindowColumns, FALSE, dirty);
+		}
+	}
+	map->DisplayX = x + map->ScrollX - column * width;
+	map->DisplayY = y + map->ScrollY - row * height;
+	gfxPanTileMap(map);
+	return drawn;
+}
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ *
+ *	Tile map library
+ *
+ *	Draws a grid of tiles into a surface larger than the view and pans the
+ *	display across it, so scrolling within a tile is free and crossing a
+ *	tile edge draws only the row or column of tiles it exposes. Changed
+ *	cells are marked in a bitmap and only those in view are drawn, so a
+ *	steady frame costs about as many tile copies as tiles that changed.
+ *	Panning goes through the VGA start address and pixel panning registers
+ *	or the VBE display start.
+ */
+
+#ifndef tilemap_h
+#define tilemap_h
+
+#include "VGA.h"
+#include "surface.h"
+#include "region.h"
+
+/*******************************************************************************
+ *
+ *	Tile map flags
+ *
+ ******************************************************************************/
+
+/* How the view is shown */
+
+#define GFX_PAN_NONE				0	/* Left to the caller, from DisplayX and DisplayY */
+#define GFX_PAN_VGA				1	/* CRTC start address and pixel panning, 8 bpp in the first 256K */
+#define GFX_PAN_VBE				2	/* VBE display start, on vertical retrace if supported */
+
+/*******************************************************************************
+ *
+ *	Tile map structures
+ *
+ ******************************************************************************/
+
+typedef struct
+{
+	GFXsurface *Surface;			/* Tiles side by side, in system or video memory */
+	int         TileWidth;
+	int         TileHeight;
+	int         Columns;			/* Tiles across the surface */
+	int         Count;
+
+} GFXtileset;
+
+typedef struct
+{
+	GFXtileset     *Tileset;
+	unsigned short *Cells;			/* Tile of each cell, row after row */
+	unsigned long  *Dirty;			/* Bit of each changed cell, rows padded to dwords */
+	int             Columns;
+	int             Rows;
+	int             DirtyPitch;		/* Dwords of 'Dirty' per row */
+	/* View */
+	GFXsurface     *Target;			/* Frame buffer or back buffer drawn in */
+	int             ViewWidth;
+	int             ViewHeight;
+	int             ScrollX;		/* Map pixel at the top left of the view */
+	int             ScrollY;
+	int             DisplayX;		/* Target pixel at the top left of the view */
+	int             DisplayY;
+	int             Pan;			/* GFX_PAN_x */
+	int             Port;			/* Input status 1, for GFX_PAN_VGA */
+	/* Cells held in the target */
+	int             WindowColumns;
+	int             WindowRows;
+	int             WindowColumn;		/* Map cell at the top left, -1 for none drawn */
+	int             WindowRow;
+	int             WindowX;		/* Target pixel of that cell */
+	int             WindowY;
+
+} GFXtilemap;
+
+/*******************************************************************************
+ *
+ *	Tile map functions
+ *
+ ******************************************************************************/
+
+void gfxInitTileset(GFXtileset *tileset, GFXsurface *surface, int tileWidth, int tileHeight);
+
+BOOL gfxCreateTileMap(GFXtilemap *map, GFXtileset *tileset, int columns, int rows, GFXsurface *target, int viewWidth, int viewHeight, int pan);
+
+void gfxDestroyTileMap(GFXtilemap *map);
+
+void gfxSetTile(GFXtilemap *map, int column, int row, int tile);
+
+int gfxGetTile(GFXtilemap *map, int column, int row);
+
+void gfxInvalidateTileMap(GFXtilemap *map);
+
+void gfxScrollTileMap(GFXtilemap *map, int x, int y);
+
+int gfxDrawTileMap(GFXtilemap *map, GFXdirty *dirty);
+
+
+#endif /* tilemap_h */
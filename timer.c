@@ -0,0 +1,420 @@
+/*******************************************************************************
+ *
+ *	Timer library
+ *
+ *	Runs channel 0 of the PIT faster than the 18.2 Hz BIOS tick, still
+ *	passing the BIOS handler every 65536 counts so the time of day keeps
+ *	right. The time stamp counter is calibrated against the timer to give
+ *	monotonic microsecond timestamps, and callbacks can be run once after a
+ *	delay or periodically, to the resolution of the timer.
+ *
+ *	Additional information provided by Roger Morgan
+ *	http://www.htl-steyr.ac.at/~morg/pcinfo/hardware/interrupts/inte1at0.htm
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "farseg.h"
+#include "intern.h"
+#include "timer.h"
+#include "PIT.h"
+
+typedef struct
+{
+	TMRcallback        Callback;
+	void              *Data;
+	unsigned long long Due;			/* Time stamp counter value to run at */
+	unsigned long long Period;		/* Time stamp counter ticks, 0 to run once */
+	BOOL               Armed;
+
+} TMRslot;
+
+/* Everything the interrupt handler touches, locked as one block */
+
+static struct
+{
+	unsigned long          Count;		/* PIT counts per interrupt */
+	unsigned long          Elapsed;		/* PIT counts since the BIOS handler last ran, until calibrated */
+	volatile unsigned long Ticks;		/* Interrupts since install */
+	unsigned long long     Scale;		/* Time stamp counter ticks per microsecond, 16.16 */
+	unsigned long long     BiosPeriod;	/* Time stamp counter ticks per BIOS tick, 0 until calibrated */
+	unsigned long long     BiosDue;		/* Time stamp counter value of the next BIOS tick */
+	BOOL                   Running;		/* Callbacks are being run */
+	TMRslot                Slots[TMR_CALLBACKS];
+	struct
+	{
+		unsigned long  Offset;
+		unsigned short Selector;
+
+	} __attribute__((packed)) Chain;	/* Far address of the previous handler */
+
+} Timer;
+
+static _go32_dpmi_seginfo OldHandler, NewHandler;
+
+static BOOL Installed = FALSE;
+
+static unsigned long long Frequency;		/* Time stamp counter ticks per second */
+static unsigned long long Base;			/* Time stamp counter at microsecond 0 */
+
+/*******************************************************************************
+ *
+ *	Timer interrupt
+ *
+ ******************************************************************************/
+
+/*
+ * tmrRearm
+ *
+ *	Runs a callback once more after a delay. Safe to call from callbacks,
+ *	which is how a one shot callback schedules its next run.
+ *
+ *	int handle
+ *		As returned by 'tmrAddDeadline' or 'tmrAddPeriodic'.
+ *	long delay
+ *		Microseconds from now.
+ */
+
+void tmrRearm(int handle, long delay)
+{
+	unsigned long long now;
+	if(handle < 0 || handle >= TMR_CALLBACKS)
+	{
+		return;
+	}
+	rdtsc(now);
+	/* No division here, the handler calls this from locked code */
+	Timer.Slots[ handle ].Due   = now + (((unsigned long long)delay * Timer.Scale) >> 16);
+	Timer.Slots[ handle ].Armed = TRUE;
+}
+
+/*
+ * tmrMicroseconds
+ *
+ *	Locked with the handler, so callbacks may call it.
+ *
+ *	returns
+ *		Microseconds since the timer was installed, 0 if it is not.
+ */
+
+unsigned long long tmrMicroseconds()
+{
+	unsigned long long now;
+	if(!Installed)
+	{
+		return 0;
+	}
+	rdtsc(now);
+	now -= Base;
+	/* Split to keep the product from overflowing */
+	return now / Frequency * 1000000 + now % Frequency * 1000000 / Frequency;
+}
+
+/*
+ * tmrInterrupt
+ *
+ *	Passes the tick on to the BIOS handler once a BIOS tick has gone by, or
+ *	acknowledges it, then runs the callbacks that are due with interrupts
+ *	enabled. A slow callback then holds off neither the keyboard and mouse
+ *	nor further ticks, which find the callbacks running and only count.
+ *	Once calibrated the BIOS ticks are timed by the time stamp counter, so
+ *	the time of day keeps right even if a tick is lost.
+ */
+
+static void tmrInterrupt(void)
+{
+	unsigned long long now;
+	BOOL chain;
+	int index;
+	Timer.Ticks ++;
+	rdtsc(now);
+	if(Timer.BiosPeriod)
+	{
+		chain = now >= Timer.BiosDue;
+		if(chain)
+		{
+			Timer.BiosDue += Timer.BiosPeriod;
+		}
+	}
+	else
+	{
+		Timer.Elapsed += Timer.Count;
+		chain = Timer.Elapsed >= PIT_BIOS_COUNT;
+		if(chain)
+		{
+			Timer.Elapsed -= PIT_BIOS_COUNT;
+		}
+	}
+	if(chain)
+	{
+		/* The BIOS handler acknowledges the interrupt itself */
+		asm volatile ("pushfl\n\tlcall *%0" : : "m" (Timer.Chain) : "memory");
+	}
+	else
+	{
+		outportb(PIC1_COMMAND, PIC_EOI);
+	}
+	if(Timer.Running)
+	{
+		return;
+	}
+	Timer.Running = TRUE;
+	asm volatile ("sti" : : : "memory");
+	for(index = 0; index < TMR_CALLBACKS; index ++)
+	{
+		TMRslot *slot = &Timer.Slots[ index ];
+		if(!slot->Callback || !slot->Armed || now < slot->Due)
+		{
+			continue;
+		}
+		if(slot->Period)
+		{
+			slot->Due += slot->Period;
+			/* Skip runs missed rather than firing them all at once */
+			if(slot->Due <= now)
+			{
+				slot->Due = now + slot->Period;
+			}
+		}
+		else
+		{
+			slot->Armed = FALSE;
+		}
+		slot->Callback(slot->Data);
+		rdtsc(now);
+	}
+	asm volatile ("cli" : : : "memory");
+	Timer.Running = FALSE;
+}
+
+static void tmrInterruptEnd(void)
+{
+}
+
+/*
+ * tmrProgram
+ *
+ *	Sets channel 0 to interrupt every 'count' PIT counts, 0 for 65536.
+ */
+
+static void tmrProgram(unsigned long count)
+{
+	outportb(PIT_COMMAND, PIT_CHANNEL0_BIT | PIT_LOW_HIGH_BIT | PIT_MODE_2_BIT);
+	outportb(PIT_CHANNEL0, count & 0xFF);
+	outportb(PIT_CHANNEL0, (count >> 8) & 0xFF);
+}
+
+/*******************************************************************************
+ *
+ *	Timer functions
+ *
+ ******************************************************************************/
+
+/*
+ * tmrInstall
+ *
+ *	Takes over the timer interrupt and calibrates the time stamp counter
+ *	against it, which takes TMR_CALIBRATION_TICKS ticks.
+ *
+ *	long rate
+ *		Interrupts per second, 0 for the default. At least 19.
+ *	returns
+ *		True if the timer is running.
+ */
+
+BOOL tmrInstall(long rate)
+{
+	unsigned long long start, end;
+	unsigned long tick;
+	if(Installed)
+	{
+		return TRUE;
+	}
+	if(rate <= 0)
+	{
+		rate = TMR_DEFAULT_RATE;
+	}
+	Timer.Count = PIT_FREQUENCY / rate;
+	if(Timer.Count < 1 || Timer.Count >= PIT_BIOS_COUNT)
+	{
+		return FALSE;
+	}
+	Timer.Elapsed    = 0;
+	Timer.Ticks      = 0;
+	Timer.BiosPeriod = 0;
+	Timer.Running    = FALSE;
+	memset(Timer.Slots, 0, sizeof(Timer.Slots));
+	_go32_dpmi_lock_data(&Timer, sizeof(Timer));
+	/* Read by 'tmrMicroseconds' */
+	_go32_dpmi_lock_data(&Installed, sizeof(Installed));
+	_go32_dpmi_lock_data(&Frequency, sizeof(Frequency));
+	_go32_dpmi_lock_data(&Base, sizeof(Base));
+	_go32_dpmi_lock_code(tmrRearm, (unsigned long)tmrInterruptEnd - (unsigned long)tmrRearm);
+	_go32_dpmi_get_protected_mode_interrupt_vector(PIT_TIMER_INTERRUPT, &OldHandler);
+	Timer.Chain.Offset   = OldHandler.pm_offset;
+	Timer.Chain.Selector = OldHandler.pm_selector;
+	NewHandler.pm_offset   = (unsigned long)tmrInterrupt;
+	NewHandler.pm_selector = _go32_my_cs();
+	if(_go32_dpmi_allocate_iret_wrapper(&NewHandler))
+	{
+		return FALSE;
+	}
+	/* The first call to 'uclock' sets the PIT to the BIOS rate, so make it now */
+	uclock();
+	disable();
+	_go32_dpmi_set_protected_mode_interrupt_vector(PIT_TIMER_INTERRUPT, &NewHandler);
+	tmrProgram(Timer.Count);
+	enable();
+	Installed = TRUE;
+	/* Time the counter from one tick edge to another */
+	tick = Timer.Ticks;
+	while(Timer.Ticks == tick);
+	rdtsc(start);
+	tick = Timer.Ticks;
+	while(Timer.Ticks - tick < TMR_CALIBRATION_TICKS);
+	rdtsc(end);
+	Frequency   = (end - start) * PIT_FREQUENCY / ((unsigned long long)TMR_CALIBRATION_TICKS * Timer.Count);
+	Timer.Scale = (Frequency << 16) / 1000000;
+	Base        = start;
+	/* From here the BIOS ticks are timed by the counter */
+	disable();
+	rdtsc(end);
+	Timer.BiosDue    = end + (PIT_BIOS_COUNT - Timer.Elapsed) * Frequency / PIT_FREQUENCY;
+	Timer.BiosPeriod = PIT_BIOS_COUNT * Frequency / PIT_FREQUENCY;
+	enable();
+	return TRUE;
+}
+
+/*
+ * tmrRemove
+ *
+ *	Gives the timer interrupt back and cancels every callback. Channel 0 is
+ *	left in the rate generator mode 'uclock' uses, at the 18.2 Hz BIOS rate.
+ */
+
+void tmrRemove()
+{
+	if(!Installed)
+	{
+		return;
+	}
+	disable();
+	_go32_dpmi_set_protected_mode_interrupt_vector(PIT_TIMER_INTERRUPT, &OldHandler);
+	tmrProgram(0);
+	enable();
+	_go32_dpmi_free_iret_wrapper(&NewHandler);
+	memset(Timer.Slots, 0, sizeof(Timer.Slots));
+	Installed = FALSE;
+}
+
+/*
+ * tmrInstalled
+ */
+
+BOOL tmrInstalled()
+{
+	return Installed;
+}
+
+/*
+ * tmrResolution
+ *
+ *	returns
+ *		Microseconds between interrupts, the finest a callback can be timed.
+ */
+
+long tmrResolution()
+{
+	return (long)((unsigned long long)Timer.Count * 1000000 / PIT_FREQUENCY);
+}
+
+/*
+ * tmrAddCallback
+ *
+ *	Fills a free slot. The callback is stored last since the handler may
+ *	look at the slot at any time.
+ */
+
+static int tmrAddCallback(long delay, long period, TMRcallback callback, void *data)
+{
+	int index;
+	if(!Installed || !callback)
+	{
+		return -1;
+	}
+	for(index = 0; index < TMR_CALLBACKS; index ++)
+	{
+		TMRslot *slot = &Timer.Slots[ index ];
+		if(!slot->Callback)
+		{
+			slot->Data   = data;
+			slot->Period = ((unsigned long long)period * Timer.Scale) >> 16;
+			tmrRearm(index, delay);
+			slot->Callback = callback;
+			return index;
+		}
+	}
+	return -1;
+}
+
+/*
+ * tmrAddDeadline
+ *
+ *	Runs a callback once after a delay. The slot is kept until cancelled,
+ *	so 'tmrRearm' can run it again.
+ *
+ *	long delay
+ *		Microseconds from now.
+ *	TMRcallback callback
+ *		Function to call, locked along with everything it uses.
+ *	void * data
+ *		Passed to the callback.
+ *	returns
+ *		Handle for 'tmrRearm' and 'tmrCancel', or -1 if none is free.
+ */
+
+int tmrAddDeadline(long delay, TMRcallback callback, void *data)
+{
+	return tmrAddCallback(delay, 0, callback, data);
+}
+
+/*
+ * tmrAddPeriodic
+ *
+ *	Runs a callback every period, starting one period from now.
+ *
+ *	long period
+ *		Microseconds between runs.
+ *	TMRcallback callback
+ *		Function to call, locked along with everything it uses.
+ *	void * data
+ *		Passed to the callback.
+ *	returns
+ *		Handle for 'tmrCancel', or -1 if none is free.
+ */
+
+int tmrAddPeriodic(long period, TMRcallback callback, void *data)
+{
+	if(period <= 0)
+	{
+		return -1;
+	}
+	return tmrAddCallback(period, period, callback, data);
+}
+
+/*
+ * tmrCancel
+ *
+ *	int handle
+ *		As returned by 'tmrAddDeadline' or 'tmrAddPeriodic'.
+ */
+
+void tmrCancel(int handle)
+{
+	if(handle >= 0 && handle < TMR_CALLBACKS)
+	{
+		Timer.Slots[ handle ].Callback = NULL;
+		Timer.Slots[ handle ].Armed    = FALSE;
+	}
+}
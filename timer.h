@@ -0,0 +1,70 @@
+/*******************************************************************************
+ *
+ *	Timer library
+ *
+ *	Runs channel 0 of the PIT faster than the 18.2 Hz BIOS tick, still
+ *	passing the BIOS handler every 65536 counts so the time of day keeps
+ *	right. The time stamp counter is calibrated against the timer to give
+ *	monotonic microsecond timestamps, and callbacks can be run once after a
+ *	delay or periodically, to the resolution of the timer.
+ *
+ *	Callbacks run inside the timer interrupt, after it is acknowledged and
+ *	with interrupts enabled, and are never reentered. Their code and any
+ *	data they touch must be locked.
+ *
+ *	While the timer is installed the PIT does not run at the count 'uclock'
+ *	expects. 'uclock' then only keeps the 55 ms BIOS tick, and within a tick
+ *	its reading can step back by up to one timer period, so timing should
+ *	go through 'tmrMicroseconds' instead. Installing makes the first call
+ *	to 'uclock', which would otherwise set the PIT back to the BIOS rate.
+ */
+
+#ifndef timer_h
+#define timer_h
+
+#include "VGA.h"
+
+/*******************************************************************************
+ *
+ *	Timer flags
+ *
+ ******************************************************************************/
+
+#define TMR_DEFAULT_RATE			1000	/* Interrupts per second */
+#define TMR_CALLBACKS				16	/* Callback slots */
+#define TMR_CALIBRATION_TICKS			50	/* Ticks timed against the time stamp counter */
+
+/*******************************************************************************
+ *
+ *	Timer structures
+ *
+ ******************************************************************************/
+
+typedef void (*TMRcallback)(void *data);
+
+/*******************************************************************************
+ *
+ *	Timer functions
+ *
+ ******************************************************************************/
+
+BOOL tmrInstall(long rate);
+
+void tmrRemove();
+
+BOOL tmrInstalled();
+
+long tmrResolution();
+
+unsigned long long tmrMicroseconds();
+
+int tmrAddDeadline(long delay, TMRcallback callback, void *data);
+
+int tmrAddPeriodic(long period, TMRcallback callback, void *data);
+
+void tmrRearm(int handle, long delay);
+
+void tmrCancel(int handle);
+
+
+#endif /* timer_h */